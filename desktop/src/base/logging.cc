@@ -96,6 +96,7 @@ typedef FILE* FileHandle;
 #endif
 
 #include <algorithm>
+#include <atomic> //netboxcomment
 #include <cstring>
 #include <ctime>
 #include <iomanip>
@@ -122,6 +123,7 @@ typedef FILE* FileHandle;
 #include "base/strings/sys_string_conversions.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/synchronization/lock.h"
+#include "base/synchronization/waitable_event.h" //netboxcomment
 #include "base/test/scoped_logging_settings.h"
 #include "base/threading/platform_thread.h"
 #include "base/vlog.h"
@@ -377,6 +379,248 @@ void CloseLogFileUnlocked() {
     g_logging_destination &= ~LOG_TO_FILE;
 }
 
+//netboxcomment begin
+// Log lines queued by any thread and written to the log file by one
+// background thread. The queue is a bounded lock-free ring, producers only
+// claim a slot with a CAS, a line is dropped rather than blocking when the
+// writer falls behind.
+class AsyncLogWriter : public base::PlatformThread::Delegate {
+ public:
+  AsyncLogWriter(const PathString& file_name,
+                 size_t max_file_size,
+                 LogFileFilterFunction filter)
+      : file_name_(file_name),
+        max_file_size_(max_file_size),
+        filter_(filter),
+        wake_event_(base::WaitableEvent::ResetPolicy::AUTOMATIC,
+                    base::WaitableEvent::InitialState::NOT_SIGNALED),
+        rotate_at_size_(max_file_size) {
+    for (size_t i = 0; i < kCapacity; ++i)
+      slots_[i].sequence.store(i, std::memory_order_relaxed);
+  }
+
+  AsyncLogWriter(const AsyncLogWriter&) = delete;
+  AsyncLogWriter& operator=(const AsyncLogWriter&) = delete;
+
+  // Never deleted, a logging thread may still hold the pointer.
+  ~AsyncLogWriter() override = default;
+
+  // Not joinable, so nothing blocks on the writer at shutdown.
+  bool Start() { return base::PlatformThread::CreateNonJoinable(0, this); }
+
+  void Stop() {
+    stopping_.store(true, std::memory_order_release);
+    wake_event_.Signal();
+
+    base::AutoLock lock(consumer_lock_);
+    FlushLocked();
+    CloseFile();
+  }
+
+  void Enqueue(std::string line, bool urgent) {
+    size_t pos = enqueue_pos_.load(std::memory_order_relaxed);
+    Slot* slot;
+    for (;;) {
+      slot = &slots_[pos & kMask];
+      size_t sequence = slot->sequence.load(std::memory_order_acquire);
+      intptr_t diff =
+          static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos);
+      if (diff == 0) {
+        if (enqueue_pos_.compare_exchange_weak(pos, pos + 1,
+                                               std::memory_order_relaxed)) {
+          break;
+        }
+      } else if (diff < 0) {
+        dropped_.fetch_add(1, std::memory_order_relaxed);
+        return;
+      } else {
+        pos = enqueue_pos_.load(std::memory_order_relaxed);
+      }
+    }
+
+    slot->line = std::move(line);
+    slot->sequence.store(pos + 1, std::memory_order_release);
+
+    // The writer wakes up by itself, only errors and a filling queue are
+    // worth a kernel call on the logging thread.
+    if (urgent || pos - dequeue_pos_.load(std::memory_order_relaxed) >
+                      kCapacity / 2) {
+      wake_event_.Signal();
+    }
+  }
+
+  // Writes everything queued so far on the calling thread.
+  void Flush() {
+    base::AutoLock lock(consumer_lock_);
+    FlushLocked();
+  }
+
+  // The writer thread may be the one crashing, it must not deadlock then.
+  void FlushForCrash() {
+    if (!consumer_lock_.Try())
+      return;
+    FlushLocked();
+    consumer_lock_.Release();
+  }
+
+  // base::PlatformThread::Delegate:
+  void ThreadMain() override {
+    base::PlatformThread::SetName("NetboxLogWriter");
+
+    while (!stopping_.load(std::memory_order_acquire)) {
+      wake_event_.TimedWait(base::TimeDelta::FromMilliseconds(kWriteDelayMs));
+      Flush();
+    }
+  }
+
+ private:
+  static constexpr size_t kCapacity = 8192;
+  static constexpr size_t kMask = kCapacity - 1;
+  static constexpr size_t kBatchSize = 64 * 1024;
+  static constexpr int kWriteDelayMs = 200;
+
+  struct Slot {
+    std::atomic<size_t> sequence;
+    std::string line;
+  };
+
+  bool Dequeue(std::string* line) {
+    size_t pos = dequeue_pos_.load(std::memory_order_relaxed);
+    Slot& slot = slots_[pos & kMask];
+    size_t sequence = slot.sequence.load(std::memory_order_acquire);
+    if (static_cast<intptr_t>(sequence) - static_cast<intptr_t>(pos + 1) < 0)
+      return false;
+
+    *line = std::move(slot.line);
+    slot.line.clear();
+    slot.sequence.store(pos + kCapacity, std::memory_order_release);
+    dequeue_pos_.store(pos + 1, std::memory_order_relaxed);
+    return true;
+  }
+
+  void FlushLocked() {
+    std::string batch;
+    std::string line;
+    while (Dequeue(&line)) {
+      // Redaction is done here, not on the thread which logged.
+      if (filter_)
+        line = filter_(line);
+      batch.append(line);
+
+      if (batch.size() >= kBatchSize) {
+        WriteBatch(batch);
+        batch.clear();
+      }
+    }
+
+    size_t dropped = dropped_.exchange(0, std::memory_order_relaxed);
+    if (dropped) {
+      batch.append(base::StringPrintf(
+          "[log writer: %zu lines dropped, queue was full]\n", dropped));
+    }
+
+    if (!batch.empty())
+      WriteBatch(batch);
+  }
+
+  bool OpenFile() {
+    if (file_)
+      return true;
+
+#if defined(OS_WIN)
+    file_ = CreateFile(file_name_.c_str(), FILE_APPEND_DATA,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       nullptr, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, nullptr);
+    if (file_ == INVALID_HANDLE_VALUE || file_ == nullptr) {
+      file_ = nullptr;
+      return false;
+    }
+
+    LARGE_INTEGER size;
+    file_size_ = GetFileSizeEx(file_, &size) ? size.QuadPart : 0;
+#elif defined(OS_POSIX) || defined(OS_FUCHSIA)
+    file_ = fopen(file_name_.c_str(), "a");
+    if (file_ == nullptr)
+      return false;
+
+    fseek(file_, 0, SEEK_END);
+    long size = ftell(file_);
+    file_size_ = size > 0 ? size : 0;
+#endif
+    return true;
+  }
+
+  void CloseFile() {
+    if (!file_)
+      return;
+
+    logging::CloseFile(file_);
+    file_ = nullptr;
+  }
+
+  // The previous log is kept as <name>.1, so at most two files of
+  // |max_file_size_| are on disk.
+  void Rotate() {
+    CloseFile();
+
+    PathString rotated_name = file_name_ + FILE_PATH_LITERAL(".1");
+#if defined(OS_WIN)
+    bool rotated = !!MoveFileEx(file_name_.c_str(), rotated_name.c_str(),
+                                MOVEFILE_REPLACE_EXISTING);
+#elif defined(OS_POSIX) || defined(OS_FUCHSIA)
+    bool rotated = rename(file_name_.c_str(), rotated_name.c_str()) == 0;
+#endif
+
+    // Another process may keep the file open, the next try is one more
+    // |max_file_size_| later then.
+    rotate_at_size_ = rotated ? max_file_size_ : file_size_ + max_file_size_;
+  }
+
+  void WriteBatch(const std::string& batch) {
+    if (!OpenFile())
+      return;
+
+    // A batch larger than the limit goes to the empty file, it is not
+    // rotated away on its own.
+    if (file_size_ > 0 && file_size_ + batch.size() > rotate_at_size_) {
+      Rotate();
+      if (!OpenFile())
+        return;
+    }
+
+#if defined(OS_WIN)
+    DWORD num_written;
+    WriteFile(file_, static_cast<const void*>(batch.data()),
+              static_cast<DWORD>(batch.size()), &num_written, nullptr);
+#elif defined(OS_POSIX) || defined(OS_FUCHSIA)
+    ignore_result(fwrite(batch.data(), batch.size(), 1, file_));
+    fflush(file_);
+#endif
+    file_size_ += batch.size();
+  }
+
+  const PathString file_name_;
+  const size_t max_file_size_;
+  const LogFileFilterFunction filter_;
+
+  Slot slots_[kCapacity];
+  std::atomic<size_t> enqueue_pos_{0};
+  std::atomic<size_t> dequeue_pos_{0};
+  std::atomic<size_t> dropped_{0};
+  std::atomic<bool> stopping_{false};
+
+  base::WaitableEvent wake_event_;
+
+  // Held by whoever drains the queue, the writer thread or a flush.
+  base::Lock consumer_lock_;
+  FileHandle file_ = nullptr;
+  uint64_t file_size_ = 0;
+  uint64_t rotate_at_size_;
+};
+
+std::atomic<AsyncLogWriter*> g_async_log_writer{nullptr};
+//netboxcomment end
+
 #if defined(OS_FUCHSIA)
 
 inline fx_log_severity_t LogSeverityToFuchsiaLogSeverity(LogSeverity severity) {
@@ -851,7 +1095,19 @@ LogMessage::~LogMessage() {
     fflush(stderr);
   }
 
-  if ((g_logging_destination & LOG_TO_FILE) != 0) {
+  //netboxcomment begin
+  AsyncLogWriter* async_log_writer =
+      (g_logging_destination & LOG_TO_FILE) != 0
+          ? g_async_log_writer.load(std::memory_order_acquire)
+          : nullptr;
+  if (async_log_writer && severity_ != LOGGING_FATAL) {
+    async_log_writer->Enqueue(std::move(str_newline),
+                              severity_ >= LOGGING_ERROR);
+  } else if ((g_logging_destination & LOG_TO_FILE) != 0) {
+    // Queued lines go first, the fatal one is written synchronously below.
+    if (async_log_writer)
+      async_log_writer->FlushForCrash();
+  //netboxcomment end
     // We can have multiple threads and/or processes, so try to prevent them
     // from clobbering each other's writes.
     // If the client app did not call InitLogging, and the lock has not
@@ -1068,6 +1324,46 @@ void CloseLogFile() {
   CloseLogFileUnlocked();
 }
 
+//netboxcomment begin
+void EnableAsyncLogFile(size_t max_file_size, LogFileFilterFunction filter) {
+  if (g_async_log_writer.load(std::memory_order_acquire))
+    return;
+
+  PathString file_name;
+  {
+#if defined(OS_POSIX) || defined(OS_FUCHSIA)
+    base::AutoLock guard(GetLoggingLock());
+#endif
+    // An externally provided handle without a name can't be rotated.
+    if ((g_logging_destination & LOG_TO_FILE) == 0 || !g_log_file_name)
+      return;
+
+    file_name = *g_log_file_name;
+
+    // The writer owns the file from now on, the rotation can't rename it
+    // while another handle of this process is open.
+    CloseLogFileUnlocked();
+  }
+
+  // Leaked on purpose, see ~AsyncLogWriter().
+  AsyncLogWriter* async_log_writer =
+      new AsyncLogWriter(file_name, max_file_size, filter);
+  if (!async_log_writer->Start()) {
+    delete async_log_writer;
+    return;
+  }
+
+  g_async_log_writer.store(async_log_writer, std::memory_order_release);
+}
+
+void DisableAsyncLogFile() {
+  AsyncLogWriter* async_log_writer =
+      g_async_log_writer.exchange(nullptr, std::memory_order_acq_rel);
+  if (async_log_writer)
+    async_log_writer->Stop();
+}
+//netboxcomment end
+
 #if BUILDFLAG(IS_CHROMEOS_ASH)
 FILE* DuplicateLogFILE() {
   if ((g_logging_destination & LOG_TO_FILE) == 0 || !InitializeLogFileHandle())
@@ -692,6 +692,22 @@ class BASE_EXPORT ErrnoLogMessage : public LogMessage {
 //       after this call.
 BASE_EXPORT void CloseLogFile();
 
+//netboxcomment begin
+// Applied to every line by the async log writer before it is written.
+using LogFileFilterFunction = std::string (*)(const std::string& line);
+
+// Moves log file writes to a background thread. Logging threads only queue the
+// line, lines are dropped rather than blocking when the queue is full. The file
+// is renamed to <name>.1 once it grows over |max_file_size|. A fatal message
+// flushes the queue before it is written.
+BASE_EXPORT void EnableAsyncLogFile(size_t max_file_size,
+                                    LogFileFilterFunction filter);
+
+// Writes the queued lines and stops the writer thread, the following lines are
+// written synchronously again.
+BASE_EXPORT void DisableAsyncLogFile();
+//netboxcomment end
+
 #if BUILDFLAG(IS_CHROMEOS_ASH)
 // Returns a new file handle that will write to the same destination as the
 // currently open log file. Returns nullptr if logging to a file is disabled,
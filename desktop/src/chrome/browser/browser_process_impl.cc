@@ -202,13 +202,20 @@
 #include "chrome/browser/browser_update/browser_update.h"
 #include "chrome/browser/ui/browser.h"
 #include "chrome/browser/ui/browser_list.h"
+#include "chrome/browser/netbox/news/news_cache.h"
 #include "chrome/browser/netbox/wallet_manager/wallet_manager.h"
 #include "chrome/browser/transaction_service/transaction_service.h"
 #include "chrome/browser/netbox/activity/activity_watcher.h"
 #include "chrome/browser/netbox/environment/controller/wallet_environment.h"
 #include "chrome/browser/netbox/environment/launch/wallet_launch.h"
+#include "components/netboxglobal_utils/utils.h"
 #include "ui/views/frame/browser_view.h"
 #include "ui/views/toolbar/toolbar_view.h"
+
+// the debug log is written by a background thread when the browser runs with it
+static const char NETBOX_ASYNC_LOG_SWITCH[] = "netbox-async-log";
+
+static const size_t NETBOX_LOG_MAX_FILE_SIZE = 20 * 1024 * 1024;
 // netboxcomment end
 
 #if defined(OS_WIN) || defined(OS_MAC) || defined(OS_LINUX) || BUILDFLAG(IS_CHROMEOS_LACROS) // netboxcomment
@@ -241,6 +248,11 @@ BrowserProcessImpl::BrowserProcessImpl(StartupData* startup_data)
   DCHECK(startup_data);
 
   //netboxcomment begin
+  if (base::CommandLine::ForCurrentProcess()->HasSwitch(NETBOX_ASYNC_LOG_SWITCH))
+  {
+      logging::EnableAsyncLogFile(NETBOX_LOG_MAX_FILE_SIZE, &Netboxglobal::filter_confidentional_data);
+  }
+
   transaction_service_ = std::make_unique<Netboxglobal::TransactionService>();
   wallet_manager_ = std::make_unique<Netboxglobal::WalletManager>();
   env_controller_ = std::make_unique<Netboxglobal::WalletSessionManager>();
@@ -375,6 +387,8 @@ BrowserProcessImpl::~BrowserProcessImpl() {
   wallet_manager_.reset();
   env_controller_.reset();
   transaction_service_.reset();  
+
+  logging::DisableAsyncLogFile();
   //netboxglobal end
 
   g_browser_process = NULL;
@@ -392,6 +406,7 @@ void BrowserProcessImpl::StartTearDown() {
   env_controller_->stop();
   wallet_manager_->stop();
   transaction_service_->ui_stop();
+  Netboxglobal::NewsCache::GetInstance()->stop();
   // netboxcomment end
 
   platform_part()->BeginStartTearDown();
@@ -1057,8 +1072,10 @@ void BrowserProcessImpl::StartWalletModules(base::FilePath profile_path)
     wallet_manager_->add_first_address_observer(std::bind(&Netboxglobal::Monitoring::ActivityWatcher::on_first_address, Netboxglobal::Monitoring::ActivityWatcher::get_instance(), std::placeholders::_1));
     wallet_manager_->add_first_address_observer(std::bind(&Netboxglobal::TransactionService::ui_set_first_address, transaction_service_.get(), std::placeholders::_1));
 
-    wallet_manager_->start();
+    wallet_manager_->start(profile_path);
     env_controller_->start();
+
+    Netboxglobal::NewsCache::GetInstance()->start(profile_path);
 }
 
 void BrowserProcessImpl::ShowUpdateInfobar()
@@ -0,0 +1,289 @@
+#include <string.h>
+
+#include <memory>
+#include <regex>
+#include <string>
+#include <vector>
+
+#include "base/files/file_path.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_split.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/waitable_event.h"
+#include "base/threading/simple_thread.h"
+#include "components/netboxglobal_utils/utils.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+static const char PRODUCER_MARKER[] = "async log producer";
+static const char DROPPED_MARKER[] = "[log writer: ";
+
+// the writer thread stops in the filter of the first line until the test lets it go
+static base::WaitableEvent* g_filter_entered = nullptr;
+static base::WaitableEvent* g_filter_released = nullptr;
+
+static std::string blocking_filter(const std::string& line)
+{
+    if (g_filter_released && !g_filter_released->IsSignaled())
+    {
+        g_filter_entered->Signal();
+        g_filter_released->Wait();
+    }
+
+    return line;
+}
+
+class LogProducer : public base::DelegateSimpleThread::Delegate
+{
+public:
+    LogProducer(int index, int lines_count) : index_(index), lines_count_(lines_count) {}
+
+    void Run() override
+    {
+        for (int i = 0; i < lines_count_; ++i)
+        {
+            LOG(WARNING) << PRODUCER_MARKER << " " << index_ << " " << i;
+        }
+    }
+
+private:
+    int index_;
+    int lines_count_;
+};
+
+class NetboxAsyncLogFileTest : public ::testing::Test {
+public:
+    NetboxAsyncLogFileTest() = default;
+    ~NetboxAsyncLogFileTest() override = default;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+        log_path_ = temp_dir_.GetPath().Append(FILE_PATH_LITERAL("netbox_debug.log"));
+
+        logging::LoggingSettings settings;
+        settings.logging_dest   = logging::LOG_TO_FILE;
+        settings.log_file_path  = log_path_.value().c_str();
+        settings.delete_old     = logging::DELETE_OLD_LOG_FILE;
+        ASSERT_TRUE(logging::InitLogging(settings));
+    }
+
+    void TearDown() override
+    {
+        // a failed check must not leave the writer waiting in the filter
+        filter_released_.Signal();
+
+        logging::DisableAsyncLogFile();
+        logging::CloseLogFile();
+
+        logging::LoggingSettings settings;
+        settings.logging_dest = logging::LOG_TO_SYSTEM_DEBUG_LOG | logging::LOG_TO_STDERR;
+        logging::InitLogging(settings);
+
+        g_filter_entered = nullptr;
+        g_filter_released = nullptr;
+    }
+
+    std::vector<std::string> read_lines(const base::FilePath& path)
+    {
+        std::string contents;
+        base::ReadFileToString(path, &contents);
+
+        return base::SplitString(contents, "\n", base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+    }
+
+    bool contains(const base::FilePath& path, const std::string& text)
+    {
+        std::string contents;
+        base::ReadFileToString(path, &contents);
+
+        return contents.find(text) != std::string::npos;
+    }
+
+protected:
+    base::ScopedTempDir temp_dir_;
+    base::FilePath log_path_;
+    base::WaitableEvent filter_entered_;
+    base::WaitableEvent filter_released_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxAsyncLogFileTest);
+};
+
+TEST_F(NetboxAsyncLogFileTest, ConcurrentProducers)
+{
+    const int producers_count = 4;
+    const int lines_count = 5000;
+
+    g_filter_entered = &filter_entered_;
+    g_filter_released = &filter_released_;
+
+    logging::EnableAsyncLogFile(100 * 1024 * 1024, &blocking_filter);
+
+    // an error wakes the writer at once, it holds the first line while the ring fills up
+    LOG(ERROR) << "async log first line";
+    filter_entered_.Wait();
+
+    std::vector<std::unique_ptr<LogProducer>> producers;
+    std::vector<std::unique_ptr<base::DelegateSimpleThread>> threads;
+    for (int i = 0; i < producers_count; ++i)
+    {
+        producers.push_back(std::make_unique<LogProducer>(i, lines_count));
+        threads.push_back(std::make_unique<base::DelegateSimpleThread>(producers.back().get(), base::StringPrintf("LogProducer%d", i)));
+    }
+
+    for (auto& thread : threads)
+    {
+        thread->Start();
+    }
+
+    for (auto& thread : threads)
+    {
+        thread->Join();
+    }
+
+    filter_released_.Signal();
+
+    // drains the ring and closes the file
+    logging::DisableAsyncLogFile();
+
+    int written = 0;
+    int dropped = 0;
+    std::vector<int> last_line(producers_count, -1);
+
+    for (const std::string& line : read_lines(log_path_))
+    {
+        size_t dropped_pos = line.find(DROPPED_MARKER);
+        if (dropped_pos != std::string::npos)
+        {
+            std::vector<std::string> words = base::SplitString(line.substr(dropped_pos + strlen(DROPPED_MARKER)), " ",
+                                                               base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+            int count = 0;
+            ASSERT_TRUE(!words.empty() && base::StringToInt(words[0], &count)) << line;
+            dropped = dropped + count;
+            continue;
+        }
+
+        size_t marker_pos = line.find(PRODUCER_MARKER);
+        if (marker_pos == std::string::npos)
+        {
+            continue;
+        }
+
+        std::vector<std::string> words = base::SplitString(line.substr(marker_pos + strlen(PRODUCER_MARKER)), " ",
+                                                           base::TRIM_WHITESPACE, base::SPLIT_WANT_NONEMPTY);
+        int producer = 0;
+        int index = 0;
+        ASSERT_EQ(2u, words.size()) << line;
+        ASSERT_TRUE(base::StringToInt(words[0], &producer) && base::StringToInt(words[1], &index)) << line;
+
+        // lines of one thread keep their order, some may be missing
+        ASSERT_GT(index, last_line[producer]);
+        last_line[producer] = index;
+
+        written++;
+    }
+
+    // the ring holds 8192 lines, the rest is dropped and counted
+    ASSERT_EQ(producers_count * lines_count, written + dropped);
+    ASSERT_GT(dropped, 0);
+    ASSERT_GT(written, 0);
+}
+
+TEST_F(NetboxAsyncLogFileTest, FilteredLines)
+{
+    logging::EnableAsyncLogFile(100 * 1024 * 1024, &filter_confidentional_data);
+
+    LOG(WARNING) << "{\"hdseed\":\"secret1\"}";
+    LOG(WARNING) << "{\"method\":\"walletpassphrase\",\"params\":[\"secret2\",60]}";
+
+    logging::DisableAsyncLogFile();
+
+    ASSERT_TRUE(contains(log_path_, "{\"hdseed\":\"***\"}"));
+    ASSERT_TRUE(contains(log_path_, "\"walletpassphrase\",\"params\":***}"));
+    ASSERT_FALSE(contains(log_path_, "secret"));
+}
+
+TEST_F(NetboxAsyncLogFileTest, Rotation)
+{
+    const size_t max_file_size = 4096;
+    base::FilePath rotated_path(log_path_.value() + FILE_PATH_LITERAL(".1"));
+
+    // every round writes more than the limit, so the file is renamed at least once
+    for (int round = 1; round <= 3; ++round)
+    {
+        logging::EnableAsyncLogFile(max_file_size, nullptr);
+
+        for (int i = 0; i < 50; ++i)
+        {
+            LOG(WARNING) << "async log round " << round << " line " << i << " " << std::string(60, 'x');
+        }
+
+        logging::DisableAsyncLogFile();
+    }
+
+    ASSERT_TRUE(base::PathExists(rotated_path));
+
+    // two files at most, the first round is gone
+    ASSERT_FALSE(contains(log_path_, "async log round 1 "));
+    ASSERT_FALSE(contains(rotated_path, "async log round 1 "));
+    ASSERT_TRUE(contains(log_path_, "async log round 3 line 49 "));
+
+    int64_t log_size = 0;
+    ASSERT_TRUE(base::GetFileSize(log_path_, &log_size));
+    ASSERT_GT(log_size, 0);
+}
+
+// the patterns the filter replaced, kept as the reference
+static std::string regex_filter(const std::string& line)
+{
+    std::regex rgx1("\"(hdseed|hdseedid|password|xpub)\":\\s*\"([a-z0-9]+)\"", std::regex_constants::icase);
+    std::string str1 = std::regex_replace(line, rgx1, "\"$1\":\"***\"");
+
+    std::regex rgx2("\"(sethdseed|encryptwallet|walletpassphrase)\",\"params\":\\[.*\\]", std::regex_constants::icase);
+    std::string str2 = std::regex_replace(str1, rgx2, "\"$1\",\"params\":***");
+
+    std::regex rgx3("\\{\"result\":\".*\",\"error\":null,\"id\":null\\}", std::regex_constants::icase);
+    return std::regex_replace(str2, rgx3, "{\"result\":\"***\",\"error\":null,\"id\":null}");
+}
+
+TEST(NetboxLogFilterTest, SameAsRegex)
+{
+    const char* const lines[] =
+    {
+        "{\"hdseed\": \"abc123\", \"x\":1}",
+        "{\"HDSeedId\":\"ABC\",\"password\":\"\"}",
+        "{\"xpub\":\"ab-c\"} \"password\":  \"p1\"",
+        "\"hdseedid\":\"aa\" \"hdseed\":\"bb\"",
+        "\"password\":\"\"x\"",
+        "{\"method\":\"sethdseed\",\"params\":[true,\"seed\"],\"id\":1} tail ] more",
+        "{\"method\":\"walletpassphrase\",\"params\":[\"pw\",60]}\nnext ] line",
+        "\"encryptwallet\",\"params\":[\nno close",
+        "{\"result\":\"xprv123\",\"error\":null,\"id\":null}",
+        "a {\"result\":\"x\",\"error\":null,\"id\":null} b {\"result\":\"y\",\"error\":null,\"id\":null} c",
+        "{\"result\":\"x\"\n,\"error\":null,\"id\":null}",
+        "{\"result\":\"a\",\"error\":null,\"id\":null} \"sethdseed\",\"params\":[1]",
+        "\"sethdseed\",\"params\":[{\"result\":\"a\",\"error\":null,\"id\":null}]",
+        "no quotes at all",
+    };
+
+    for (const char* line : lines)
+    {
+        ASSERT_EQ(regex_filter(line), filter_confidentional_data(line)) << line;
+    }
+}
+
+TEST(NetboxLogFilterTest, LongLine)
+{
+    // an rpc dump of a large wallet in one line
+    std::string line = "{\"result\":\"" + std::string(4 * 1024 * 1024, 'x') + "\",\"error\":null,\"id\":null}";
+
+    ASSERT_EQ("{\"result\":\"***\",\"error\":null,\"id\":null}", filter_confidentional_data(line));
+}
+
+}
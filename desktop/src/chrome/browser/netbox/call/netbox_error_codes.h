@@ -15,6 +15,7 @@
 #define WR_ERROR_DECRYPTION_FAILED 614
 #define WR_ERROR_LOCAL_FUNCTION_ERROR 615
 #define WR_ERROR_RESPONSE_NOT_JSON 616
+#define WR_ERROR_TIMEOUT 617
 #define WR_ERROR_RESPONSE_FALSE_RESULT 608
 
 #endif
\ No newline at end of file
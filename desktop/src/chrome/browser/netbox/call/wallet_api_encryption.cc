@@ -0,0 +1,108 @@
+#include "chrome/browser/netbox/call/wallet_api_encryption.h"
+
+#include <atomic>
+#include <memory>
+#include <vector>
+
+#include "base/base64.h"
+#include "base/containers/span.h"
+#include "base/logging.h"
+#include "base/no_destructor.h"
+#include "components/netboxglobal_utils/utils.h"
+#include "components/netboxglobal_verify/decode_public_key.h"
+#include "crypto/rsa_encrypt.h"
+#include "net/base/mime_util.h"
+
+namespace Netboxglobal
+{
+
+static std::atomic<int32_t> api_encryption_version(WalletApiEncryption::RSA_BLOCKS);
+
+void set_api_encryption_version(int32_t version)
+{
+    // unknown versions fall back to what every server understands
+    if (WalletApiEncryption::HYBRID_AES_GCM != version)
+    {
+        version = WalletApiEncryption::RSA_BLOCKS;
+    }
+
+    if (api_encryption_version.exchange(version) != version)
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "api encryption version " << version;
+    }
+}
+
+WalletApiEncryption get_api_encryption_version()
+{
+    return static_cast<WalletApiEncryption>(api_encryption_version.load());
+}
+
+const crypto::RSAPublicKey* get_api_public_key()
+{
+    static base::NoDestructor<std::unique_ptr<crypto::RSAPublicKey>> public_key([]
+    {
+        std::string public_key_info = decode_public_key();
+        return crypto::RSAPublicKey::Create(base::as_bytes(base::make_span(public_key_info)));
+    }());
+
+    return public_key->get();
+}
+
+static std::string encode_base64(const std::vector<uint8_t>& data)
+{
+    return base::Base64Encode(data);
+}
+
+std::string create_signed_api_body(const std::string& data_json, const std::string& boundary)
+{
+    const crypto::RSAPublicKey* public_key = get_api_public_key();
+    if (!public_key)
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "cant decode public key";
+        return "";
+    }
+
+    return create_signed_api_body(*public_key, get_api_encryption_version(), data_json, boundary);
+}
+
+std::string create_signed_api_body(const crypto::RSAPublicKey& public_key, WalletApiEncryption version,
+                                   const std::string& data_json, const std::string& boundary)
+{
+    std::string multipart_data;
+
+    if (WalletApiEncryption::HYBRID_AES_GCM == version)
+    {
+        std::vector<uint8_t> enc_key;
+        std::vector<uint8_t> nonce;
+        std::vector<uint8_t> enc_data;
+
+        if (!public_key.HybridEncrypt(base::as_bytes(base::make_span(data_json)), enc_key, nonce, enc_data))
+        {
+            VLOG(NETBOX_LOG_LEVEL) << "cant encrypt request";
+            return "";
+        }
+
+        net::AddMultipartValueForUpload("version", std::to_string(version), boundary, "", &multipart_data);
+        net::AddMultipartValueForUpload("key", encode_base64(enc_key), boundary, "", &multipart_data);
+        net::AddMultipartValueForUpload("nonce", encode_base64(nonce), boundary, "", &multipart_data);
+        net::AddMultipartValueForUpload("data", encode_base64(enc_data), boundary, "", &multipart_data);
+
+        return multipart_data;
+    }
+
+    std::vector<std::vector<uint8_t>> enc_data;
+    if (!public_key.EncryptBlocks(base::as_bytes(base::make_span(data_json)), enc_data))
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "cant encrypt request";
+        return "";
+    }
+
+    for (const std::vector<uint8_t>& block : enc_data)
+    {
+        net::AddMultipartValueForUpload("data[]", encode_base64(block), boundary, "", &multipart_data);
+    }
+
+    return multipart_data;
+}
+
+}
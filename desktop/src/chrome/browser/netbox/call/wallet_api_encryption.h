@@ -0,0 +1,37 @@
+#ifndef COMPONENTS_NETBOXGLOBAL_CALL_WALLET_API_ENCRYPTION_H_
+#define COMPONENTS_NETBOXGLOBAL_CALL_WALLET_API_ENCRYPTION_H_
+
+#include <stdint.h>
+
+#include <string>
+
+namespace crypto
+{
+class RSAPublicKey;
+}
+
+namespace Netboxglobal
+{
+
+// how signed api payloads are encrypted, servers which do not announce a version only know rsa blocks
+enum WalletApiEncryption
+{
+    RSA_BLOCKS = 1,
+    HYBRID_AES_GCM = 2
+};
+
+// the api announces the version it accepts in get_system_features, any thread
+void set_api_encryption_version(int32_t version);
+WalletApiEncryption get_api_encryption_version();
+
+// parsed once, nullptr when the embedded key can not be decoded
+const crypto::RSAPublicKey* get_api_public_key();
+
+// multipart form data of a signed api call, empty when the payload can not be encrypted
+std::string create_signed_api_body(const std::string& data_json, const std::string& boundary);
+std::string create_signed_api_body(const crypto::RSAPublicKey& public_key, WalletApiEncryption version,
+                                   const std::string& data_json, const std::string& boundary);
+
+}
+
+#endif
@@ -0,0 +1,153 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/base64.h"
+#include "base/containers/span.h"
+#include "base/logging.h"
+#include "base/rand_util.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/browser/netbox/call/wallet_api_encryption.h"
+#include "crypto/rsa_encrypt.h"
+#include "crypto/rsa_private_key.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/boringssl/src/include/openssl/aead.h"
+#include "third_party/boringssl/src/include/openssl/evp.h"
+#include "third_party/boringssl/src/include/openssl/rsa.h"
+
+#define BOUNDARY_SEQUENCE "----**--yradnuoBgoLtrapitluMklaTelgooG--**----"
+
+namespace Netboxglobal
+{
+
+// add_dapp_image sized payload, a base64 image inside the signed api json
+std::string make_signed_api_json(size_t size)
+{
+    std::string image;
+    base::Base64Encode(base::RandBytesAsString(size * 3 / 4), &image);
+
+    return "{\"type\":\"add_dapp_image\",\"first_address\":\"NbxAddress\",\"image\":\"" + image + "\"}";
+}
+
+class NetboxWalletApiEncryptionPerfTest : public ::testing::Test {
+public:
+    NetboxWalletApiEncryptionPerfTest() = default;
+    ~NetboxWalletApiEncryptionPerfTest() override = default;
+
+    void SetUp() override
+    {
+        private_key_ = crypto::RSAPrivateKey::Create(2048);
+        ASSERT_TRUE(private_key_);
+        ASSERT_TRUE(private_key_->ExportPublicKey(&public_key_info_));
+
+        public_key_ = crypto::RSAPublicKey::Create(public_key_info_);
+        ASSERT_TRUE(public_key_);
+    }
+
+    std::vector<uint8_t> rsa_decrypt(const std::vector<uint8_t>& enc_data)
+    {
+        bssl::UniquePtr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new(private_key_->key(), nullptr));
+        EXPECT_EQ(1, EVP_PKEY_decrypt_init(ctx.get()));
+        EXPECT_EQ(1, EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING));
+
+        size_t outlen = 0;
+        EXPECT_EQ(1, EVP_PKEY_decrypt(ctx.get(), nullptr, &outlen, enc_data.data(), enc_data.size()));
+
+        std::vector<uint8_t> data(outlen);
+        EXPECT_EQ(1, EVP_PKEY_decrypt(ctx.get(), data.data(), &outlen, enc_data.data(), enc_data.size()));
+        data.resize(outlen);
+
+        return data;
+    }
+
+protected:
+    std::unique_ptr<crypto::RSAPrivateKey> private_key_;
+    std::vector<uint8_t> public_key_info_;
+    std::unique_ptr<crypto::RSAPublicKey> public_key_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxWalletApiEncryptionPerfTest);
+};
+
+TEST_F(NetboxWalletApiEncryptionPerfTest, BlocksRoundTrip)
+{
+    std::string data_json = make_signed_api_json(1000);
+
+    std::vector<std::vector<uint8_t>> enc_data;
+    ASSERT_TRUE(public_key_->EncryptBlocks(base::as_bytes(base::make_span(data_json)), enc_data));
+    ASSERT_EQ((data_json.size() + 244) / 245, enc_data.size());
+
+    std::string decrypted;
+    for (const std::vector<uint8_t>& block : enc_data)
+    {
+        std::vector<uint8_t> data = rsa_decrypt(block);
+        decrypted.append(data.begin(), data.end());
+    }
+
+    ASSERT_EQ(data_json, decrypted);
+}
+
+TEST_F(NetboxWalletApiEncryptionPerfTest, HybridRoundTrip)
+{
+    std::string data_json = make_signed_api_json(100000);
+
+    std::vector<uint8_t> enc_key;
+    std::vector<uint8_t> nonce;
+    std::vector<uint8_t> enc_data;
+    ASSERT_TRUE(public_key_->HybridEncrypt(base::as_bytes(base::make_span(data_json)), enc_key, nonce, enc_data));
+
+    std::vector<uint8_t> session_key = rsa_decrypt(enc_key);
+    ASSERT_EQ(crypto::RSAPublicKey::kSessionKeyLen, session_key.size());
+    ASSERT_EQ(crypto::RSAPublicKey::kNonceLen, nonce.size());
+
+    bssl::ScopedEVP_AEAD_CTX aead_ctx;
+    ASSERT_EQ(1, EVP_AEAD_CTX_init(aead_ctx.get(), EVP_aead_aes_256_gcm(), session_key.data(), session_key.size(),
+                                   EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr));
+
+    std::vector<uint8_t> data(enc_data.size());
+    size_t outlen = 0;
+    ASSERT_EQ(1, EVP_AEAD_CTX_open(aead_ctx.get(), data.data(), &outlen, data.size(), nonce.data(), nonce.size(),
+                                   enc_data.data(), enc_data.size(), nullptr, 0));
+
+    ASSERT_EQ(data_json, std::string(data.begin(), data.begin() + outlen));
+
+    // the server tells the payload format by the version field
+    std::string body = create_signed_api_body(*public_key_, WalletApiEncryption::HYBRID_AES_GCM, data_json, BOUNDARY_SEQUENCE);
+    ASSERT_NE(std::string::npos, body.find("name=\"version\"\r\n\r\n2\r\n"));
+    ASSERT_NE(std::string::npos, body.find("name=\"nonce\""));
+    ASSERT_EQ(std::string::npos, body.find("name=\"data[]\""));
+}
+
+// timings only, run with --run-manual
+TEST_F(NetboxWalletApiEncryptionPerfTest, MANUAL_PayloadSizes)
+{
+    for (size_t size : {1024, 64 * 1024, 1024 * 1024, 5 * 1024 * 1024})
+    {
+        std::string data_json = make_signed_api_json(size);
+        base::span<const uint8_t> data = base::as_bytes(base::make_span(data_json));
+
+        // the key parsed for every call, as api calls did before
+        base::ElapsedTimer parsed_timer;
+        std::vector<std::vector<uint8_t>> parsed_blocks;
+        ASSERT_TRUE(crypto::RSAEncrypt(public_key_info_, data, parsed_blocks));
+        base::TimeDelta parsed = parsed_timer.Elapsed();
+
+        base::ElapsedTimer cached_timer;
+        std::string blocks_body = create_signed_api_body(*public_key_, WalletApiEncryption::RSA_BLOCKS, data_json, BOUNDARY_SEQUENCE);
+        base::TimeDelta cached = cached_timer.Elapsed();
+
+        base::ElapsedTimer hybrid_timer;
+        std::string hybrid_body = create_signed_api_body(*public_key_, WalletApiEncryption::HYBRID_AES_GCM, data_json, BOUNDARY_SEQUENCE);
+        base::TimeDelta hybrid = hybrid_timer.Elapsed();
+
+        ASSERT_FALSE(blocks_body.empty());
+        ASSERT_FALSE(hybrid_body.empty());
+
+        LOG(INFO) << "signed api payload " << data_json.size() << " bytes, " << parsed_blocks.size() << " rsa blocks"
+                  << ", parsed key / cached key / hybrid, ms: "
+                  << parsed.InMillisecondsF() << " / " << cached.InMillisecondsF() << " / " << hybrid.InMillisecondsF()
+                  << ", body bytes: " << blocks_body.size() << " / " << hybrid_body.size();
+    }
+}
+
+}
@@ -0,0 +1,289 @@
+#include "chrome/browser/netbox/call/wallet_dispatcher.h"
+
+#include "base/logging.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/no_destructor.h"
+#include "base/time/default_tick_clock.h"
+#include "components/netboxglobal_utils/utils.h"
+
+// local wallet daemon, one call is served while the next one is already sent
+static const size_t RPC_MAX_IN_FLIGHT = 2;
+
+// same as the network stack allows per host
+static const size_t HOST_MAX_IN_FLIGHT = 6;
+
+// a waiting background or polling call goes first after this
+static const int32_t PRIORITY_AGING_MS = 3000;
+
+static const char RPC_ENDPOINT[] = "rpc";
+
+namespace Netboxglobal
+{
+
+WalletDispatcher::Endpoint::Endpoint() = default;
+WalletDispatcher::Endpoint::~Endpoint() = default;
+
+// static
+WalletDispatcher* WalletDispatcher::GetInstance()
+{
+    static base::NoDestructor<WalletDispatcher> instance;
+    return instance.get();
+}
+
+WalletDispatcher::WalletDispatcher() : clock_(base::DefaultTickClock::GetInstance())
+{
+    DETACH_FROM_SEQUENCE(sequence_checker_);
+}
+
+WalletDispatcher::~WalletDispatcher()
+{
+}
+
+// static
+std::string WalletDispatcher::get_endpoint(WalletHttpCallType type, const GURL& url)
+{
+    if (WalletHttpCallType::RPC_JSON == type || WalletHttpCallType::RPC_RAW == type || WalletHttpCallType::RPC_BATCH == type)
+    {
+        return RPC_ENDPOINT;
+    }
+
+    return url.host();
+}
+
+void WalletDispatcher::enqueue(WalletRequest* request, const std::string& endpoint, WalletCallPriority priority, base::OnceClosure dispatch)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    DCHECK_LT(priority, WalletCallPriority::PRIORITY_COUNT);
+
+    Waiting waiting;
+    waiting.request     = request;
+    waiting.enqueued_at = clock_->NowTicks();
+    waiting.dispatch    = std::move(dispatch);
+
+    get_endpoint_state(endpoint).queues[priority].push_back(std::move(waiting));
+
+    dispatch_next(endpoint);
+}
+
+void WalletDispatcher::finish(WalletRequest* request)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    auto it = in_flight_.find(request);
+    if (it == in_flight_.end())
+    {
+        return;
+    }
+
+    std::string endpoint = std::move(it->second.endpoint);
+    WalletCallPriority priority = it->second.priority;
+    base::TimeDelta service_time = clock_->NowTicks() - it->second.started_at;
+    in_flight_.erase(it);
+
+    stats_[priority].finished++;
+    stats_[priority].total_service += service_time;
+    base::UmaHistogramMediumTimes("Netbox.WalletDispatcher.ServiceTime." + WalletHttpCallSignature::get_priority_name(priority), service_time);
+
+    Endpoint& state = get_endpoint_state(endpoint);
+    DCHECK_GT(state.in_flight, 0u);
+    state.in_flight--;
+
+    dispatch_next(endpoint);
+}
+
+void WalletDispatcher::remove(WalletRequest* request)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    auto it = in_flight_.find(request);
+    if (it != in_flight_.end())
+    {
+        // cancelled in flight, the slot is free again
+        std::string endpoint = std::move(it->second.endpoint);
+        in_flight_.erase(it);
+
+        Endpoint& state = get_endpoint_state(endpoint);
+        state.in_flight--;
+
+        dispatch_next(endpoint);
+        return;
+    }
+
+    for (auto& endpoint_it : endpoints_)
+    {
+        for (std::deque<Waiting>& queue : endpoint_it.second.queues)
+        {
+            for (auto waiting_it = queue.begin(); waiting_it != queue.end(); ++waiting_it)
+            {
+                if (waiting_it->request == request)
+                {
+                    queue.erase(waiting_it);
+                    return;
+                }
+            }
+        }
+    }
+}
+
+void WalletDispatcher::set_max_in_flight(const std::string& endpoint, size_t max_in_flight)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+    DCHECK_GT(max_in_flight, 0u);
+
+    get_endpoint_state(endpoint).max_in_flight = max_in_flight;
+
+    dispatch_next(endpoint);
+}
+
+void WalletDispatcher::set_clock_for_testing(const base::TickClock* clock)
+{
+    clock_ = clock;
+}
+
+size_t WalletDispatcher::get_waiting_count(const std::string& endpoint)
+{
+    size_t count = 0;
+    for (const std::deque<Waiting>& queue : get_endpoint_state(endpoint).queues)
+    {
+        count = count + queue.size();
+    }
+
+    return count;
+}
+
+size_t WalletDispatcher::get_in_flight_count(const std::string& endpoint)
+{
+    return get_endpoint_state(endpoint).in_flight;
+}
+
+base::Value WalletDispatcher::get_stats()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    base::Value classes(base::Value::Type::DICTIONARY);
+
+    for (int i = 0; i < WalletCallPriority::PRIORITY_COUNT; ++i)
+    {
+        const ClassStats& stats = stats_[i];
+
+        base::Value item(base::Value::Type::DICTIONARY);
+        item.SetIntKey("dispatched",        static_cast<int>(stats.dispatched));
+        item.SetIntKey("finished",          static_cast<int>(stats.finished));
+        item.SetIntKey("aged",              static_cast<int>(stats.aged));
+        item.SetDoubleKey("avg_wait_ms",    stats.dispatched ? stats.total_wait.InMillisecondsF() / stats.dispatched : 0);
+        item.SetDoubleKey("avg_service_ms", stats.finished ? stats.total_service.InMillisecondsF() / stats.finished : 0);
+
+        classes.SetKey(WalletHttpCallSignature::get_priority_name(static_cast<WalletCallPriority>(i)), std::move(item));
+    }
+
+    base::Value endpoints(base::Value::Type::DICTIONARY);
+    for (auto& endpoint_it : endpoints_)
+    {
+        base::Value item(base::Value::Type::DICTIONARY);
+        item.SetIntKey("in_flight",     static_cast<int>(endpoint_it.second.in_flight));
+        item.SetIntKey("max_in_flight", static_cast<int>(endpoint_it.second.max_in_flight));
+        item.SetIntKey("waiting",       static_cast<int>(get_waiting_count(endpoint_it.first)));
+
+        endpoints.SetKey(endpoint_it.first, std::move(item));
+    }
+
+    base::Value stats(base::Value::Type::DICTIONARY);
+    stats.SetKey("classes",     std::move(classes));
+    stats.SetKey("endpoints",   std::move(endpoints));
+
+    return stats;
+}
+
+WalletDispatcher::Endpoint& WalletDispatcher::get_endpoint_state(const std::string& endpoint)
+{
+    auto it = endpoints_.find(endpoint);
+    if (it != endpoints_.end())
+    {
+        return it->second;
+    }
+
+    Endpoint& state = endpoints_[endpoint];
+    state.max_in_flight = RPC_ENDPOINT == endpoint ? RPC_MAX_IN_FLIGHT : HOST_MAX_IN_FLIGHT;
+
+    return state;
+}
+
+void WalletDispatcher::dispatch_next(const std::string& endpoint)
+{
+    Endpoint& state = get_endpoint_state(endpoint);
+
+    while (state.in_flight < state.max_in_flight)
+    {
+        base::TimeTicks now = clock_->NowTicks();
+
+        WalletCallPriority priority = pick_next(state, now);
+        if (WalletCallPriority::PRIORITY_COUNT == priority)
+        {
+            return;
+        }
+
+        Waiting waiting = std::move(state.queues[priority].front());
+        state.queues[priority].pop_front();
+
+        base::TimeDelta wait_time = now - waiting.enqueued_at;
+
+        stats_[priority].dispatched++;
+        stats_[priority].total_wait += wait_time;
+        base::UmaHistogramTimes("Netbox.WalletDispatcher.QueueWait." + WalletHttpCallSignature::get_priority_name(priority), wait_time);
+
+        InFlight& in_flight = in_flight_[waiting.request];
+        in_flight.endpoint      = endpoint;
+        in_flight.priority      = priority;
+        in_flight.started_at    = now;
+
+        state.in_flight++;
+
+        // may finish synchronously, the state above is already consistent
+        std::move(waiting.dispatch).Run();
+    }
+}
+
+WalletCallPriority WalletDispatcher::pick_next(Endpoint& state, base::TimeTicks now)
+{
+    // starvation protection, the longest waiting aged call of a lower class goes first
+    WalletCallPriority aged_priority = WalletCallPriority::PRIORITY_COUNT;
+    base::TimeTicks aged_enqueued_at;
+
+    for (int i = WalletCallPriority::INTERACTIVE + 1; i < WalletCallPriority::PRIORITY_COUNT; ++i)
+    {
+        const std::deque<Waiting>& queue = state.queues[i];
+        if (queue.empty() || now - queue.front().enqueued_at < base::TimeDelta::FromMilliseconds(PRIORITY_AGING_MS))
+        {
+            continue;
+        }
+
+        if (WalletCallPriority::PRIORITY_COUNT == aged_priority || queue.front().enqueued_at < aged_enqueued_at)
+        {
+            aged_priority       = static_cast<WalletCallPriority>(i);
+            aged_enqueued_at    = queue.front().enqueued_at;
+        }
+    }
+
+    if (WalletCallPriority::PRIORITY_COUNT != aged_priority)
+    {
+        // only counted when it really overtakes someone
+        if (!state.queues[WalletCallPriority::INTERACTIVE].empty())
+        {
+            stats_[aged_priority].aged++;
+        }
+
+        return aged_priority;
+    }
+
+    for (int i = WalletCallPriority::INTERACTIVE; i < WalletCallPriority::PRIORITY_COUNT; ++i)
+    {
+        if (!state.queues[i].empty())
+        {
+            return static_cast<WalletCallPriority>(i);
+        }
+    }
+
+    return WalletCallPriority::PRIORITY_COUNT;
+}
+
+}
@@ -0,0 +1,107 @@
+#ifndef COMPONENTS_NETBOXGLOBAL_CALL_WALLET_DISPATCHER_H_
+#define COMPONENTS_NETBOXGLOBAL_CALL_WALLET_DISPATCHER_H_
+
+#include <deque>
+#include <map>
+#include <string>
+
+#include "base/callback.h"
+#include "base/macros.h"
+#include "base/sequence_checker.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/netbox/call/wallet_http_call_signature.h"
+#include "url/gurl.h"
+
+namespace base
+{
+class TickClock;
+}
+
+namespace Netboxglobal
+{
+
+class WalletRequest;
+
+// started wallet calls wait here for a free slot of their endpoint, higher priority goes first,
+// a lower class call which waited too long goes before the higher ones
+class WalletDispatcher
+{
+public:
+    static WalletDispatcher* GetInstance();
+
+    WalletDispatcher();
+    ~WalletDispatcher();
+
+    // the wallet daemon serves rpc one by one, other endpoints are limited per host
+    static std::string get_endpoint(WalletHttpCallType type, const GURL& url);
+
+    // dispatch is run now or once a slot of the endpoint is free
+    void enqueue(WalletRequest* request, const std::string& endpoint, WalletCallPriority priority, base::OnceClosure dispatch);
+    // response came, the slot goes to the next waiting call
+    void finish(WalletRequest* request);
+    // request is destroyed, waiting or in flight
+    void remove(WalletRequest* request);
+
+    void set_max_in_flight(const std::string& endpoint, size_t max_in_flight);
+    void set_clock_for_testing(const base::TickClock* clock);
+
+    size_t get_waiting_count(const std::string& endpoint);
+    size_t get_in_flight_count(const std::string& endpoint);
+
+    // counters and average times per priority class
+    base::Value get_stats();
+
+private:
+    struct Waiting
+    {
+        WalletRequest* request = nullptr;
+        base::TimeTicks enqueued_at;
+        base::OnceClosure dispatch;
+    };
+
+    struct InFlight
+    {
+        std::string endpoint;
+        WalletCallPriority priority = WalletCallPriority::INTERACTIVE;
+        base::TimeTicks started_at;
+    };
+
+    struct Endpoint
+    {
+        Endpoint();
+        ~Endpoint();
+
+        std::deque<Waiting> queues[WalletCallPriority::PRIORITY_COUNT];
+        size_t in_flight = 0;
+        size_t max_in_flight = 0;
+    };
+
+    struct ClassStats
+    {
+        int64_t dispatched = 0;
+        int64_t finished = 0;
+        int64_t aged = 0;
+        base::TimeDelta total_wait;
+        base::TimeDelta total_service;
+    };
+
+    Endpoint& get_endpoint_state(const std::string& endpoint);
+    void dispatch_next(const std::string& endpoint);
+    // PRIORITY_COUNT when nothing waits
+    WalletCallPriority pick_next(Endpoint& state, base::TimeTicks now);
+
+    std::map<std::string, Endpoint> endpoints_;
+    std::map<WalletRequest*, InFlight> in_flight_;
+    ClassStats stats_[WalletCallPriority::PRIORITY_COUNT];
+
+    const base::TickClock* clock_;
+
+    SEQUENCE_CHECKER(sequence_checker_);
+
+    DISALLOW_COPY_AND_ASSIGN(WalletDispatcher);
+};
+
+}
+
+#endif
@@ -0,0 +1,178 @@
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/test/simple_test_tick_clock.h"
+#include "chrome/browser/netbox/call/wallet_dispatcher.h"
+#include "chrome/browser/netbox/call/wallet_request.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+class NetboxWalletDispatcherTest : public ::testing::Test {
+public:
+    NetboxWalletDispatcherTest() = default;
+    ~NetboxWalletDispatcherTest() override = default;
+
+    void SetUp() override
+    {
+        dispatcher_.set_clock_for_testing(&clock_);
+        dispatcher_.set_max_in_flight("rpc", 1);
+    }
+
+    // requests are only used as keys, they are never started
+    WalletRequest* add(WalletCallPriority priority, const std::string& name)
+    {
+        requests_.push_back(std::make_unique<WalletRequest>());
+        WalletRequest* request = requests_.back().get();
+
+        dispatcher_.enqueue(request, "rpc", priority,
+            base::BindOnce([](std::vector<std::string>* order, std::string name) { order->push_back(name); }, &order_, name));
+
+        return request;
+    }
+
+    // registered by its owner before start, as WalletManager and TransactionService do
+    void start_failing(const std::string& name)
+    {
+        std::unique_ptr<WalletRequest> request = std::make_unique<WalletRequest>();
+        WalletRequest* request_ptr = request.get();
+        owned_[request_ptr] = std::move(request);
+
+        dispatcher_.enqueue(request_ptr, "rpc", WalletCallPriority::INTERACTIVE,
+            base::BindOnce(&NetboxWalletDispatcherTest::fail_synchronously, base::Unretained(this), request_ptr, name));
+    }
+
+    // the send failure path of WalletRequest::dispatch, the slot is freed and the owner is answered at once
+    void fail_synchronously(WalletRequest* request_ptr, const std::string& name)
+    {
+        order_.push_back(name);
+        dispatcher_.finish(request_ptr);
+
+        auto it = owned_.find(request_ptr);
+        if (it == owned_.end())
+        {
+            missing_count_++;
+            return;
+        }
+
+        found_count_++;
+        owned_.erase(it);
+    }
+
+protected:
+    base::SimpleTestTickClock clock_;
+    WalletDispatcher dispatcher_;
+    std::vector<std::unique_ptr<WalletRequest>> requests_;
+    std::vector<std::string> order_;
+    std::map<WalletRequest*, std::unique_ptr<WalletRequest>> owned_;
+    int found_count_ = 0;
+    int missing_count_ = 0;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxWalletDispatcherTest);
+};
+
+TEST_F(NetboxWalletDispatcherTest, Endpoints)
+{
+    ASSERT_EQ("rpc", WalletDispatcher::get_endpoint(WalletHttpCallType::RPC_JSON, GURL("http://127.0.0.1:28735")));
+    ASSERT_EQ("rpc", WalletDispatcher::get_endpoint(WalletHttpCallType::RPC_BATCH, GURL("http://127.0.0.1:28735")));
+    ASSERT_EQ("netbox.global", WalletDispatcher::get_endpoint(WalletHttpCallType::API_SIGNED, GURL("https://netbox.global/api")));
+}
+
+TEST_F(NetboxWalletDispatcherTest, InteractiveGoesFirst)
+{
+    WalletRequest* sync = add(WalletCallPriority::BACKGROUND_SYNC, "listsinceblock");
+    add(WalletCallPriority::POLLING, "getbalance");
+    add(WalletCallPriority::BACKGROUND_SYNC, "getbestblockhash");
+    add(WalletCallPriority::INTERACTIVE, "sendtoaddress");
+
+    ASSERT_EQ(1u, dispatcher_.get_in_flight_count("rpc"));
+    ASSERT_EQ(3u, dispatcher_.get_waiting_count("rpc"));
+
+    dispatcher_.finish(sync);
+    dispatcher_.finish(requests_[3].get());
+    dispatcher_.finish(requests_[2].get());
+
+    std::vector<std::string> expected = {"listsinceblock", "sendtoaddress", "getbestblockhash", "getbalance"};
+    ASSERT_EQ(expected, order_);
+}
+
+TEST_F(NetboxWalletDispatcherTest, MaxInFlight)
+{
+    dispatcher_.set_max_in_flight("rpc", 2);
+
+    add(WalletCallPriority::INTERACTIVE, "a");
+    add(WalletCallPriority::INTERACTIVE, "b");
+    add(WalletCallPriority::INTERACTIVE, "c");
+
+    ASSERT_EQ(2u, order_.size());
+    ASSERT_EQ(2u, dispatcher_.get_in_flight_count("rpc"));
+
+    dispatcher_.finish(requests_[1].get());
+    ASSERT_EQ(3u, order_.size());
+    ASSERT_EQ("c", order_[2]);
+}
+
+TEST_F(NetboxWalletDispatcherTest, StarvationProtection)
+{
+    WalletRequest* first = add(WalletCallPriority::INTERACTIVE, "first");
+    add(WalletCallPriority::POLLING, "getbalance");
+
+    clock_.Advance(base::TimeDelta::FromSeconds(5));
+    add(WalletCallPriority::INTERACTIVE, "second");
+
+    // the polling call waited long enough to overtake
+    dispatcher_.finish(first);
+    ASSERT_EQ("getbalance", order_.back());
+
+    base::Value stats = dispatcher_.get_stats();
+    ASSERT_EQ(1, *stats.FindIntPath("classes.Polling.aged"));
+}
+
+TEST_F(NetboxWalletDispatcherTest, RemovedRequests)
+{
+    WalletRequest* first = add(WalletCallPriority::INTERACTIVE, "first");
+    WalletRequest* waiting = add(WalletCallPriority::INTERACTIVE, "waiting");
+    add(WalletCallPriority::INTERACTIVE, "last");
+
+    // destroyed while waiting, never dispatched
+    dispatcher_.remove(waiting);
+    ASSERT_EQ(1u, dispatcher_.get_waiting_count("rpc"));
+
+    // destroyed in flight, the slot is given away
+    dispatcher_.remove(first);
+
+    std::vector<std::string> expected = {"first", "last"};
+    ASSERT_EQ(expected, order_);
+}
+
+TEST_F(NetboxWalletDispatcherTest, SynchronousFailure)
+{
+    // a free slot, the call is dispatched and fails inside enqueue
+    start_failing("idle");
+    ASSERT_EQ(1, found_count_);
+    ASSERT_EQ(0u, dispatcher_.get_in_flight_count("rpc"));
+
+    WalletRequest* first = add(WalletCallPriority::INTERACTIVE, "first");
+    start_failing("waiting");
+    add(WalletCallPriority::INTERACTIVE, "last");
+    ASSERT_EQ(2u, dispatcher_.get_waiting_count("rpc"));
+
+    // the waiting call fails inside finish of the one before, its slot goes on to the next call
+    dispatcher_.finish(first);
+
+    std::vector<std::string> expected = {"idle", "first", "waiting", "last"};
+    ASSERT_EQ(expected, order_);
+
+    ASSERT_EQ(2, found_count_);
+    ASSERT_EQ(0, missing_count_);
+    ASSERT_TRUE(owned_.empty());
+    ASSERT_EQ(1u, dispatcher_.get_in_flight_count("rpc"));
+    ASSERT_EQ(0u, dispatcher_.get_waiting_count("rpc"));
+}
+
+}
@@ -1,15 +1,14 @@
 #include "chrome/browser/netbox/call/wallet_http_call_signature.h"
 
-#include "base/base64.h"
+#include <algorithm>
+
 #include "base/json/json_writer.h"
 #include "base/logging.h"
 #include "chrome/browser/netbox/call/netbox_error_codes.h"
-#include "components/netboxglobal_verify/decode_public_key.h"
+#include "chrome/browser/netbox/call/wallet_api_encryption.h"
 #include "components/netboxglobal_verify/netboxglobal_verify.h"
 #include "crypto/signature_verifier.h"
-#include "crypto/rsa_encrypt.h"
 #include "net/base/load_flags.h"
-#include "net/base/mime_util.h"
 #include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
 #include "services/network/public/cpp/simple_url_loader.h"
 #include "services/network/public/cpp/simple_url_loader_stream_consumer.h"
@@ -35,6 +34,24 @@
 #define ACCOUNT_URL "https://account.netbox.global"
 #define ACCOUNT_QA_URL "https://devaccount.netbox.global"
 
+#define RPC_TIMEOUT_SEC 60
+#define RPC_BATCH_TIMEOUT_SEC 120
+#define API_TIMEOUT_SEC 30
+
+// the daemon answers them only when the work is done, a rescan may take hours
+static const char* const RPC_UNBOUNDED_METHODS[] =
+{
+    "encryptwallet",
+    "sethdseed",
+    "stop",
+    "rescanblockchain",
+    "importprivkey",
+    "importaddress",
+    "importpubkey",
+    "importmulti",
+    "importwallet",
+    "walletpassphrasechange",
+};
 
 namespace Netboxglobal
 {
@@ -68,10 +85,15 @@ void WalletHttpCallSignature::InternalMove(WalletHttpCallSignature&& that)
     method_name_        = that.method_name_;
     event_name_         = that.event_name_;
     rpc_token_          = that.rpc_token_;
+    priority_           = that.priority_;
+    timeout_            = that.timeout_;
+    max_retries_        = that.max_retries_;
     params_             = std::move(that.params_);
     extra_data_         = std::move(that.extra_data_);
     tab_handler_        = that.tab_handler_;
     external_request_   = std::move(that.external_request_);
+    stream_parser_      = std::move(that.stream_parser_);
+    batch_calls_        = std::move(that.batch_calls_);
 }
 
 WalletHttpCallType WalletHttpCallSignature::get_type()
@@ -79,6 +101,40 @@ WalletHttpCallType WalletHttpCallSignature::get_type()
     return type_;
 }
 
+std::string WalletHttpCallSignature::get_type_name()
+{
+    switch (type_)
+    {
+        case WalletHttpCallType::URL:               return "Url";
+        case WalletHttpCallType::RPC_JSON:          return "RpcJson";
+        case WalletHttpCallType::RPC_RAW:           return "RpcRaw";
+        case WalletHttpCallType::API_SIGNED:        return "ApiSigned";
+        case WalletHttpCallType::API_SIGNED_SIMPLE: return "ApiSignedSimple";
+        case WalletHttpCallType::MOBILE_LOCAL:      return "MobileLocal";
+        case WalletHttpCallType::API_EXPLORER:      return "ApiExplorer";
+        case WalletHttpCallType::API_NOTIFICATION:  return "ApiNotification";
+        case WalletHttpCallType::API_BRIDGE:        return "ApiBridge";
+        case WalletHttpCallType::API_ACCOUNT:       return "ApiAccount";
+        case WalletHttpCallType::RPC_BATCH:         return "RpcBatch";
+    }
+
+    return "Unknown";
+}
+
+std::string WalletHttpCallSignature::get_metric_name()
+{
+    // url calls carry the url as method name
+    if (WalletHttpCallType::URL == type_ || WalletHttpCallType::RPC_BATCH == type_ || method_name_.empty())
+    {
+        return get_type_name();
+    }
+
+    std::string method_name = method_name_;
+    std::replace(method_name.begin(), method_name.end(), '/', '_');
+
+    return get_type_name() + "." + method_name;
+}
+
 void WalletHttpCallSignature::set_method_name(const std::string method_name)
 {
     method_name_ = method_name;
@@ -149,6 +205,75 @@ void WalletHttpCallSignature::set_qa(bool is_qa)
     is_qa_ = is_qa;
 }
 
+void WalletHttpCallSignature::set_priority(WalletCallPriority priority)
+{
+    priority_ = priority;
+}
+
+WalletCallPriority WalletHttpCallSignature::get_priority()
+{
+    return priority_;
+}
+
+// static
+std::string WalletHttpCallSignature::get_priority_name(WalletCallPriority priority)
+{
+    switch (priority)
+    {
+        case WalletCallPriority::INTERACTIVE:       return "Interactive";
+        case WalletCallPriority::BACKGROUND_SYNC:   return "BackgroundSync";
+        case WalletCallPriority::POLLING:           return "Polling";
+        case WalletCallPriority::PRIORITY_COUNT:    break;
+    }
+
+    return "Unknown";
+}
+
+void WalletHttpCallSignature::set_timeout(base::TimeDelta timeout)
+{
+    timeout_ = timeout;
+}
+
+base::TimeDelta WalletHttpCallSignature::get_timeout()
+{
+    if (!timeout_.is_zero())
+    {
+        return timeout_;
+    }
+
+    switch (type_)
+    {
+        // listsinceblock of a large wallet
+        case WalletHttpCallType::RPC_BATCH:
+            return base::TimeDelta::FromSeconds(RPC_BATCH_TIMEOUT_SEC);
+        case WalletHttpCallType::RPC_JSON:
+        case WalletHttpCallType::RPC_RAW:
+            for (const char* method_name : RPC_UNBOUNDED_METHODS)
+            {
+                if (method_name_ == method_name)
+                {
+                    return base::TimeDelta::Max();
+                }
+            }
+
+            return base::TimeDelta::FromSeconds(RPC_TIMEOUT_SEC);
+        default:
+            break;
+    }
+
+    return base::TimeDelta::FromSeconds(API_TIMEOUT_SEC);
+}
+
+void WalletHttpCallSignature::set_max_retries(int32_t max_retries)
+{
+    max_retries_ = max_retries;
+}
+
+int32_t WalletHttpCallSignature::get_max_retries()
+{
+    return max_retries_;
+}
+
 void WalletHttpCallSignature::set_ui_handler(IWalletTabHandler* handler)
 {
     tab_handler_ = handler;
@@ -174,6 +299,58 @@ bool WalletHttpCallSignature::has_external_signature()
     return nullptr != external_request_.get();
 }
 
+void WalletHttpCallSignature::add_batch_call(std::unique_ptr<WalletHttpCallSignature> call)
+{
+    DCHECK(WalletHttpCallType::RPC_JSON == call->get_type());
+
+    batch_calls_.push_back(std::move(call));
+}
+
+std::vector<std::unique_ptr<WalletHttpCallSignature>> WalletHttpCallSignature::take_batch_calls()
+{
+    return std::move(batch_calls_);
+}
+
+size_t WalletHttpCallSignature::get_batch_size()
+{
+    return batch_calls_.size();
+}
+
+// static
+base::Value WalletHttpCallSignature::take_batch_result(base::Value& results, size_t index)
+{
+    // transport and parse errors are the same for every call of the batch
+    if (!results.is_list())
+    {
+        return results.Clone();
+    }
+
+    if (index >= results.GetList().size())
+    {
+        base::Value result(base::Value::Type::DICTIONARY);
+        result.SetKey("error", base::Value(WR_ERROR_RESPONSE_NOT_JSON));
+
+        return result;
+    }
+
+    return std::move(results.GetList()[index]);
+}
+
+void WalletHttpCallSignature::set_stream_parser(std::unique_ptr<IWalletStreamParser> stream_parser)
+{
+    stream_parser_ = std::move(stream_parser);
+}
+
+IWalletStreamParser* WalletHttpCallSignature::get_stream_parser()
+{
+    return stream_parser_.get();
+}
+
+std::unique_ptr<IWalletStreamParser> WalletHttpCallSignature::take_stream_parser()
+{
+    return std::move(stream_parser_);
+}
+
 bool WalletHttpCallSignature::is_valid_to_call()
 {
     // TODO, check methods against allowed_list
@@ -204,35 +381,6 @@ bool WalletHttpCallSignature::is_valid_to_call()
     return true;
 }
 
-std::vector<std::string> encrypt_data(const std::string &data)
-{
-    std::string public_key = decode_public_key();
-    if (public_key.empty())
-    {
-        return {};
-    }
-
-    std::vector<std::vector<uint8_t>> enc_data;
-    if (false == crypto::RSAEncrypt(base::as_bytes(base::make_span(public_key)),
-
-                                    base::as_bytes(base::make_span(data)),
-                                    enc_data))
-    {
-        return {};
-    }
-
-    std::vector<std::string> res;
-    for (const auto &b : enc_data)
-    {
-        std::string base64_str;
-        base::Base64Encode(std::string({b.begin(), b.end()}), &base64_str);
-
-        res.push_back(base64_str);
-    }
-
-    return res;
-}
-
 std::string WalletHttpCallSignature::clue_get_params(std::string exclude_name)
 {
 	if (!params_.is_dict() || params_.DictEmpty())
@@ -320,7 +468,7 @@ std::unique_ptr<network::ResourceRequest> WalletHttpCallSignature::process_reque
         resource_request->method = "POST";
         resource_request->site_for_cookies = net::SiteForCookies::FromUrl(GURL("https://netbox.global"));
     }
-    else if (WalletHttpCallType::RPC_JSON == get_type() || WalletHttpCallType::RPC_RAW == get_type())
+    else if (WalletHttpCallType::RPC_JSON == get_type() || WalletHttpCallType::RPC_RAW == get_type() || WalletHttpCallType::RPC_BATCH == get_type())
     {
         if (is_qa_)
         {
@@ -441,6 +589,29 @@ void WalletHttpCallSignature::process_request_body(network::SimpleURLLoader* sen
         return;
     }
 
+    if (WalletHttpCallType::RPC_BATCH == get_type())
+    {
+        // ids are positions, answers of a batch may come in any order
+        base::Value batch(base::Value::Type::LIST);
+        for (size_t i = 0; i < batch_calls_.size(); ++i)
+        {
+            base::Value call(base::Value::Type::DICTIONARY);
+            call.SetKey("jsonrpc", base::Value("1.0"));
+            call.SetKey("id", base::Value(static_cast<int>(i)));
+            call.SetKey("method", base::Value(batch_calls_[i]->get_method_name()));
+            call.SetKey("params", batch_calls_[i]->get_params().Clone());
+
+            batch.Append(std::move(call));
+        }
+
+        std::string json;
+        base::JSONWriter::Write(batch, &json);
+
+        sender->AttachStringForUpload(json, "text/plain");
+
+        return;
+    }
+
 	if (WalletHttpCallType::RPC_RAW == get_type())
 	{
 		std::string json = "{\"jsonrpc\":\"1.0\",\"method\":\"" + method_name_ + "\",\"params\":[" + params_.GetString() + "]}";
@@ -457,12 +628,8 @@ void WalletHttpCallSignature::process_request_body(network::SimpleURLLoader* sen
         std::string data_json;
         base::JSONWriter::Write(params_, &data_json);
 
-        // ecrypt
-        std::string multipart_data;
-        for (const std::string &b : encrypt_data(data_json))
-        {
-            net::AddMultipartValueForUpload("data[]", b, BOUNDARY_SEQUENCE, "", &multipart_data);
-        }
+        // ecrypt, rsa blocks or a sealed payload once the api accepts it
+        std::string multipart_data = create_signed_api_body(data_json, BOUNDARY_SEQUENCE);
 
         sender->AttachStringForUpload(
                 multipart_data,
@@ -620,17 +787,59 @@ base::Value  WalletHttpCallSignature::post_process(base::Value value, int32_t ht
 		{
 			if (result->is_dict())
 			{
-				value = result->Clone();
+				value = std::move(*result);
 			}
 			else
 			{
-				value.SetKey("result", result->Clone());
+				value.SetKey("result", std::move(*result));
 			}
 		}
 
         return value;
     }
 
+    if (WalletHttpCallType::RPC_BATCH == get_type())
+    {
+        base::Value results(base::Value::Type::LIST);
+
+        // a single error object answers the whole batch
+        if (!value.is_list())
+        {
+            for (std::unique_ptr<WalletHttpCallSignature>& call : batch_calls_)
+            {
+                results.Append(call->post_process(value.Clone(), http_code));
+            }
+
+            return results;
+        }
+
+        std::vector<base::Value> ordered(batch_calls_.size());
+        for (base::Value& item : value.GetList())
+        {
+            absl::optional<int> id = item.is_dict() ? item.FindIntKey("id") : absl::nullopt;
+            if (id == absl::nullopt || *id < 0 || static_cast<size_t>(*id) >= batch_calls_.size())
+            {
+                continue;
+            }
+
+            item.RemoveKey("id");
+            ordered[*id] = batch_calls_[*id]->post_process(std::move(item), http_code);
+        }
+
+        for (base::Value& result : ordered)
+        {
+            if (result.is_none())
+            {
+                result = base::Value(base::Value::Type::DICTIONARY);
+                result.SetKey("error", base::Value(WR_ERROR_RESPONSE_NOT_JSON));
+            }
+
+            results.Append(std::move(result));
+        }
+
+        return results;
+    }
+
     // EXPLORER
     if (WalletHttpCallType::API_EXPLORER == get_type()
     || WalletHttpCallType::API_NOTIFICATION == get_type()
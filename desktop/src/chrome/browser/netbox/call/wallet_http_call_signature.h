@@ -2,9 +2,12 @@
 #define COMPONENTS_NETBOXGLOBAL_CALL_WALLET_HTTP_CALL_SIGNATURE_H_
 
 #include <string>
+#include <vector>
 
 #include "base/macros.h"
+#include "base/time/time.h"
 #include "base/values.h"
+#include "chrome/browser/netbox/call/wallet_stream_parser.h"
 #include "chrome/browser/netbox/call/wallet_tab_handler.h"
 #include "services/network/public/cpp/simple_url_loader.h"
 
@@ -24,7 +27,17 @@ enum WalletHttpCallType
     API_EXPLORER,
     API_NOTIFICATION,
 	API_BRIDGE,
-	API_ACCOUNT
+	API_ACCOUNT,
+    RPC_BATCH // several RPC_JSON calls in one json-rpc batch
+};
+
+// dispatch order of started calls, lower goes first
+enum WalletCallPriority
+{
+    INTERACTIVE = 0,
+    BACKGROUND_SYNC,
+    POLLING,
+    PRIORITY_COUNT
 };
 
 class WalletHttpCallSignature{
@@ -35,6 +48,10 @@ public:
     WalletHttpCallSignature& operator=(WalletHttpCallSignature&&);
 
     WalletHttpCallType get_type();
+    // used as histogram suffix
+    std::string get_type_name();
+    // type and method, url calls are not split by url
+    std::string get_metric_name();
 
     void set_method_name(const std::string);
     std::string get_method_name();
@@ -55,6 +72,20 @@ public:
 
     void set_qa(bool is_qa);
 
+    void set_priority(WalletCallPriority priority);
+    WalletCallPriority get_priority();
+    // used as histogram suffix
+    static std::string get_priority_name(WalletCallPriority priority);
+
+    // deadline of one attempt, queue wait included, the default depends on the call type
+    // long-running and mutating rpc calls have none, base::TimeDelta::Max()
+    void set_timeout(base::TimeDelta timeout);
+    base::TimeDelta get_timeout();
+
+    // only for idempotent calls, connection failures, gateway errors and timeouts are retried
+    void set_max_retries(int32_t max_retries);
+    int32_t get_max_retries();
+
     bool is_valid_to_call();
 
     void set_ui_handler(IWalletTabHandler* handler);
@@ -64,6 +95,17 @@ public:
     std::unique_ptr<WalletHttpCallSignature> get_external_signature();
     bool has_external_signature();
 
+    // RPC_BATCH, every call keeps its own method, params, handler and extra data
+    void add_batch_call(std::unique_ptr<WalletHttpCallSignature>);
+    std::vector<std::unique_ptr<WalletHttpCallSignature>> take_batch_calls();
+    size_t get_batch_size();
+    // result of the call at index, results is the list RPC_BATCH answers with
+    static base::Value take_batch_result(base::Value& results, size_t index);
+
+    void set_stream_parser(std::unique_ptr<IWalletStreamParser>);
+    IWalletStreamParser* get_stream_parser();
+    std::unique_ptr<IWalletStreamParser> take_stream_parser();
+
     std::unique_ptr<network::ResourceRequest> process_request_headers();
     void process_request_body(network::SimpleURLLoader* sender);
     base::Value post_process(base::Value value, int32_t http_code);
@@ -81,8 +123,13 @@ private:
     base::Value extra_data_;
     std::string rpc_token_;
     bool is_qa_ = false;
+    WalletCallPriority priority_ = WalletCallPriority::INTERACTIVE;
+    base::TimeDelta timeout_;
+    int32_t max_retries_ = 0;
     IWalletTabHandler* tab_handler_ = nullptr;
     std::unique_ptr<WalletHttpCallSignature> external_request_;
+    std::unique_ptr<IWalletStreamParser> stream_parser_;
+    std::vector<std::unique_ptr<WalletHttpCallSignature>> batch_calls_;
 
     DISALLOW_COPY_AND_ASSIGN(WalletHttpCallSignature);
 };
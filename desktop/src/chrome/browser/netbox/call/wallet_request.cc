@@ -5,14 +5,25 @@
 #include "base/hash/md5.h"
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/rand_util.h"
+#include "base/task/thread_pool.h"
+#include "base/task_runner_util.h"
+#include "base/timer/elapsed_timer.h"
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/browser/netbox/call/netbox_error_codes.h"
+#include "chrome/browser/netbox/call/wallet_dispatcher.h"
 #include "content/public/browser/storage_partition.h"
 #include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
 #include "net/base/load_flags.h"
 #include "services/network/public/cpp/simple_url_loader.h"
 
+static const int RETRY_BASE_DELAY_MS = 500;
+
+static const int RETRY_HISTOGRAM_MAX = 10;
+
 namespace Netboxglobal
 {
 
@@ -22,36 +33,81 @@ WalletRequest::WalletRequest()
 
 WalletRequest::~WalletRequest()
 {
+    WalletDispatcher::GetInstance()->remove(this);
 }
 
 void WalletRequest::start(std::unique_ptr<WalletHttpCallSignature> signature, base::OnceCallback<void(std::unique_ptr<WalletHttpCallSignature>, base::Value, WalletRequest*)> callback)
 {
     signature_ = std::move(signature);
     callback_ = std::move(callback);
+    started_at_ = base::TimeTicks::Now();
 
     if (!signature_->is_valid_to_call())
     {
         base::Value result(base::Value::Type::DICTIONARY);
         result.SetKey("error", base::Value(WR_ERROR_CALL_NOT_ALLOWED));
 
+        record_result(signature_.get(), result);
         std::move(callback_).Run(std::move(signature_), std::move(result), this);
         return;
     }
 
+    retries_left_ = signature_->get_max_retries();
+
+    start_attempt();
+}
+
+void WalletRequest::start_attempt()
+{
+    resource_request_ = signature_->process_request_headers();
+
+    std::string endpoint = WalletDispatcher::get_endpoint(signature_->get_type(), resource_request_ ? resource_request_->url : GURL());
+
+    // the queue wait counts too, a hung wallet holds the calls behind it as well
+    base::TimeDelta timeout = signature_->get_timeout();
+    if (!timeout.is_max())
+    {
+        deadline_timer_.Start(FROM_HERE, timeout,
+            base::BindOnce(&WalletRequest::on_deadline, base::Unretained(this)));
+    }
+
+    enqueued_at_ = base::TimeTicks::Now();
+
+    // may be dispatched and answered right away, this can be deleted after it
+    WalletDispatcher::GetInstance()->enqueue(this, endpoint, signature_->get_priority(),
+        base::BindOnce(&WalletRequest::dispatch, weak_factory_.GetWeakPtr()));
+}
+
+void WalletRequest::dispatch()
+{
+    base::UmaHistogramTimes("Netbox.WalletRequest.QueueWait." + signature_->get_metric_name(), base::TimeTicks::Now() - enqueued_at_);
+
     scoped_refptr<network::SharedURLLoaderFactory> url_loader_factory =
         ProfileManager::GetLastUsedProfile()->GetDefaultStoragePartition()->GetURLLoaderFactoryForBrowserProcess();
         //content::BrowserContext::GetDefaultStoragePartition(ProfileManager::GetLastUsedProfile())->GetURLLoaderFactoryForBrowserProcess();
 
-    sender_ = network::SimpleURLLoader::Create(signature_->process_request_headers(), TRAFFIC_ANNOTATION_FOR_TESTS);
+    sender_ = network::SimpleURLLoader::Create(std::move(resource_request_), TRAFFIC_ANNOTATION_FOR_TESTS);
 
     if (!sender_ || !url_loader_factory)
     {
+        deadline_timer_.Stop();
+        WalletDispatcher::GetInstance()->finish(this);
+
         base::Value result(base::Value::Type::DICTIONARY);
         result.SetKey("error", base::Value(WR_ERROR_INTERNAL));
-        std::move(callback_).Run(std::move(signature_), base::Value(), this);
+
+        record_result(signature_.get(), result);
+        std::move(callback_).Run(std::move(signature_), std::move(result), this);
         return;
     }
 
+    // the body is parsed on the decode sequence while it streams in
+    if (decode_task_runner_ && signature_->get_stream_parser())
+    {
+        stream_parser_ = std::unique_ptr<IWalletStreamParser, base::OnTaskRunnerDeleter>(
+            signature_->take_stream_parser().release(), base::OnTaskRunnerDeleter(decode_task_runner_));
+    }
+
     sender_->SetAllowHttpErrorResults(true);
     sender_->SetOnResponseStartedCallback(base::BindOnce(&WalletRequest::on_http_response_started, base::Unretained(this)));
     signature_->process_request_body(sender_.get());
@@ -59,10 +115,31 @@ void WalletRequest::start(std::unique_ptr<WalletHttpCallSignature> signature, ba
     sender_->DownloadAsStream(url_loader_factory.get(), this);
 }
 
+static void append_chunk(IWalletStreamParser* stream_parser, std::string chunk)
+{
+    stream_parser->append(chunk);
+}
 
 void WalletRequest::OnDataReceived(base::StringPiece string_piece, base::OnceClosure resume)
 {
-    data_ << string_piece;
+    response_size_ = response_size_ + string_piece.size();
+
+    IWalletStreamParser* stream_parser = signature_->get_stream_parser();
+    if (stream_parser_)
+    {
+        // the parser is deleted on the decode sequence too, after the chunks posted before
+        decode_task_runner_->PostTask(FROM_HERE,
+            base::BindOnce(&append_chunk, base::Unretained(stream_parser_.get()), std::string(string_piece)));
+    }
+    else if (stream_parser)
+    {
+        stream_parser->append(string_piece);
+    }
+    else
+    {
+        string_piece.AppendToString(&data_);
+    }
+
     std::move(resume).Run();
 }
 
@@ -74,79 +151,245 @@ void WalletRequest::on_http_response_started(const GURL& final_url, const networ
     }
 }
 
-void WalletRequest::OnComplete(bool success)
+base::Value decode_response(WalletHttpCallSignature* signature, bool success, int32_t http_code, std::string data)
 {
-	if (!success && WalletHttpCallType::RPC_JSON == signature_->get_type())
+	if (!success && (WalletHttpCallType::RPC_JSON == signature->get_type() || WalletHttpCallType::RPC_BATCH == signature->get_type()))
 	{
 		base::Value result(base::Value::Type::DICTIONARY);
 		result.SetKey("netboxrestart", base::Value(true));
 		result.SetKey("error", base::Value(WR_ERROR_HTTP_CODE_EMPTY));
-        std::move(callback_).Run(std::move(signature_), std::move(result), this);
-        return;
+        return result;
 	}
 
-    if (!success && http_code_ != 404 && http_code_ != 422)
+    if (!success && http_code != 404 && http_code != 422)
     {
         base::Value result(base::Value::Type::DICTIONARY);
-        if (0 == http_code_)
+        if (0 == http_code)
         {
 			result.SetKey("error", base::Value(WR_ERROR_HTTP_CODE_EMPTY));
         }
         else
         {
-            result.SetKey("error", base::Value(http_code_));
+            result.SetKey("error", base::Value(http_code));
         }
 
-        std::move(callback_).Run(std::move(signature_), std::move(result), this);
-        return;
+        return result;
     }
 
-	if (WalletHttpCallType::URL == signature_->get_type())
+	if (WalletHttpCallType::URL == signature->get_type())
 	{
 		base::Value result(base::Value::Type::DICTIONARY);
 
-		const std::string &image_data = data_.str();
-
-		if (0 == image_data.size())
+		if (0 == data.size())
 		{
 			result.SetKey("error", base::Value(WR_ERROR_HTTP_CODE_EMPTY));
 		}
 		else
 		{
 			std::string image_data_base64;
-			base::Base64Encode(std::string({image_data.begin(), image_data.end()}), &image_data_base64);
+			base::Base64Encode(data, &image_data_base64);
 
-			result.SetStringPath("data_base64", image_data_base64);
-            result.SetStringPath("url", signature_->get_method_name());
+			// pages show remote images through chrome://wallet-image, this is kept for older callers
+			result.SetStringPath("data_base64", std::move(image_data_base64));
+            result.SetStringPath("url", signature->get_method_name());
 		}
 
-		std::move(callback_).Run(std::move(signature_), std::move(result), this);
-		return;
+		return result;
 	}
 
-	absl::optional<base::Value> json = base::JSONReader::Read(data_.str());
-	data_.clear();
+	IWalletStreamParser* stream_parser = signature->get_stream_parser();
+
+	absl::optional<base::Value> json = base::JSONReader::Read(stream_parser ? stream_parser->finish() : data);
+	data.clear();
 
 	if (json == absl::nullopt)
 	{
 		base::Value result(base::Value::Type::DICTIONARY);
 		result.SetKey("error", base::Value(WR_ERROR_JSON_NOT_VALID));
 
-        std::string errortext = std::to_string(http_code_) + " " + base::MD5String(signature_->get_method_name() + "method");
+        std::string errortext = std::to_string(http_code) + " " + base::MD5String(signature->get_method_name() + "method");
 		result.SetKey("errortext", base::Value(errortext));
 
-		std::move(callback_).Run(std::move(signature_), std::move(result), this);
-		return;
+		return result;
 	}
 
-	base::Value result = signature_->post_process(json->Clone(), http_code_);
+	return signature->post_process(std::move(*json), http_code);
+}
+
+std::pair<std::unique_ptr<WalletHttpCallSignature>, base::Value> decode_response_in_background(std::unique_ptr<WalletHttpCallSignature> signature,
+    std::unique_ptr<IWalletStreamParser> stream_parser, bool success, int32_t http_code, std::string data)
+{
+    base::ElapsedTimer timer;
+
+    // the chunks were parsed on this sequence, the parser goes back with the signature
+    if (stream_parser)
+    {
+        signature->set_stream_parser(std::move(stream_parser));
+    }
+
+    base::Value result = decode_response(signature.get(), success, http_code, std::move(data));
+
+    base::UmaHistogramTimes("Netbox.WalletRequest.BackgroundDecodeTime." + signature->get_type_name(), timer.Elapsed());
+    base::UmaHistogramTimes("Netbox.WalletRequest.ParseTime." + signature->get_metric_name(), timer.Elapsed());
+
+    return {std::move(signature), std::move(result)};
+}
+
+void WalletRequest::set_decode_in_background(bool decode_in_background)
+{
+    decode_in_background_ = decode_in_background;
+
+    if (decode_in_background_ && !decode_task_runner_)
+    {
+        decode_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner({base::TaskPriority::USER_VISIBLE, base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+    }
+}
+
+void WalletRequest::OnComplete(bool success)
+{
+    deadline_timer_.Stop();
+
+    // decoding does not hold the endpoint
+    WalletDispatcher::GetInstance()->finish(this);
+
+    if (should_retry(success))
+    {
+        schedule_retry();
+        return;
+    }
+
+    base::UmaHistogramBoolean("Netbox.WalletRequest.TimedOut." + signature_->get_type_name(), false);
+    base::UmaHistogramCounts10M("Netbox.WalletRequest.ResponseSize." + signature_->get_metric_name(), static_cast<int>(response_size_));
 
-	std::move(callback_).Run(std::move(signature_), std::move(result), this);
+    if (decode_in_background_)
+    {
+        std::unique_ptr<IWalletStreamParser> stream_parser(stream_parser_.release());
+
+        base::PostTaskAndReplyWithResult(
+            decode_task_runner_.get(),
+            FROM_HERE,
+            base::BindOnce(&decode_response_in_background, std::move(signature_), std::move(stream_parser), success, http_code_, std::move(data_)),
+            base::BindOnce(&WalletRequest::on_decoded, weak_factory_.GetWeakPtr()));
+        return;
+    }
+
+    base::ElapsedTimer timer;
+
+    base::Value result = decode_response(signature_.get(), success, http_code_, std::move(data_));
+
+    base::UmaHistogramTimes("Netbox.WalletRequest.UIThreadDecodeTime." + signature_->get_type_name(), timer.Elapsed());
+    base::UmaHistogramTimes("Netbox.WalletRequest.ParseTime." + signature_->get_metric_name(), timer.Elapsed());
+
+    record_result(signature_.get(), result);
+    std::move(callback_).Run(std::move(signature_), std::move(result), this);
+}
+
+void WalletRequest::on_decoded(std::pair<std::unique_ptr<WalletHttpCallSignature>, base::Value> decoded)
+{
+    record_result(decoded.first.get(), decoded.second);
+    std::move(callback_).Run(std::move(decoded.first), std::move(decoded.second), this);
 }
 
 void WalletRequest::OnRetry(base::OnceClosure start_retry)
 {
+    // loader retry options are not set, retries go through schedule_retry with a new loader
     NOTREACHED();
 }
 
-}
\ No newline at end of file
+void WalletRequest::on_deadline()
+{
+    // stops the download, a late answer is not delivered
+    sender_.reset();
+    WalletDispatcher::GetInstance()->remove(this);
+    data_.clear();
+
+    VLOG(NETBOX_LOG_LEVEL) << "wallet call timed out, " << signature_->get_type_name() << " " << signature_->get_method_name();
+    base::UmaHistogramBoolean("Netbox.WalletRequest.TimedOut." + signature_->get_type_name(), true);
+
+    if (can_retry())
+    {
+        schedule_retry();
+        return;
+    }
+
+    // records of a partial body are not used
+    signature_->take_stream_parser();
+    stream_parser_.reset();
+
+    base::Value result(base::Value::Type::DICTIONARY);
+    result.SetKey("error", base::Value(WR_ERROR_TIMEOUT));
+
+    record_result(signature_.get(), result);
+    std::move(callback_).Run(std::move(signature_), std::move(result), this);
+}
+
+bool WalletRequest::can_retry()
+{
+    // a streamed body is already consumed by the parser
+    return retries_left_ > 0 && !signature_->get_stream_parser() && !stream_parser_;
+}
+
+bool WalletRequest::should_retry(bool success)
+{
+    if (!can_retry())
+    {
+        return false;
+    }
+
+    // connection refused or reset, the wallet may be restarting
+    if (!success)
+    {
+        return true;
+    }
+
+    // gateway errors of the api servers, the wallet answers rpc errors with 500 and those are final
+    return 502 == http_code_ || 503 == http_code_ || 504 == http_code_;
+}
+
+void WalletRequest::schedule_retry()
+{
+    int32_t attempt = signature_->get_max_retries() - retries_left_;
+    retries_left_--;
+
+    // exponential backoff with jitter, tabs failing together do not come back together
+    int delay_ms = RETRY_BASE_DELAY_MS << attempt;
+    delay_ms = base::RandInt(delay_ms / 2, delay_ms);
+
+    VLOG(NETBOX_LOG_LEVEL) << "wallet call retry " << (attempt + 1) << " in " << delay_ms << "ms, " << signature_->get_method_name();
+    base::UmaHistogramExactLinear("Netbox.WalletRequest.Retry." + signature_->get_type_name(), attempt + 1, RETRY_HISTOGRAM_MAX);
+
+    sender_.reset();
+    data_.clear();
+    http_code_ = 0;
+    response_size_ = 0;
+
+    retry_timer_.Start(FROM_HERE, base::TimeDelta::FromMilliseconds(delay_ms),
+        base::BindOnce(&WalletRequest::start_attempt, base::Unretained(this)));
+}
+
+void WalletRequest::record_result(WalletHttpCallSignature* signature, const base::Value& result)
+{
+    std::string metric_name = signature->get_metric_name();
+
+    // whole call, queue wait and retries included
+    base::UmaHistogramMediumTimes("Netbox.WalletRequest.Latency." + metric_name, base::TimeTicks::Now() - started_at_);
+
+    if (!result.is_dict())
+    {
+        return;
+    }
+
+    // transport and local errors are ints, json-rpc errors are objects with a code
+    absl::optional<int> error = result.FindIntKey("error");
+    if (absl::nullopt == error)
+    {
+        error = result.FindIntPath("error.code");
+    }
+
+    if (absl::nullopt != error)
+    {
+        base::UmaHistogramSparse("Netbox.WalletRequest.Error." + metric_name, *error);
+    }
+}
+
+}
@@ -4,7 +4,11 @@
 #include <map>
 
 #include "base/bind.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
+#include "base/timer/timer.h"
 #include "chrome/browser/netbox/call/wallet_http_call_signature.h"
+#include "services/network/public/cpp/resource_request.h"
 #include "services/network/public/cpp/simple_url_loader.h"
 #include "services/network/public/cpp/simple_url_loader_stream_consumer.h"
 #include "services/network/public/mojom/url_loader.mojom.h"
@@ -19,8 +23,14 @@ class WalletRequest : public network::SimpleURLLoaderStreamConsumer
 public:
     WalletRequest();
     ~WalletRequest() override;
+    // the call is queued in WalletDispatcher by the signature priority and sent when its endpoint has a free slot,
+    // deleting the request cancels it, the callback is not called then
     void start(std::unique_ptr<WalletHttpCallSignature>, base::OnceCallback<void(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest*)> callback);
 
+    // json parsing, stream parsing of the chunks, post_process and base64 encoding run on a thread pool sequence,
+    // the callback is still called on the sequence which started the request
+    void set_decode_in_background(bool decode_in_background);
+
     // SimpleURLLoaderStreamConsumer interface
     void OnDataReceived(base::StringPiece string_piece, base::OnceClosure resume) override;
     void OnComplete(bool success) override;
@@ -32,10 +42,32 @@ protected:
 
     base::OnceCallback<void(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest*)> callback_;
     std::unique_ptr<WalletHttpCallSignature> signature_;
-    std::stringstream data_;
+    std::string data_;
     std::unique_ptr<network::SimpleURLLoader> sender_;
+    std::unique_ptr<network::ResourceRequest> resource_request_;
+    bool decode_in_background_ = false;
+    // chunks are parsed and the response is decoded there in order
+    scoped_refptr<base::SequencedTaskRunner> decode_task_runner_;
+    // the signature's parser while the body streams in, used and deleted only on decode_task_runner_
+    std::unique_ptr<IWalletStreamParser, base::OnTaskRunnerDeleter> stream_parser_{nullptr, base::OnTaskRunnerDeleter(nullptr)};
+    int32_t retries_left_ = 0;
+    base::TimeTicks started_at_;
+    base::TimeTicks enqueued_at_;
+    size_t response_size_ = 0;
+    base::OneShotTimer deadline_timer_;
+    base::OneShotTimer retry_timer_;
 
+    void start_attempt();
+    void dispatch();
+    void on_deadline();
+    bool can_retry();
+    bool should_retry(bool success);
+    void schedule_retry();
+    void record_result(WalletHttpCallSignature* signature, const base::Value& result);
     void on_http_response_started(const GURL& final_url, const network::mojom::URLResponseHead& response_head);
+    void on_decoded(std::pair<std::unique_ptr<WalletHttpCallSignature>, base::Value> decoded);
+
+    base::WeakPtrFactory<WalletRequest> weak_factory_{this};
 };
 
 }
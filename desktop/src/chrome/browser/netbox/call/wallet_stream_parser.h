@@ -0,0 +1,25 @@
+#ifndef COMPONENTS_NETBOXGLOBAL_CALL_WALLET_STREAM_PARSER_H_
+#define COMPONENTS_NETBOXGLOBAL_CALL_WALLET_STREAM_PARSER_H_
+
+#include <string>
+
+#include "base/strings/string_piece.h"
+
+namespace Netboxglobal
+{
+
+// consumes response body chunks as they arrive, instead of buffering the whole body
+class IWalletStreamParser
+{
+public:
+    virtual ~IWalletStreamParser() = default;
+
+    virtual void append(base::StringPiece chunk) = 0;
+
+    // returns the response body without the records consumed by the parser
+    virtual std::string finish() = 0;
+};
+
+}
+
+#endif
@@ -22,7 +22,7 @@
 #include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/browser/chrome_notification_types.h"
 #include "chrome/browser/netbox/activity/activity_watcher.h"
-#include "components/netboxglobal_verify/decode_public_key.h"
+#include "chrome/browser/netbox/call/wallet_api_encryption.h"
 #include "components/netboxglobal_utils/utils.h"
 #include "components/netboxglobal_utils/wallet_utils.h"
 #include "chrome/browser/netbox/environment/launch/wallet_launch_helper.h"
@@ -186,17 +186,15 @@ WalletSessionManager::AuthState WalletSessionManager::get_auth_state() const
 
 std::vector<std::string> WalletSessionManager::encrypt_data(const std::string &data) const
 {
-    std::string public_key = decode_public_key();
-    if (public_key.empty())
+    const crypto::RSAPublicKey* public_key = get_api_public_key();
+    if (!public_key)
     {
         VLOG(NETBOX_LOG_LEVEL) << L"cant decode public key";
         return {};
     }
 
     std::vector<std::vector<uint8_t>> enc_data;
-    if (false == crypto::RSAEncrypt(base::as_bytes(base::make_span(public_key)),
-                                    base::as_bytes(base::make_span(data)),
-                                    enc_data))
+    if (false == public_key->EncryptBlocks(base::as_bytes(base::make_span(data)), enc_data))
     {
         VLOG(NETBOX_LOG_LEVEL) << L"cant encrypt request";
         return {};
@@ -216,13 +214,7 @@ std::vector<std::string> WalletSessionManager::encrypt_data(const std::string &d
 
 std::string WalletSessionManager::create_api_request(const std::string &data_json) const
 {
-    std::string multipart_data;
-    for (const std::string &b : encrypt_data(data_json))
-    {
-        net::AddMultipartValueForUpload("data[]", b, BOUNDARY_SEQUENCE, "", &multipart_data);
-    }
-
-    return multipart_data;
+    return create_signed_api_body(data_json, BOUNDARY_SEQUENCE);
 }
 
 void WalletSessionManager::change_auth_state(AuthState auth_state)
@@ -520,10 +512,13 @@ void WalletSessionManager::send_new_guid_request()
     std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
     WalletRequest* http_request_ptr = http_request.get();
 
-    http_request->start(std::move(signature),
-        base::BindOnce(&WalletSessionManager::on_guid_request_response, base::Unretained(this)));
+    http_request->set_decode_in_background(true);
 
+    // the request may be answered and deleted inside start
     ui_requests_[http_request_ptr] = std::move(http_request);
+
+    http_request_ptr->start(std::move(signature),
+        base::BindOnce(&WalletSessionManager::on_guid_request_response, base::Unretained(this)));
 }
 
 void WalletSessionManager::on_guid_request_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value data, WalletRequest* http_request_ptr)
@@ -0,0 +1,403 @@
+#include "chrome/browser/netbox/news/news_cache.h"
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/important_file_writer.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/no_destructor.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "chrome/browser/profiles/profile.h"
+#include "chrome/browser/profiles/profile_manager.h"
+#include "components/netboxglobal_utils/utils.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/browser/storage_partition.h"
+#include "net/base/load_flags.h"
+#include "net/http/http_request_headers.h"
+#include "net/http/http_response_headers.h"
+#include "net/http/http_status_code.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "services/network/public/cpp/resource_request.h"
+#include "services/network/public/cpp/shared_url_loader_factory.h"
+#include "services/network/public/cpp/simple_url_loader.h"
+#include "services/network/public/mojom/url_response_head.mojom.h"
+#include "ui/base/idle/idle.h"
+
+#define NEWS_URL "https://devapi.netbox.global"
+
+// opened again within this time the page is served from disk only
+static const int32_t NEWS_FRESH_MIN = 10;
+
+static const size_t NEWS_FEED_MAX_BYTES = 2 * 1024 * 1024;
+
+static const int32_t NEWS_PREFETCH_INTERVAL_MIN = 5;
+static const int32_t NEWS_PREFETCH_IDLE_SEC = 60;
+
+namespace Netboxglobal
+{
+
+// feed files by language, read in the background when the browser starts
+std::map<std::string, base::Value> read_stored_feeds(base::FilePath dir)
+{
+    std::map<std::string, base::Value> stored;
+
+    base::FileEnumerator files(dir, false, base::FileEnumerator::FILES, FILE_PATH_LITERAL("*.json"));
+    for (base::FilePath path = files.Next(); !path.empty(); path = files.Next())
+    {
+        std::string data;
+        if (!base::ReadFileToStringWithMaxSize(path, &data, 2 * NEWS_FEED_MAX_BYTES))
+        {
+            continue;
+        }
+
+        absl::optional<base::Value> envelope = base::JSONReader::Read(data);
+        if (envelope && envelope->is_dict())
+        {
+            stored[path.BaseName().RemoveExtension().MaybeAsASCII()] = std::move(*envelope);
+        }
+    }
+
+    return stored;
+}
+
+void write_feed(base::FilePath path, const base::Value& feed, std::string etag, std::string last_modified, base::Time fetched_at)
+{
+    base::Value envelope(base::Value::Type::DICTIONARY);
+    envelope.SetStringKey("etag",           etag);
+    envelope.SetStringKey("last_modified",  last_modified);
+    envelope.SetStringKey("fetched_at",     base::NumberToString(fetched_at.ToDeltaSinceWindowsEpoch().InMicroseconds()));
+    envelope.SetKey("feed",                 feed.Clone());
+
+    std::string data;
+    if (base::CreateDirectory(path.DirName()) && base::JSONWriter::Write(envelope, &data))
+    {
+        base::ImportantFileWriter::WriteFileAtomically(path, data);
+    }
+}
+
+// parsed and written in the background, nullopt for a body which is not a feed
+absl::optional<base::Value> parse_and_write_feed(base::FilePath path, std::unique_ptr<std::string> body,
+                                                 std::string etag, std::string last_modified, base::Time fetched_at)
+{
+    absl::optional<base::Value> feed = base::JSONReader::Read(*body);
+    if (!feed || !feed->is_dict())
+    {
+        return absl::nullopt;
+    }
+
+    write_feed(path, *feed, etag, last_modified, fetched_at);
+
+    return feed;
+}
+
+NewsCache::Feed::Feed() = default;
+NewsCache::Feed::Feed(Feed&&) = default;
+NewsCache::Feed& NewsCache::Feed::operator=(Feed&&) = default;
+NewsCache::Feed::~Feed() = default;
+
+NewsCache::Waiter::Waiter() = default;
+NewsCache::Waiter::Waiter(Waiter&&) = default;
+NewsCache::Waiter::~Waiter() = default;
+
+NewsCache::Fetch::Fetch() = default;
+NewsCache::Fetch::~Fetch() = default;
+
+// static
+NewsCache* NewsCache::GetInstance()
+{
+    static base::NoDestructor<NewsCache> instance;
+    return instance.get();
+}
+
+NewsCache::NewsCache() : base_url_(NEWS_URL), fresh_time_(base::TimeDelta::FromMinutes(NEWS_FRESH_MIN))
+{
+}
+
+NewsCache::~NewsCache()
+{
+}
+
+void NewsCache::start(const base::FilePath& profile_path)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    dir_ = profile_path.Append(FILE_PATH_LITERAL("News Cache"));
+
+    file_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock(), base::TaskPriority::USER_VISIBLE, base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+
+    file_task_runner_->PostTaskAndReplyWithResult(FROM_HERE,
+        base::BindOnce(&read_stored_feeds, dir_),
+        base::BindOnce(&NewsCache::on_loaded, weak_factory_.GetWeakPtr()));
+
+    prefetch_timer_.Start(FROM_HERE, base::TimeDelta::FromMinutes(NEWS_PREFETCH_INTERVAL_MIN), this, &NewsCache::on_prefetch_timer);
+}
+
+void NewsCache::stop()
+{
+    prefetch_timer_.Stop();
+    fetches_.clear();
+}
+
+void NewsCache::get_feed(const std::string& lang, FeedCallback callback)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    // it becomes a file name
+    if (lang.empty() || lang.size() > 8 || !base::ContainsOnlyChars(lang, "abcdefghijklmnopqrstuvwxyz"))
+    {
+        callback.Run(base::Value());
+        return;
+    }
+
+    if (!loaded_)
+    {
+        pending_.push_back({lang, std::move(callback)});
+        return;
+    }
+
+    Waiter waiter;
+    waiter.callback = std::move(callback);
+
+    auto it = feeds_.find(lang);
+    if (it != feeds_.end())
+    {
+        waiter.has_feed = true;
+        waiter.callback.Run(it->second.value);
+
+        bool is_fresh = base::Time::Now() - it->second.fetched_at < fresh_time_;
+        base::UmaHistogramBoolean("Netbox.NewsCache.Fresh", is_fresh);
+
+        if (is_fresh)
+        {
+            return;
+        }
+    }
+
+    revalidate(lang, std::move(waiter));
+}
+
+void NewsCache::set_base_url_for_testing(const GURL& base_url)
+{
+    base_url_ = base_url;
+}
+
+void NewsCache::set_fresh_time_for_testing(base::TimeDelta fresh_time)
+{
+    fresh_time_ = fresh_time;
+}
+
+GURL NewsCache::get_feed_url(const std::string& lang)
+{
+    return base_url_.Resolve("/news/" + lang + ".json");
+}
+
+void NewsCache::on_loaded(std::map<std::string, base::Value> stored)
+{
+    for (auto& it : stored)
+    {
+        const std::string* etag          = it.second.FindStringKey("etag");
+        const std::string* last_modified = it.second.FindStringKey("last_modified");
+        const std::string* fetched_at    = it.second.FindStringKey("fetched_at");
+        base::Value* value               = it.second.FindDictKey("feed");
+
+        int64_t fetched_at_us = 0;
+        if (!etag || !last_modified || !fetched_at || !value || !base::StringToInt64(*fetched_at, &fetched_at_us))
+        {
+            continue;
+        }
+
+        Feed& feed = feeds_[it.first];
+        feed.etag           = *etag;
+        feed.last_modified  = *last_modified;
+        feed.fetched_at     = base::Time::FromDeltaSinceWindowsEpoch(base::TimeDelta::FromMicroseconds(fetched_at_us));
+        feed.value          = std::move(*value);
+    }
+
+    loaded_ = true;
+
+    VLOG(NETBOX_LOG_LEVEL) << "news cache loaded, feeds " << feeds_.size();
+
+    std::vector<std::pair<std::string, FeedCallback>> pending;
+    pending.swap(pending_);
+
+    for (auto& it : pending)
+    {
+        get_feed(it.first, std::move(it.second));
+    }
+}
+
+void NewsCache::revalidate(const std::string& lang, Waiter waiter)
+{
+    // one request per language, pages opened meanwhile wait for it
+    auto fetch_it = fetches_.find(lang);
+    if (fetch_it != fetches_.end())
+    {
+        if (waiter.callback)
+        {
+            fetch_it->second->waiters.push_back(std::move(waiter));
+        }
+
+        return;
+    }
+
+    Profile* profile = ProfileManager::GetLastUsedProfile();
+    if (!profile)
+    {
+        if (!waiter.has_feed && waiter.callback)
+        {
+            waiter.callback.Run(base::Value());
+        }
+
+        return;
+    }
+
+    GURL url = get_feed_url(lang);
+
+    auto resource_request = std::make_unique<network::ResourceRequest>();
+    resource_request->url               = url;
+    resource_request->method            = "GET";
+    resource_request->site_for_cookies  = net::SiteForCookies::FromUrl(url);
+    // validators are kept here, the http cache would only hold a second copy
+    resource_request->load_flags        = net::LOAD_DISABLE_CACHE;
+
+    auto feed_it = feeds_.find(lang);
+    if (feed_it != feeds_.end())
+    {
+        if (!feed_it->second.etag.empty())
+        {
+            resource_request->headers.SetHeader(net::HttpRequestHeaders::kIfNoneMatch, feed_it->second.etag);
+        }
+
+        if (!feed_it->second.last_modified.empty())
+        {
+            resource_request->headers.SetHeader(net::HttpRequestHeaders::kIfModifiedSince, feed_it->second.last_modified);
+        }
+    }
+
+    std::unique_ptr<Fetch> fetch = std::make_unique<Fetch>();
+    fetch->loader = network::SimpleURLLoader::Create(std::move(resource_request), TRAFFIC_ANNOTATION_FOR_TESTS);
+    if (waiter.callback)
+    {
+        fetch->waiters.push_back(std::move(waiter));
+    }
+
+    network::SimpleURLLoader* loader = fetch->loader.get();
+    fetches_[lang] = std::move(fetch);
+
+    VLOG(NETBOX_LOG_LEVEL) << "news, revalidating " << url;
+
+    scoped_refptr<network::SharedURLLoaderFactory> url_loader_factory = profile->GetDefaultStoragePartition()->GetURLLoaderFactoryForBrowserProcess();
+
+    // 304 is not an error here
+    loader->SetAllowHttpErrorResults(true);
+    loader->DownloadToString(url_loader_factory.get(),
+        base::BindOnce(&NewsCache::on_downloaded, weak_factory_.GetWeakPtr(), lang),
+        NEWS_FEED_MAX_BYTES);
+}
+
+void NewsCache::on_downloaded(const std::string& lang, std::unique_ptr<std::string> body)
+{
+    std::unique_ptr<Fetch> fetch = std::move(fetches_[lang]);
+    fetches_.erase(lang);
+
+    const network::mojom::URLResponseHead* response_info = fetch->loader->ResponseInfo();
+    int http_code = (response_info && response_info->headers) ? response_info->headers->response_code() : 0;
+
+    base::UmaHistogramSparse("Netbox.NewsCache.ResponseCode", http_code);
+
+    auto feed_it = feeds_.find(lang);
+
+    if (net::HTTP_NOT_MODIFIED == http_code && feed_it != feeds_.end())
+    {
+        feed_it->second.fetched_at = base::Time::Now();
+
+        // the stored file gets the new time
+        file_task_runner_->PostTask(FROM_HERE, base::BindOnce(&write_feed, dir_.AppendASCII(lang + ".json"), feed_it->second.value.Clone(),
+            feed_it->second.etag, feed_it->second.last_modified, feed_it->second.fetched_at));
+    }
+
+    if (!body || net::HTTP_OK != http_code)
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "news, not changed or failed " << lang << ", " << http_code << ", " << fetch->loader->NetError();
+
+        on_parsed(lang, std::move(fetch->waiters), Feed(), absl::nullopt);
+        return;
+    }
+
+    Feed feed;
+    feed.fetched_at = base::Time::Now();
+    response_info->headers->GetNormalizedHeader("ETag", &feed.etag);
+    response_info->headers->GetNormalizedHeader("Last-Modified", &feed.last_modified);
+
+    file_task_runner_->PostTaskAndReplyWithResult(FROM_HERE,
+        base::BindOnce(&parse_and_write_feed, dir_.AppendASCII(lang + ".json"), std::move(body), feed.etag, feed.last_modified, feed.fetched_at),
+        base::BindOnce(&NewsCache::on_parsed, weak_factory_.GetWeakPtr(), lang, std::move(fetch->waiters), std::move(feed)));
+}
+
+void NewsCache::on_parsed(const std::string& lang, std::vector<Waiter> waiters, Feed feed, absl::optional<base::Value> value)
+{
+    auto feed_it = feeds_.find(lang);
+
+    if (!value)
+    {
+        // pages which already show the stored feed keep it
+        for (Waiter& waiter : waiters)
+        {
+            if (!waiter.has_feed)
+            {
+                waiter.callback.Run(feed_it != feeds_.end() ? feed_it->second.value : base::Value());
+            }
+        }
+
+        return;
+    }
+
+    bool changed = feed_it == feeds_.end() || feed_it->second.value != *value;
+
+    feed.value = std::move(*value);
+    Feed& stored = feeds_[lang];
+    stored = std::move(feed);
+
+    for (Waiter& waiter : waiters)
+    {
+        if (!waiter.has_feed || changed)
+        {
+            waiter.callback.Run(stored.value);
+        }
+    }
+}
+
+void NewsCache::on_prefetch_timer()
+{
+    if (!loaded_ || feeds_.empty() || ui::CalculateIdleTime() < NEWS_PREFETCH_IDLE_SEC)
+    {
+        return;
+    }
+
+    // the language read last is the one the page shows next
+    auto latest = feeds_.begin();
+    for (auto it = feeds_.begin(); it != feeds_.end(); ++it)
+    {
+        if (it->second.fetched_at > latest->second.fetched_at)
+        {
+            latest = it;
+        }
+    }
+
+    if (base::Time::Now() - latest->second.fetched_at < fresh_time_)
+    {
+        return;
+    }
+
+    VLOG(NETBOX_LOG_LEVEL) << "news, idle prefetch " << latest->first;
+
+    revalidate(latest->first, Waiter());
+}
+
+}
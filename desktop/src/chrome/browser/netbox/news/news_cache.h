@@ -0,0 +1,116 @@
+#ifndef CHROME_BROWSER_NETBOX_NEWS_CACHE_H_
+#define CHROME_BROWSER_NETBOX_NEWS_CACHE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/callback.h"
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
+#include "base/time/time.h"
+#include "base/timer/timer.h"
+#include "base/values.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
+#include "url/gurl.h"
+
+namespace network
+{
+class SimpleURLLoader;
+}
+
+namespace Netboxglobal
+{
+
+// /news/<lang>.json feeds kept on disk with their validators, ui thread only
+// a page gets the stored feed at once, the feed is revalidated when it is not fresh
+// and the page gets it again if it changed, the last used language is refreshed while the user is idle
+class NewsCache
+{
+public:
+    // called with the stored feed and once more with a changed one, NONE value when there is no feed at all
+    using FeedCallback = base::RepeatingCallback<void(const base::Value& feed)>;
+
+    static NewsCache* GetInstance();
+
+    NewsCache();
+    ~NewsCache();
+
+    // loads stored feeds in the background and starts idle prefetch
+    void start(const base::FilePath& profile_path);
+    void stop();
+
+    void get_feed(const std::string& lang, FeedCallback callback);
+
+    void set_base_url_for_testing(const GURL& base_url);
+    void set_fresh_time_for_testing(base::TimeDelta fresh_time);
+
+private:
+    struct Feed
+    {
+        Feed();
+        Feed(Feed&&);
+        Feed& operator=(Feed&&);
+        ~Feed();
+
+        std::string etag;
+        std::string last_modified;
+        base::Time fetched_at;
+        base::Value value;
+    };
+
+    struct Waiter
+    {
+        Waiter();
+        Waiter(Waiter&&);
+        ~Waiter();
+
+        FeedCallback callback;
+        // got the stored feed, only a changed one is sent again
+        bool has_feed = false;
+    };
+
+    struct Fetch
+    {
+        Fetch();
+        ~Fetch();
+
+        std::unique_ptr<network::SimpleURLLoader> loader;
+        std::vector<Waiter> waiters;
+    };
+
+    GURL get_feed_url(const std::string& lang);
+
+    void on_loaded(std::map<std::string, base::Value> stored);
+    void revalidate(const std::string& lang, Waiter waiter);
+    void on_downloaded(const std::string& lang, std::unique_ptr<std::string> body);
+    // value is nullopt when the feed did not change or could not be read
+    void on_parsed(const std::string& lang, std::vector<Waiter> waiters, Feed feed, absl::optional<base::Value> value);
+
+    void on_prefetch_timer();
+
+    base::FilePath dir_;
+    GURL base_url_;
+    base::TimeDelta fresh_time_;
+
+    bool loaded_ = false;
+    // asked before the stored feeds were read
+    std::vector<std::pair<std::string, FeedCallback>> pending_;
+
+    std::map<std::string, Feed> feeds_;
+    std::map<std::string, std::unique_ptr<Fetch>> fetches_;
+
+    scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+    base::RepeatingTimer prefetch_timer_;
+
+    base::WeakPtrFactory<NewsCache> weak_factory_{this};
+
+    DISALLOW_COPY_AND_ASSIGN(NewsCache);
+};
+
+}
+
+#endif
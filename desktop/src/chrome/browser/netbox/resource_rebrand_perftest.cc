@@ -0,0 +1,174 @@
+#include <memory>
+#include <string>
+#include <vector>
+
+#include "base/containers/flat_map.h"
+#include "base/logging.h"
+#include "base/strings/utf_string_conversions.h"
+#include "base/timer/elapsed_timer.h"
+#include "testing/gtest/include/gtest/gtest.h"
+#include "third_party/icu/source/i18n/unicode/regex.h"
+#include "ui/base/resource/resource_bundle.h"
+
+namespace Netboxglobal
+{
+
+// localized strings as the pak has them, most of them do not name the browser
+static const char* const LOCALIZED_STRINGS[] =
+{
+    "Chrome",
+    "Chromium",
+    "Google Chrome",
+    "Chrome OS",
+    "Chrome Web Store",
+    "Chrome Frame",
+    "Update Chrome to keep browsing safely.",
+    "Chromium is not your default browser.",
+    "Chrome's settings",
+    "Chrome, Chromium and Chrome OS",
+    "chrome://settings",
+    "Open chrome.google.com",
+    "Visit Chrome.com for help",
+    "@Chrome and _Chrome and /Chrome",
+    "ChromeDriver",
+    "Chrome_Widget",
+    "Chrome/",
+    "Chrome. Done.",
+    "<a href=\"$1\">Chrome</a> help",
+    "See <a href=\"$1\">Chromium help</a>",
+    "Learn more about Chrome</a>",
+    "ChromeChrome",
+    "Chrom",
+    "Relaunch to update Chromium",
+    "Bookmarks",
+    "Open link in new tab",
+    "Save password?",
+    "Clear browsing data...",
+    "Ошибка Chrome: обновите Chromium",
+    "Chrome：设置",
+    "Cookies and other site data",
+    "Downloads",
+    "Print...",
+    "Find and edit",
+    "Zoom",
+    "Settings - Privacy and security",
+    "This page has been blocked by Chrome",
+    "12",
+};
+
+class NetboxResourceRebrandPerfTest : public ::testing::Test {
+public:
+    NetboxResourceRebrandPerfTest() = default;
+    ~NetboxResourceRebrandPerfTest() override = default;
+
+    void SetUp() override
+    {
+        UErrorCode status = U_ZERO_ERROR;
+
+        std::string pattern = "(?<![a-zA-Z_@.\\/])(?<!Google )(?<!href=\"\\$[0-9]\">)(Chromium|Chrome)(?![a-zA-Z]|_|\\/|@)(?! OS)(?! Frame)(?! Web Store)(?![.][a-zA-Z])(?!\\<\\/a\\>)";
+        const icu::UnicodeString icu_pattern(pattern.c_str(), pattern.length());
+        re_ = std::make_unique<icu::RegexMatcher>(icu_pattern, 0, status);
+        ASSERT_TRUE(U_SUCCESS(status));
+
+        for (const char* localized : LOCALIZED_STRINGS)
+        {
+            strings_.push_back(base::UTF8ToUTF16(localized));
+        }
+    }
+
+    // the former runtime path, utf-8 round trip and regex for every string
+    std::u16string regex_rebrand(const std::u16string& src)
+    {
+        std::string res8 = base::UTF16ToUTF8(src);
+        re_->reset(icu::UnicodeString::fromUTF8(res8.c_str()));
+
+        UErrorCode status = U_ZERO_ERROR;
+        icu::UnicodeString replaced_string = re_->replaceAll("Netbox", status);
+        EXPECT_TRUE(U_SUCCESS(status));
+
+        std::string dst8;
+        replaced_string.toUTF8String(dst8);
+
+        return base::UTF8ToUTF16(dst8);
+    }
+
+protected:
+    std::unique_ptr<icu::RegexMatcher> re_;
+    std::vector<std::u16string> strings_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxResourceRebrandPerfTest);
+};
+
+TEST_F(NetboxResourceRebrandPerfTest, SameAsRegex)
+{
+    for (const std::u16string& src : strings_)
+    {
+        std::u16string dst = src;
+        ui::ResourceBundle::rebrand(src, dst);
+
+        ASSERT_EQ(regex_rebrand(src), dst) << src;
+    }
+
+    std::u16string dst;
+    ASSERT_TRUE(ui::ResourceBundle::rebrand(u"Chrome, Chromium and Chrome OS", dst));
+    ASSERT_EQ(u"Netbox, Netbox and Chrome OS", dst);
+    ASSERT_FALSE(ui::ResourceBundle::rebrand(u"Google Chrome", dst));
+    ASSERT_FALSE(ui::ResourceBundle::rebrand(u"Bookmarks", dst));
+}
+
+// timings only, run with --run-manual
+TEST_F(NetboxResourceRebrandPerfTest, MANUAL_LookupCost)
+{
+    // about the string count of a locale pak
+    const size_t lookups_count = 20000;
+
+    base::ElapsedTimer regex_timer;
+    for (size_t i = 0; i < lookups_count; ++i)
+    {
+        regex_rebrand(strings_[i % strings_.size()]);
+    }
+    base::TimeDelta regex = regex_timer.Elapsed();
+
+    base::ElapsedTimer rebrand_timer;
+    size_t rebranded_count = 0;
+    for (size_t i = 0; i < lookups_count; ++i)
+    {
+        std::u16string dst;
+        if (ui::ResourceBundle::rebrand(strings_[i % strings_.size()], dst))
+        {
+            rebranded_count++;
+        }
+    }
+    base::TimeDelta rebrand = rebrand_timer.Elapsed();
+
+    // the table built once the pak is loaded
+    std::vector<std::pair<int, std::u16string>> rebranded;
+    for (size_t i = 0; i < strings_.size(); ++i)
+    {
+        std::u16string dst;
+        if (ui::ResourceBundle::rebrand(strings_[i], dst))
+        {
+            rebranded.emplace_back(static_cast<int>(i), std::move(dst));
+        }
+    }
+    base::flat_map<int, std::u16string> table(base::sorted_unique, std::move(rebranded));
+
+    base::ElapsedTimer table_timer;
+    size_t found_count = 0;
+    for (size_t i = 0; i < lookups_count; ++i)
+    {
+        if (table.find(static_cast<int>(i % strings_.size())) != table.end())
+        {
+            found_count++;
+        }
+    }
+    base::TimeDelta lookup = table_timer.Elapsed();
+
+    ASSERT_EQ(rebranded_count, found_count);
+
+    LOG(INFO) << "localized strings " << lookups_count << ", regex / scan / table, ms: "
+              << regex.InMillisecondsF() << " / " << rebrand.InMillisecondsF() << " / " << lookup.InMillisecondsF();
+}
+
+}
@@ -0,0 +1,234 @@
+#include "chrome/browser/netbox/wallet_manager/wallet_image_cache.h"
+
+#include <algorithm>
+#include <vector>
+
+#include "base/files/file.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/strings/string_util.h"
+#include "base/time/default_clock.h"
+#include "components/netboxglobal_utils/utils.h"
+#include "crypto/sha2.h"
+
+// once over the limit the directory is trimmed well below it, so the scan is not done on every write
+static const int32_t IMAGE_CACHE_TRIM_PERCENT = 75;
+static const size_t MIME_TYPE_MAX_LENGTH = 64;
+
+namespace Netboxglobal
+{
+
+WalletImageCache::WalletImageCache(const base::FilePath& dir, int64_t max_bytes)
+    : dir_(dir), max_bytes_(max_bytes), clock_(base::DefaultClock::GetInstance())
+{
+    DETACH_FROM_SEQUENCE(sequence_checker_);
+}
+
+WalletImageCache::~WalletImageCache()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+}
+
+// static
+std::string WalletImageCache::get_key(const std::string& url)
+{
+    return base::HexEncode(crypto::SHA256HashString(url).data(), crypto::kSHA256Length);
+}
+
+// static
+bool WalletImageCache::is_valid_mime_type(const std::string& mime_type)
+{
+    return mime_type.size() <= MIME_TYPE_MAX_LENGTH
+        && base::StartsWith(mime_type, "image/")
+        && mime_type.find_first_of("\r\n") == std::string::npos;
+}
+
+scoped_refptr<base::RefCountedMemory> WalletImageCache::read(const std::string& url, std::string* mime_type)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    base::FilePath path = get_path(url);
+
+    std::string data;
+    if (!base::ReadFileToString(path, &data))
+    {
+        return nullptr;
+    }
+
+    // files of older versions have no mime type line and are a miss
+    size_t line_end = data.find('\n');
+    if (line_end == std::string::npos || line_end + 1 == data.size() || !is_valid_mime_type(data.substr(0, line_end)))
+    {
+        return nullptr;
+    }
+
+    *mime_type = data.substr(0, line_end);
+    data.erase(0, line_end + 1);
+
+    // modification time is the last use
+    base::Time now = clock_->Now();
+    base::TouchFile(path, now, now);
+
+    return base::RefCountedString::TakeString(&data);
+}
+
+void WalletImageCache::write(const std::string& url, const std::string& mime_type, const std::string& data)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    if (data.empty() || static_cast<int64_t>(data.size()) > max_bytes_ / 4 || !is_valid_mime_type(mime_type))
+    {
+        return;
+    }
+
+    if (!base::CreateDirectory(dir_))
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "image cache, cant create " << dir_;
+        return;
+    }
+
+    load_size();
+
+    base::FilePath path = get_path(url);
+
+    int64_t old_size = 0;
+    if (base::GetFileSize(path, &old_size))
+    {
+        total_bytes_ = total_bytes_ - old_size;
+    }
+
+    std::string mime_type_line = mime_type + "\n";
+
+    bool written = false;
+    {
+        base::File file(path, base::File::FLAG_CREATE_ALWAYS | base::File::FLAG_WRITE);
+        written = file.IsValid()
+               && file.WriteAtCurrentPos(mime_type_line.data(), mime_type_line.size()) == static_cast<int>(mime_type_line.size())
+               && file.WriteAtCurrentPos(data.data(), data.size()) == static_cast<int>(data.size());
+    }
+
+    if (!written)
+    {
+        base::DeleteFile(path);
+        return;
+    }
+
+    base::Time now = clock_->Now();
+    base::TouchFile(path, now, now);
+
+    total_bytes_ = total_bytes_ + mime_type_line.size() + data.size();
+
+    if (total_bytes_ > max_bytes_)
+    {
+        evict();
+    }
+}
+
+std::map<std::string, std::string> WalletImageCache::read_mime_types()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    std::map<std::string, std::string> mime_types;
+
+    base::FileEnumerator files(dir_, false, base::FileEnumerator::FILES);
+    for (base::FilePath path = files.Next(); !path.empty(); path = files.Next())
+    {
+        // only the first line is read
+        char line[MIME_TYPE_MAX_LENGTH + 1];
+        int read = base::ReadFile(path, line, sizeof(line));
+        if (read <= 0)
+        {
+            continue;
+        }
+
+        std::string head(line, read);
+        size_t line_end = head.find('\n');
+        if (line_end == std::string::npos || !is_valid_mime_type(head.substr(0, line_end)))
+        {
+            continue;
+        }
+
+        mime_types[path.BaseName().MaybeAsASCII()] = head.substr(0, line_end);
+    }
+
+    return mime_types;
+}
+
+void WalletImageCache::set_clock_for_testing(base::Clock* clock)
+{
+    clock_ = clock;
+}
+
+int64_t WalletImageCache::get_size_for_testing()
+{
+    load_size();
+
+    return total_bytes_;
+}
+
+base::FilePath WalletImageCache::get_path(const std::string& url)
+{
+    return dir_.AppendASCII(get_key(url));
+}
+
+void WalletImageCache::load_size()
+{
+    if (total_bytes_ >= 0)
+    {
+        return;
+    }
+
+    total_bytes_ = 0;
+
+    base::FileEnumerator files(dir_, false, base::FileEnumerator::FILES);
+    for (base::FilePath path = files.Next(); !path.empty(); path = files.Next())
+    {
+        total_bytes_ = total_bytes_ + files.GetInfo().GetSize();
+    }
+}
+
+void WalletImageCache::evict()
+{
+    struct CachedFile
+    {
+        base::Time used_at;
+        base::FilePath path;
+        int64_t size;
+    };
+
+    std::vector<CachedFile> cached_files;
+
+    total_bytes_ = 0;
+
+    base::FileEnumerator files(dir_, false, base::FileEnumerator::FILES);
+    for (base::FilePath path = files.Next(); !path.empty(); path = files.Next())
+    {
+        cached_files.push_back({files.GetInfo().GetLastModifiedTime(), path, files.GetInfo().GetSize()});
+        total_bytes_ = total_bytes_ + files.GetInfo().GetSize();
+    }
+
+    std::sort(cached_files.begin(), cached_files.end(), [](const CachedFile& a, const CachedFile& b) { return a.used_at < b.used_at; });
+
+    int64_t trim_bytes = max_bytes_ * IMAGE_CACHE_TRIM_PERCENT / 100;
+    size_t deleted = 0;
+
+    for (const CachedFile& cached_file : cached_files)
+    {
+        if (total_bytes_ <= trim_bytes)
+        {
+            break;
+        }
+
+        if (base::DeleteFile(cached_file.path))
+        {
+            total_bytes_ = total_bytes_ - cached_file.size;
+            deleted++;
+        }
+    }
+
+    VLOG(NETBOX_LOG_LEVEL) << "image cache trimmed, files deleted " << deleted << ", bytes left " << total_bytes_;
+}
+
+}
@@ -0,0 +1,62 @@
+#ifndef CHROME_BROWSER_WALLET_IMAGE_CACHE_H_
+#define CHROME_BROWSER_WALLET_IMAGE_CACHE_H_
+
+#include <map>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/macros.h"
+#include "base/memory/ref_counted_memory.h"
+#include "base/sequence_checker.h"
+
+namespace base
+{
+class Clock;
+}
+
+namespace Netboxglobal
+{
+
+// remote images shown by the wallet and news pages, one file per url starting with the mime type line,
+// least recently used files are deleted once the directory grows over the limit
+// blocking, used on a sequence which may block
+class WalletImageCache
+{
+public:
+    WalletImageCache(const base::FilePath& dir, int64_t max_bytes);
+    ~WalletImageCache();
+
+    // file name of the url
+    static std::string get_key(const std::string& url);
+    // only image/ types of a single line are kept
+    static bool is_valid_mime_type(const std::string& mime_type);
+
+    // nullptr on miss
+    scoped_refptr<base::RefCountedMemory> read(const std::string& url, std::string* mime_type);
+    void write(const std::string& url, const std::string& mime_type, const std::string& data);
+    // key to mime type of every cached file, the mime type is asked before the image is read
+    std::map<std::string, std::string> read_mime_types();
+
+    void set_clock_for_testing(base::Clock* clock);
+    int64_t get_size_for_testing();
+
+private:
+    base::FilePath get_path(const std::string& url);
+    // the directory is scanned on first use, the size is kept up to date later
+    void load_size();
+    void evict();
+
+    base::FilePath dir_;
+    int64_t max_bytes_;
+    int64_t total_bytes_ = -1;
+
+    base::Clock* clock_;
+
+    SEQUENCE_CHECKER(sequence_checker_);
+
+    DISALLOW_COPY_AND_ASSIGN(WalletImageCache);
+};
+
+}
+
+#endif
@@ -0,0 +1,130 @@
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/test/simple_test_clock.h"
+#include "chrome/browser/netbox/wallet_manager/wallet_image_cache.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+class NetboxWalletImageCacheTest : public ::testing::Test {
+public:
+    NetboxWalletImageCacheTest() = default;
+    ~NetboxWalletImageCacheTest() override = default;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+
+        clock_.SetNow(base::Time::Now() - base::TimeDelta::FromDays(1));
+
+        cache_ = std::make_unique<WalletImageCache>(temp_dir_.GetPath().Append(FILE_PATH_LITERAL("Images")), 400);
+        cache_->set_clock_for_testing(&clock_);
+    }
+
+    void write(const std::string& url)
+    {
+        clock_.Advance(base::TimeDelta::FromMinutes(1));
+        // 100 bytes on disk with the mime type line
+        cache_->write(url, "image/png", std::string(90, url.back()));
+    }
+
+    bool is_cached(WalletImageCache* cache, const std::string& url)
+    {
+        std::string mime_type;
+        return !!cache->read(url, &mime_type);
+    }
+
+    bool is_cached(const std::string& url)
+    {
+        return is_cached(cache_.get(), url);
+    }
+
+protected:
+    base::ScopedTempDir temp_dir_;
+    base::SimpleTestClock clock_;
+    std::unique_ptr<WalletImageCache> cache_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxWalletImageCacheTest);
+};
+
+TEST_F(NetboxWalletImageCacheTest, ReadWrite)
+{
+    ASSERT_FALSE(is_cached("https://netbox.global/a.png"));
+
+    write("https://netbox.global/a.png");
+
+    std::string mime_type;
+    scoped_refptr<base::RefCountedMemory> data = cache_->read("https://netbox.global/a.png", &mime_type);
+    ASSERT_TRUE(data);
+    ASSERT_EQ(std::string(90, 'g'), std::string(data->front_as<char>(), data->size()));
+    ASSERT_EQ("image/png", mime_type);
+
+    // same url again does not count twice
+    write("https://netbox.global/a.png");
+    ASSERT_EQ(100, cache_->get_size_for_testing());
+
+    // too big to be cached
+    cache_->write("https://netbox.global/big.png", "image/png", std::string(101, 'x'));
+    ASSERT_FALSE(is_cached("https://netbox.global/big.png"));
+}
+
+TEST_F(NetboxWalletImageCacheTest, LeastRecentlyUsedGoFirst)
+{
+    write("https://netbox.global/1");
+    write("https://netbox.global/2");
+    write("https://netbox.global/3");
+
+    clock_.Advance(base::TimeDelta::FromMinutes(1));
+    ASSERT_TRUE(is_cached("https://netbox.global/1"));
+
+    write("https://netbox.global/4");
+    ASSERT_EQ(400, cache_->get_size_for_testing());
+
+    // over the limit, trimmed to three quarters
+    write("https://netbox.global/5");
+    ASSERT_EQ(300, cache_->get_size_for_testing());
+
+    ASSERT_TRUE(is_cached("https://netbox.global/1"));
+    ASSERT_FALSE(is_cached("https://netbox.global/2"));
+    ASSERT_FALSE(is_cached("https://netbox.global/3"));
+    ASSERT_TRUE(is_cached("https://netbox.global/4"));
+    ASSERT_TRUE(is_cached("https://netbox.global/5"));
+}
+
+TEST_F(NetboxWalletImageCacheTest, SizeOfPreviousSession)
+{
+    write("https://netbox.global/1");
+    write("https://netbox.global/2");
+
+    WalletImageCache cache(temp_dir_.GetPath().Append(FILE_PATH_LITERAL("Images")), 400);
+    ASSERT_EQ(200, cache.get_size_for_testing());
+    ASSERT_TRUE(is_cached(&cache, "https://netbox.global/2"));
+}
+
+TEST_F(NetboxWalletImageCacheTest, MimeTypes)
+{
+    cache_->write("https://netbox.global/a", "image/svg+xml", "<svg/>");
+    cache_->write("https://netbox.global/b", "image/jpeg", "jpeg");
+
+    // not an image or not a single line
+    cache_->write("https://netbox.global/c", "text/html", "<html/>");
+    cache_->write("https://netbox.global/d", "image/png\nx", "png");
+    ASSERT_FALSE(is_cached("https://netbox.global/c"));
+    ASSERT_FALSE(is_cached("https://netbox.global/d"));
+
+    std::map<std::string, std::string> mime_types = cache_->read_mime_types();
+    ASSERT_EQ(2u, mime_types.size());
+    ASSERT_EQ("image/svg+xml", mime_types[WalletImageCache::get_key("https://netbox.global/a")]);
+    ASSERT_EQ("image/jpeg", mime_types[WalletImageCache::get_key("https://netbox.global/b")]);
+
+    // a file of an older version has no mime type line
+    ASSERT_TRUE(base::WriteFile(temp_dir_.GetPath().Append(FILE_PATH_LITERAL("Images")).AppendASCII(WalletImageCache::get_key("https://netbox.global/e")), "\x89PNG"));
+    ASSERT_FALSE(is_cached("https://netbox.global/e"));
+    ASSERT_EQ(2u, cache_->read_mime_types().size());
+}
+
+}
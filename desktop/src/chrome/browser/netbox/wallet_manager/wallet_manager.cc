@@ -1,14 +1,18 @@
 #include "chrome/browser/netbox/wallet_manager/wallet_manager.h"
 
+#include <algorithm>
+
 #include "base/json/json_reader.h"
 #include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/metrics/histogram_functions.h"
 #include "base/task/post_task.h"
 #include "base/task/task_traits.h"
 #include "base/base64.h"
 #include "chrome/browser/browser_process.h"
 #include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/browser/chrome_notification_types.h"
+#include "chrome/browser/netbox/call/wallet_api_encryption.h"
 #include "chrome/browser/ui/webui/wallet/wallet_dom_handler.h"
 #include "chrome/browser/transaction_service/transaction_service.h"
 #include "content/public/browser/storage_partition.h"
@@ -33,6 +37,8 @@ static const int32_t REQUEST_FIRST_ADDRESS_DEFAULT_INTERVAL_SEC = 5;
 
 static const int32_t WALLET_PROCESS_RESTART_DELAY = 5;
 
+static const int32_t READ_CALL_MAX_RETRIES = 2;
+
 namespace Netboxglobal
 {
 
@@ -65,14 +71,48 @@ WalletManager::WalletManager() : request_first_address_web_interval_sec_(REQUEST
         "vote_dapp_for_revert",
         "wallet_images"
     };
+
+    // calls without side effects, tabs ask for them on every refresh,
+    // getfirstaddress is not here, the ping has no handler and a follower without one only gets dropped
+    coalesce_methods_white_list =
+    {
+        "buy_status",
+        "getbalance",
+        "getblockchaininfo",
+        "get_dapp",
+        "get_dapp_config",
+        "get_dapp_thumbnails",
+        "get_dapps_info",
+        "get_system_addresses",
+        "get_system_addresses2",
+        "get_system_features",
+        "lottery_address",
+        "lottery_last_pending_block",
+        "staking_status",
+        "wallet_images"
+    };
+
+    // rpc reads the wallet tab sends together on load
+    batch_methods_white_list =
+    {
+        "getbalance",
+        "getbestblockhash",
+        "getblockchaininfo",
+        "getblockcount",
+        "getblockheader",
+        "getwalletinfo",
+        "mnsync"
+    };
 }
 
 WalletManager::~WalletManager()
 {
 }
 
-bool WalletManager::start()
+bool WalletManager::start(base::FilePath profile_path)
 {
+    response_cache_.set_persist_path(profile_path.Append(FILE_PATH_LITERAL("Wallet Response Cache")));
+
     g_browser_process->env_controller()->add_data_observer(std::bind(&WalletManager::on_environment_ready, this, std::placeholders::_1, std::placeholders::_2));
 
     return true;
@@ -103,6 +143,63 @@ void WalletManager::remove_handler(IWalletTabHandler* handler)
 
         handlers_.erase(handler);
     }
+
+    cancel_handler_calls(handler);
+}
+
+void WalletManager::cancel_handler_calls(IWalletTabHandler* handler)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    // followers of a closed tab do not wait for the answer anymore
+    for (auto& coalesced : ui_coalesced_calls_)
+    {
+        std::vector<std::unique_ptr<WalletHttpCallSignature>>& calls = coalesced.second;
+        calls.erase(std::remove_if(calls.begin(), calls.end(),
+            [handler](const std::unique_ptr<WalletHttpCallSignature>& call) { return call->get_ui_handler() == handler; }),
+            calls.end());
+    }
+
+    // only side effect free reads are cancelled, and only when no other tab waits for them,
+    // deleting the request stops the download and frees its dispatcher slot
+    size_t cancelled = 0;
+    for (auto it = ui_request_handlers_.begin(); it != ui_request_handlers_.end();)
+    {
+        auto current = it++;
+        if (current->second != handler)
+        {
+            continue;
+        }
+
+        WalletRequest* http_request_ptr = current->first;
+        ui_request_handlers_.erase(current);
+
+        auto key_it = ui_coalesce_keys_.find(http_request_ptr);
+        if (key_it == ui_coalesce_keys_.end())
+        {
+            continue;
+        }
+
+        auto calls_it = ui_coalesced_calls_.find(key_it->second);
+        if (calls_it != ui_coalesced_calls_.end())
+        {
+            if (!calls_it->second.empty())
+            {
+                continue;
+            }
+
+            ui_coalesced_calls_.erase(calls_it);
+        }
+
+        ui_coalesce_keys_.erase(key_it);
+        ui_requests_.erase(http_request_ptr);
+        cancelled++;
+    }
+
+    if (cancelled)
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "tab closed, wallet calls cancelled " << cancelled;
+    }
 }
 
 void WalletManager::on_environment_ready(WalletSessionManager::DataState data_state, const WalletSessionManager::Data &data)
@@ -246,6 +343,7 @@ void WalletManager::initialize_rpc_first_address()
 	std::unique_ptr<Netboxglobal::WalletHttpCallSignature> signature(new Netboxglobal::WalletHttpCallSignature(Netboxglobal::WalletHttpCallType::RPC_JSON));
 	signature->set_method_name("getfirstaddress");
 	signature->set_params(base::Value(base::Value::Type::LIST));
+	signature->set_priority(WalletCallPriority::POLLING);
 
 	request_http(std::move(signature));
 }
@@ -254,6 +352,9 @@ void WalletManager::notify_auth()
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
+    // signed api answers belong to the session which is gone
+    response_cache_.clear();
+
     base::Value result(base::Value::Type::DICTIONARY);
     result.SetKey("is_auth", base::Value(false));
     if (g_browser_process->env_controller()->is_qa())
@@ -340,6 +441,7 @@ void WalletManager::request_balance()
 	std::unique_ptr<Netboxglobal::WalletHttpCallSignature> signature(new Netboxglobal::WalletHttpCallSignature(Netboxglobal::WalletHttpCallType::RPC_JSON));
 	signature->set_method_name("getbalance");
 	signature->set_params(base::Value(base::Value::Type::LIST));
+	signature->set_priority(WalletCallPriority::POLLING);
 
 	request_http(std::move(signature));
 }
@@ -358,6 +460,16 @@ void WalletManager::service(IWalletTabHandler* handler, std::string method_name,
         return g_browser_process->transaction_service()->ui_get_transactions(std::move(request));
     }
 
+    if ("transactions_summary" == method_name)
+    {
+        std::unique_ptr<WalletHttpCallSignature> request(new WalletHttpCallSignature(WalletHttpCallType::RPC_JSON));
+        request->set_event_name(event_name);
+        request->set_ui_handler(handler);
+        request->set_params(std::move(params));
+
+        return g_browser_process->transaction_service()->ui_get_transactions_summary(std::move(request));
+    }
+
 	if ("preshow" == method_name)
 	{
 		Netboxglobal::preshowwallet();
@@ -388,9 +500,6 @@ void WalletManager::request_http(std::unique_ptr<WalletHttpCallSignature> &&sign
 {
 	DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
-    std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
-    WalletRequest* http_request_ptr = http_request.get();
-
     if (g_browser_process->env_controller()->is_qa())
     {
         signature->set_qa(true);
@@ -447,10 +556,244 @@ void WalletManager::request_http(std::unique_ptr<WalletHttpCallSignature> &&sign
 		signature->append_param("first_address", base::Value(first_address_));
 	}
 
-    http_request->start(std::move(signature),
-        base::BindOnce(&WalletManager::on_http_response, base::Unretained(this)));
+    response_cache_.invalidate_for(signature->get_type(), signature->get_method_name(), get_cache_address(signature.get()));
+
+    std::string coalesce_key = get_coalesce_key(signature.get());
+    if (!coalesce_key.empty() && !response_cache_.get_ttl(signature->get_type(), signature->get_method_name()).is_zero())
+    {
+        bool is_stale = false;
+        const base::Value* cached = response_cache_.find(coalesce_key, &is_stale);
+
+        base::UmaHistogramBoolean("Netbox.WalletManager.ResponseCacheHit." + signature->get_type_name(), cached);
+
+        if (cached)
+        {
+            // a cached answer after a restart has to switch the encryption on as well
+            if ("get_system_features" == signature->get_method_name())
+            {
+                end_get_system_features(cached);
+            }
+
+            IWalletTabHandler* handler = signature->get_ui_handler();
+            if (handler)
+            {
+                end_http_call(handler, cached->Clone(), signature->get_event_name());
+            }
+
+            if (!is_stale)
+            {
+                return;
+            }
+
+            // stale while revalidate, the fresh answer comes to the tab as the same event again
+        }
+    }
+
+    if (!coalesce_key.empty())
+    {
+        std::string histogram_name = "Netbox.WalletManager.RequestCoalesced." + signature->get_type_name();
+
+        auto coalesced_it = ui_coalesced_calls_.find(coalesce_key);
+        if (coalesced_it != ui_coalesced_calls_.end())
+        {
+            base::UmaHistogramBoolean(histogram_name, true);
+
+            coalesced_it->second.push_back(std::move(signature));
+            return;
+        }
+
+        base::UmaHistogramBoolean(histogram_name, false);
+
+        ui_coalesced_calls_[coalesce_key];
+    }
+
+    if (is_batchable(signature.get()))
+    {
+        // tabs ask for a burst of rpc reads on load, the ones of the same turn go as one batch
+        if (ui_pending_batch_.empty())
+        {
+            base::PostTask(
+                FROM_HERE,
+                {
+                    content::BrowserThread::UI,
+                    base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
+                },
+                base::BindOnce(&WalletManager::flush_batch, base::Unretained(this))
+            );
+        }
+
+        ui_pending_batch_.push_back(std::move(signature));
+        ui_pending_batch_keys_.push_back(coalesce_key);
+        return;
+    }
+
+    start_http_request(std::move(signature), coalesce_key, std::vector<std::string>());
+}
+
+void WalletManager::start_http_request(std::unique_ptr<WalletHttpCallSignature> signature, const std::string& coalesce_key, std::vector<std::string> batch_keys)
+{
+    std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
+    WalletRequest* http_request_ptr = http_request.get();
+
+    if (!batch_keys.empty())
+    {
+        ui_batch_keys_[http_request_ptr] = std::move(batch_keys);
+    }
+
+    if (!coalesce_key.empty())
+    {
+        ui_coalesce_keys_[http_request_ptr] = coalesce_key;
+
+        if (signature->get_ui_handler())
+        {
+            ui_request_handlers_[http_request_ptr] = signature->get_ui_handler();
+        }
+
+        // reads are idempotent, a restarting wallet or a gateway error is retried
+        signature->set_max_retries(READ_CALL_MAX_RETRIES);
+    }
 
+    http_request->set_decode_in_background(true);
+
+    // the request may be answered and deleted inside start, everything it is looked up by is registered before
     ui_requests_[http_request_ptr] = std::move(http_request);
+
+    http_request_ptr->start(std::move(signature),
+        base::BindOnce(&WalletManager::on_http_response, base::Unretained(this)));
+}
+
+bool WalletManager::is_batchable(WalletHttpCallSignature* signature)
+{
+    if (WalletHttpCallType::RPC_JSON != signature->get_type())
+    {
+        return false;
+    }
+
+    if (signature->get_stream_parser() || signature->has_external_signature())
+    {
+        return false;
+    }
+
+    return batch_methods_white_list.end() != batch_methods_white_list.find(signature->get_method_name());
+}
+
+void WalletManager::flush_batch()
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    std::vector<std::unique_ptr<WalletHttpCallSignature>> calls = std::move(ui_pending_batch_);
+    std::vector<std::string> keys = std::move(ui_pending_batch_keys_);
+    ui_pending_batch_.clear();
+    ui_pending_batch_keys_.clear();
+
+    if (calls.empty())
+    {
+        return;
+    }
+
+    base::UmaHistogramCounts100("Netbox.WalletManager.RpcBatchSize", calls.size());
+
+    if (1 == calls.size())
+    {
+        start_http_request(std::move(calls[0]), keys[0], std::vector<std::string>());
+        return;
+    }
+
+    std::unique_ptr<WalletHttpCallSignature> batch_signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_BATCH);
+
+    // the batch goes as soon as its most urgent call
+    WalletCallPriority priority = WalletCallPriority::PRIORITY_COUNT;
+    for (std::unique_ptr<WalletHttpCallSignature>& call : calls)
+    {
+        priority = std::min(priority, call->get_priority());
+    }
+    batch_signature->set_priority(priority);
+
+    // every call got the same token in request_http
+    batch_signature->set_rpc_token(calls[0]->get_rpc_token());
+    batch_signature->set_qa(g_browser_process->env_controller()->is_qa());
+
+    for (std::unique_ptr<WalletHttpCallSignature>& call : calls)
+    {
+        batch_signature->add_batch_call(std::move(call));
+    }
+
+    // only reads are batched
+    batch_signature->set_max_retries(READ_CALL_MAX_RETRIES);
+
+    start_http_request(std::move(batch_signature), "", std::move(keys));
+}
+
+std::string WalletManager::get_coalesce_key(WalletHttpCallSignature* signature)
+{
+    // streamed and chained calls carry per-caller state
+    if (signature->get_stream_parser() || signature->has_external_signature())
+    {
+        return "";
+    }
+
+    if (WalletHttpCallType::API_EXPLORER == signature->get_type())
+    {
+        // explorer reads only, wallet creation and sending go through every time
+        if ("w/create" == signature->get_method_name() || "tx/send" == signature->get_method_name())
+        {
+            return "";
+        }
+    }
+    else if (coalesce_methods_white_list.end() == coalesce_methods_white_list.find(signature->get_method_name()))
+    {
+        return "";
+    }
+
+    // dictionary keys are sorted, so equal params give equal json
+    std::string params_json;
+    if (!base::JSONWriter::Write(signature->get_params(), &params_json))
+    {
+        return "";
+    }
+
+    return signature->get_type_name() + "|" + signature->get_method_name() + "|" + params_json;
+}
+
+std::string WalletManager::get_cache_address(WalletHttpCallSignature* signature)
+{
+    if (WalletHttpCallType::API_EXPLORER != signature->get_type() || !signature->get_params().is_dict())
+    {
+        return "";
+    }
+
+    const std::string* address = signature->get_params().FindStringKey("address");
+
+    return address ? *address : "";
+}
+
+void WalletManager::end_coalesced_calls(const std::string& coalesce_key, const base::Value& results)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    if (coalesce_key.empty())
+    {
+        return;
+    }
+
+    auto calls_it = ui_coalesced_calls_.find(coalesce_key);
+    if (calls_it == ui_coalesced_calls_.end())
+    {
+        return;
+    }
+
+    // later callers only need the answer, side effects of the response were done for the first one
+    std::vector<std::unique_ptr<WalletHttpCallSignature>> calls = std::move(calls_it->second);
+    ui_coalesced_calls_.erase(calls_it);
+
+    for (std::unique_ptr<WalletHttpCallSignature>& call : calls)
+    {
+        IWalletTabHandler* handler = call->get_ui_handler();
+        if (handler)
+        {
+            end_http_call(handler, results.Clone(), call->get_event_name());
+        }
+    }
 }
 
 void WalletManager::on_http_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results, WalletRequest* http_request_ptr)
@@ -471,6 +814,60 @@ void WalletManager::on_http_response(std::unique_ptr<WalletHttpCallSignature> si
 		}
 	}
 
+    if (WalletHttpCallType::RPC_BATCH == signature->get_type())
+    {
+        std::vector<std::string> keys;
+
+        auto batch_it = ui_batch_keys_.find(http_request_ptr);
+        if (batch_it != ui_batch_keys_.end())
+        {
+            keys = std::move(batch_it->second);
+            ui_batch_keys_.erase(batch_it);
+        }
+
+        std::vector<std::unique_ptr<WalletHttpCallSignature>> calls = signature->take_batch_calls();
+        for (size_t i = 0; i < calls.size(); ++i)
+        {
+            base::Value call_results = WalletHttpCallSignature::take_batch_result(results, i);
+
+            // a failed batch restarts the wallet once, not once per call
+            if (i > 0 && !results.is_list() && call_results.is_dict())
+            {
+                call_results.RemoveKey("netboxrestart");
+            }
+
+            process_http_response(std::move(calls[i]), std::move(call_results), i < keys.size() ? keys[i] : "");
+        }
+
+        return;
+    }
+
+    ui_request_handlers_.erase(http_request_ptr);
+
+    std::string coalesce_key;
+
+    auto key_it = ui_coalesce_keys_.find(http_request_ptr);
+    if (key_it != ui_coalesce_keys_.end())
+    {
+        coalesce_key = std::move(key_it->second);
+        ui_coalesce_keys_.erase(key_it);
+    }
+
+    process_http_response(std::move(signature), std::move(results), coalesce_key);
+}
+
+void WalletManager::process_http_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results, const std::string& coalesce_key)
+{
+    if (!coalesce_key.empty() && results.is_dict() && !results.FindKey("error"))
+    {
+        response_cache_.store(coalesce_key, signature->get_type(), signature->get_method_name(), get_cache_address(signature.get()), results);
+    }
+
+    end_coalesced_calls(coalesce_key, results);
+
+	// answers read before the mutating call finished are dropped as well
+	response_cache_.invalidate_for(signature->get_type(), signature->get_method_name(), get_cache_address(signature.get()));
+
     if (WalletHttpCallType::API_SIGNED == signature->get_type() && results.is_dict())
     {
 
@@ -479,6 +876,11 @@ void WalletManager::on_http_response(std::unique_ptr<WalletHttpCallSignature> si
         {
             notify_auth();
         }
+
+        if ("get_system_features" == signature->get_method_name() && absl::nullopt == error)
+        {
+            end_get_system_features(&results);
+        }
     }
 
 	if (WalletHttpCallType::RPC_JSON == signature->get_type())
@@ -542,6 +944,18 @@ void WalletManager::end_http_call(IWalletTabHandler* handler, base::Value data,
     }
 }
 
+void WalletManager::end_get_system_features(const base::Value* json_data)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    // old servers do not send it and keep getting rsa blocks
+    absl::optional<int> encryption_version = json_data->FindIntKey("api_encryption_version");
+    if (absl::nullopt != encryption_version)
+    {
+        set_api_encryption_version(*encryption_version);
+    }
+}
+
 void WalletManager::end_get_balance_rpc(const base::Value* json_data)
 {
 	DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
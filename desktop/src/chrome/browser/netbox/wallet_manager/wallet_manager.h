@@ -2,11 +2,13 @@
 #define CHROME_BROWSER_WALLET_MANAGER_H_
 
 #include "base/callback.h"
+#include "base/files/file_path.h"
 #include "base/timer/timer.h"
 #include "base/values.h"
 #include "chrome/browser/netbox/environment/controller/wallet_environment.h"
 #include "chrome/browser/netbox/call/wallet_http_call_signature.h"
 #include "chrome/browser/netbox/call/wallet_tab_handler.h"
+#include "chrome/browser/netbox/wallet_manager/wallet_response_cache.h"
 #include "content/public/browser/notification_observer.h"
 #include "content/public/browser/notification_registrar.h"
 #include "net/cookies/canonical_cookie.h"
@@ -63,7 +65,7 @@ public:
     WalletManager();
     ~WalletManager();
 
-    bool start();
+    bool start(base::FilePath profile_path);
     bool stop();
 
     void add_registrars();
@@ -105,13 +107,43 @@ private:
     // end_rpc_functions_XXX
     void end_ping_first_address_rpc(const base::Value* json_data);
     void end_get_balance_rpc(const base::Value* json_data);
+    // network and cached answers
+    void end_get_system_features(const base::Value* json_data);
 
     //void set_new_wallet_status(WalletStatus new_val, WalletConfigureAction = WCA_NONE);
 
 
 	void on_http_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results, WalletRequest* http_request_ptr);
 
+    // single-flight, identical read calls share one request while it is in flight
+    std::string get_coalesce_key(WalletHttpCallSignature* signature);
+    // address of an explorer call, the response cache keeps its reads per address
+    std::string get_cache_address(WalletHttpCallSignature* signature);
+    void end_coalesced_calls(const std::string& coalesce_key, const base::Value& results);
+
+    // batch_keys are the coalesce keys of the calls of an RPC_BATCH signature
+    void start_http_request(std::unique_ptr<WalletHttpCallSignature> signature, const std::string& coalesce_key, std::vector<std::string> batch_keys);
+    void process_http_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results, const std::string& coalesce_key);
+
+    // rpc reads of one ui turn are sent as one json-rpc batch
+    bool is_batchable(WalletHttpCallSignature* signature);
+    void flush_batch();
+
 	std::map<WalletRequest*, std::unique_ptr<WalletRequest>> ui_requests_;
+    std::map<WalletRequest*, std::string> ui_coalesce_keys_;
+    std::map<std::string, std::vector<std::unique_ptr<WalletHttpCallSignature>>> ui_coalesced_calls_;
+    std::unordered_set<std::string> coalesce_methods_white_list;
+
+    std::vector<std::unique_ptr<WalletHttpCallSignature>> ui_pending_batch_;
+    std::vector<std::string> ui_pending_batch_keys_;
+    std::map<WalletRequest*, std::vector<std::string>> ui_batch_keys_;
+    std::unordered_set<std::string> batch_methods_white_list;
+
+    // leader tab of the in flight reads, closing it cancels them
+    void cancel_handler_calls(IWalletTabHandler* handler);
+    std::map<WalletRequest*, IWalletTabHandler*> ui_request_handlers_;
+
+    WalletResponseCache response_cache_;
 
     //update_balance_callback update_balance_callback_;
     base::RepeatingTimer polling_timer_;
@@ -0,0 +1,416 @@
+#include "chrome/browser/netbox/wallet_manager/wallet_response_cache.h"
+
+#include "base/bind.h"
+#include "base/files/file_util.h"
+#include "base/json/json_reader.h"
+#include "base/json/json_writer.h"
+#include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "base/time/default_clock.h"
+#include "components/netboxglobal_utils/utils.h"
+
+static const size_t RESPONSE_CACHE_MAX_BYTES = 2 * 1024 * 1024;
+
+static const int32_t RESPONSE_CACHE_WRITE_DELAY_SEC = 10;
+
+namespace Netboxglobal
+{
+
+struct MethodTtl
+{
+    const char* method_name;
+    int32_t ttl_sec;
+    // an older answer is still shown for this many ttls while it is revalidated,
+    // never for the ones a payment or a balance is built from
+    int32_t max_stale_ttls;
+};
+
+// signed api reads
+static const MethodTtl SIGNED_API_TTLS[] =
+{
+    {"buy_status",                  15,     0},
+    {"get_dapp",                    60,     4},
+    {"get_dapp_config",             300,    4},
+    {"get_dapp_thumbnails",         300,    4},
+    {"get_dapps_info",              60,     4},
+    {"get_system_addresses",        600,    0},
+    {"get_system_addresses2",       600,    0},
+    {"get_system_features",         600,    4},
+    {"lottery_address",             600,    0},
+    {"lottery_last_pending_block",  30,     0},
+    {"staking_status",              30,     0},
+    {"wallet_images",               1800,   4}
+};
+
+// balances and unspent outputs, never shown stale
+static const int32_t EXPLORER_TTL_SEC = 30;
+
+static const MethodTtl* find_signed_api_ttl(const std::string& method_name)
+{
+    for (const MethodTtl& method_ttl : SIGNED_API_TTLS)
+    {
+        if (method_name == method_ttl.method_name)
+        {
+            return &method_ttl;
+        }
+    }
+
+    return nullptr;
+}
+
+// dependent method lists end with nullptr
+static const char* const DAPP_METHODS[] = {"get_dapp", "get_dapp_config", "get_dapp_thumbnails", "get_dapps_info", "wallet_images", nullptr};
+static const char* const DAPP_VOTE_METHODS[] = {"get_dapp", "get_dapps_info", nullptr};
+static const char* const BUY_METHODS[] = {"buy_status", nullptr};
+static const char* const STAKING_METHODS[] = {"staking_status", nullptr};
+
+struct MethodDependents
+{
+    const char* method_name;
+    const char* const* dependents;
+};
+
+static const MethodDependents MUTATING_METHODS[] =
+{
+    {"add_dapp",                    DAPP_METHODS},
+    {"add_dapp_image",              DAPP_METHODS},
+    {"buy",                         BUY_METHODS},
+    {"delete_dapp",                 DAPP_METHODS},
+    {"edit_dapp",                   DAPP_METHODS},
+    {"stake",                       STAKING_METHODS},
+    {"unstake",                     STAKING_METHODS},
+    {"vote_dapp_against",           DAPP_VOTE_METHODS},
+    {"vote_dapp_against_revert",    DAPP_VOTE_METHODS},
+    {"vote_dapp_for",               DAPP_VOTE_METHODS},
+    {"vote_dapp_for_revert",        DAPP_VOTE_METHODS}
+};
+
+absl::optional<base::Value> read_persisted_cache(base::FilePath path)
+{
+    std::string data;
+    if (!base::ReadFileToString(path, &data))
+    {
+        return absl::nullopt;
+    }
+
+    return base::JSONReader::Read(data);
+}
+
+WalletResponseCache::WalletResponseCache() : clock_(base::DefaultClock::GetInstance())
+{
+}
+
+WalletResponseCache::~WalletResponseCache()
+{
+    if (writer_ && writer_->HasPendingWrite())
+    {
+        writer_->DoScheduledWrite();
+    }
+}
+
+void WalletResponseCache::set_persist_path(const base::FilePath& path)
+{
+    file_task_runner_ = base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock(), base::TaskPriority::BEST_EFFORT, base::TaskShutdownBehavior::BLOCK_SHUTDOWN});
+    writer_ = std::make_unique<base::ImportantFileWriter>(path, file_task_runner_, base::TimeDelta::FromSeconds(RESPONSE_CACHE_WRITE_DELAY_SEC));
+
+    file_task_runner_->PostTaskAndReplyWithResult(FROM_HERE,
+        base::BindOnce(&read_persisted_cache, path),
+        base::BindOnce(&WalletResponseCache::on_loaded, weak_factory_.GetWeakPtr()));
+}
+
+base::TimeDelta WalletResponseCache::get_ttl(WalletHttpCallType type, const std::string& method_name)
+{
+    if (WalletHttpCallType::API_EXPLORER == type)
+    {
+        if ("w/create" == method_name || "tx/send" == method_name)
+        {
+            return base::TimeDelta();
+        }
+
+        return base::TimeDelta::FromSeconds(EXPLORER_TTL_SEC);
+    }
+
+    if (WalletHttpCallType::API_SIGNED != type)
+    {
+        return base::TimeDelta();
+    }
+
+    const MethodTtl* method_ttl = find_signed_api_ttl(method_name);
+
+    return method_ttl ? base::TimeDelta::FromSeconds(method_ttl->ttl_sec) : base::TimeDelta();
+}
+
+base::TimeDelta WalletResponseCache::get_max_stale(WalletHttpCallType type, const std::string& method_name)
+{
+    if (WalletHttpCallType::API_SIGNED != type)
+    {
+        return base::TimeDelta();
+    }
+
+    const MethodTtl* method_ttl = find_signed_api_ttl(method_name);
+
+    return method_ttl ? base::TimeDelta::FromSeconds(method_ttl->ttl_sec * method_ttl->max_stale_ttls) : base::TimeDelta();
+}
+
+const base::Value* WalletResponseCache::find(const std::string& key, bool* is_stale)
+{
+    auto it = entries_.find(key);
+    if (it == entries_.end())
+    {
+        return nullptr;
+    }
+
+    base::TimeDelta age = clock_->Now() - it->second.stored_at;
+    if (age > it->second.ttl + it->second.max_stale)
+    {
+        erase(it);
+        return nullptr;
+    }
+
+    *is_stale = age > it->second.ttl;
+
+    lru_.splice(lru_.begin(), lru_, it->second.lru_it);
+
+    return &it->second.value;
+}
+
+void WalletResponseCache::store(const std::string& key, WalletHttpCallType type, const std::string& method_name, const std::string& address, const base::Value& value)
+{
+    base::TimeDelta ttl = get_ttl(type, method_name);
+    if (ttl.is_zero())
+    {
+        return;
+    }
+
+    // the json size is what the entry costs on disk, close enough for memory too
+    std::string value_json;
+    if (!base::JSONWriter::Write(value, &value_json) || value_json.size() > RESPONSE_CACHE_MAX_BYTES / 4)
+    {
+        return;
+    }
+
+    insert(key, method_name, WalletHttpCallType::API_EXPLORER == type ? address : "", value.Clone(), clock_->Now(), ttl,
+           get_max_stale(type, method_name), key.size() + value_json.size());
+    schedule_write();
+}
+
+void WalletResponseCache::invalidate_for(WalletHttpCallType type, const std::string& method_name, const std::string& address)
+{
+    if (WalletHttpCallType::API_EXPLORER == type)
+    {
+        if ("w/create" != method_name && "tx/send" != method_name)
+        {
+            return;
+        }
+
+        // balance and unspent outputs of the address are not valid anymore
+        bool erased = false;
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            auto current = it++;
+
+            if (!current->second.address.empty() && (address.empty() || address == current->second.address))
+            {
+                erase(current);
+                erased = true;
+            }
+        }
+
+        if (erased)
+        {
+            VLOG(NETBOX_LOG_LEVEL) << "response cache invalidated by " << method_name;
+            schedule_write();
+        }
+
+        return;
+    }
+
+    for (const MethodDependents& mutating : MUTATING_METHODS)
+    {
+        if (method_name != mutating.method_name)
+        {
+            continue;
+        }
+
+        bool erased = false;
+        for (auto it = entries_.begin(); it != entries_.end();)
+        {
+            auto current = it++;
+
+            for (const char* const* dependent = mutating.dependents; *dependent; ++dependent)
+            {
+                if (current->second.method_name == *dependent)
+                {
+                    erase(current);
+                    erased = true;
+                    break;
+                }
+            }
+        }
+
+        if (erased)
+        {
+            VLOG(NETBOX_LOG_LEVEL) << "response cache invalidated by " << method_name;
+            schedule_write();
+        }
+
+        return;
+    }
+}
+
+void WalletResponseCache::clear()
+{
+    // the previous session may still be loading
+    weak_factory_.InvalidateWeakPtrs();
+
+    entries_.clear();
+    lru_.clear();
+    total_size_ = 0;
+
+    if (writer_)
+    {
+        writer_->ScheduleWrite(this);
+        writer_->DoScheduledWrite();
+    }
+
+    VLOG(NETBOX_LOG_LEVEL) << "response cache cleared";
+}
+
+void WalletResponseCache::set_clock_for_testing(base::Clock* clock)
+{
+    clock_ = clock;
+}
+
+size_t WalletResponseCache::get_size_for_testing()
+{
+    return total_size_;
+}
+
+bool WalletResponseCache::SerializeData(std::string* data)
+{
+    base::Value entries(base::Value::Type::LIST);
+
+    for (const std::string& key : lru_)
+    {
+        const Entry& entry = entries_[key];
+
+        base::Value persisted(base::Value::Type::DICTIONARY);
+        persisted.SetStringKey("key",          key);
+        persisted.SetStringKey("method",       entry.method_name);
+        persisted.SetStringKey("address",      entry.address);
+        persisted.SetStringKey("stored_at",    base::NumberToString(entry.stored_at.ToDeltaSinceWindowsEpoch().InMicroseconds()));
+        persisted.SetStringKey("ttl",          base::NumberToString(entry.ttl.InSeconds()));
+        persisted.SetStringKey("max_stale",    base::NumberToString(entry.max_stale.InSeconds()));
+        persisted.SetKey("value",              entry.value.Clone());
+
+        entries.Append(std::move(persisted));
+    }
+
+    base::Value root(base::Value::Type::DICTIONARY);
+    root.SetKey("entries", std::move(entries));
+
+    return base::JSONWriter::Write(root, data);
+}
+
+void WalletResponseCache::insert(const std::string& key, const std::string& method_name, const std::string& address, base::Value value, base::Time stored_at,
+                                 base::TimeDelta ttl, base::TimeDelta max_stale, size_t size)
+{
+    auto it = entries_.find(key);
+    if (it != entries_.end())
+    {
+        erase(it);
+    }
+
+    lru_.push_front(key);
+
+    Entry& entry = entries_[key];
+    entry.method_name   = method_name;
+    entry.address       = address;
+    entry.value         = std::move(value);
+    entry.stored_at     = stored_at;
+    entry.ttl           = ttl;
+    entry.max_stale     = max_stale;
+    entry.size          = size;
+    entry.lru_it        = lru_.begin();
+
+    total_size_ = total_size_ + size;
+
+    while (total_size_ > RESPONSE_CACHE_MAX_BYTES && !lru_.empty())
+    {
+        erase(entries_.find(lru_.back()));
+    }
+}
+
+void WalletResponseCache::erase(std::map<std::string, Entry>::iterator it)
+{
+    total_size_ = total_size_ - it->second.size;
+    lru_.erase(it->second.lru_it);
+    entries_.erase(it);
+}
+
+void WalletResponseCache::on_loaded(absl::optional<base::Value> persisted)
+{
+    if (!persisted || !persisted->is_dict())
+    {
+        return;
+    }
+
+    const base::Value* entries = persisted->FindListKey("entries");
+    if (!entries)
+    {
+        return;
+    }
+
+    // most recently used first, so walk back to keep the order
+    base::Value::ConstListView list = entries->GetList();
+    for (auto it = list.rbegin(); it != list.rend(); ++it)
+    {
+        const std::string* key          = it->FindStringKey("key");
+        const std::string* method_name  = it->FindStringKey("method");
+        const std::string* address      = it->FindStringKey("address");
+        const std::string* stored_at    = it->FindStringKey("stored_at");
+        const std::string* ttl          = it->FindStringKey("ttl");
+        const std::string* max_stale    = it->FindStringKey("max_stale");
+        const base::Value* value        = it->FindKey("value");
+
+        int64_t stored_at_us = 0;
+        int64_t ttl_sec = 0;
+        int64_t max_stale_sec = 0;
+
+        // entries written before the address and the stale window were kept are dropped
+        if (!key || !method_name || !address || !stored_at || !ttl || !max_stale || !value
+         || !base::StringToInt64(*stored_at, &stored_at_us)
+         || !base::StringToInt64(*ttl, &ttl_sec)
+         || !base::StringToInt64(*max_stale, &max_stale_sec))
+        {
+            continue;
+        }
+
+        // answers which came in this session are newer
+        if (entries_.count(*key))
+        {
+            continue;
+        }
+
+        std::string value_json;
+        base::JSONWriter::Write(*value, &value_json);
+
+        insert(*key, *method_name, address ? *address : "", value->Clone(),
+               base::Time::FromDeltaSinceWindowsEpoch(base::TimeDelta::FromMicroseconds(stored_at_us)),
+               base::TimeDelta::FromSeconds(ttl_sec), base::TimeDelta::FromSeconds(max_stale_sec), key->size() + value_json.size());
+    }
+
+    VLOG(NETBOX_LOG_LEVEL) << "response cache loaded, entries " << entries_.size();
+}
+
+void WalletResponseCache::schedule_write()
+{
+    if (writer_)
+    {
+        writer_->ScheduleWrite(this);
+    }
+}
+
+}
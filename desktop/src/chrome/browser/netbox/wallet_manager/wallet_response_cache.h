@@ -0,0 +1,96 @@
+#ifndef CHROME_BROWSER_WALLET_RESPONSE_CACHE_H_
+#define CHROME_BROWSER_WALLET_RESPONSE_CACHE_H_
+
+#include <list>
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/files/file_path.h"
+#include "base/files/important_file_writer.h"
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
+#include "base/time/time.h"
+#include "base/values.h"
+#include "chrome/browser/netbox/call/wallet_http_call_signature.h"
+
+namespace base
+{
+class Clock;
+}
+
+namespace Netboxglobal
+{
+
+// answers of idempotent signed api and explorer calls, ui thread only
+// fresh entries are served as is, stale ones are served for a few ttls of their method while the caller revalidates them
+class WalletResponseCache : public base::ImportantFileWriter::DataSerializer
+{
+public:
+    WalletResponseCache();
+    ~WalletResponseCache() override;
+
+    // loads the previous session in the background, later stores are written there
+    void set_persist_path(const base::FilePath& path);
+
+    // zero for calls which are not cached
+    base::TimeDelta get_ttl(WalletHttpCallType type, const std::string& method_name);
+    // how long past the ttl an answer may still be shown, zero for explorer and payment reads
+    base::TimeDelta get_max_stale(WalletHttpCallType type, const std::string& method_name);
+
+    // nullptr on miss, is_stale is set when the entry is older than its ttl
+    const base::Value* find(const std::string& key, bool* is_stale);
+    // address is the one an explorer read is about, empty for other calls
+    void store(const std::string& key, WalletHttpCallType type, const std::string& method_name, const std::string& address, const base::Value& value);
+
+    // mutating call, entries of the methods depending on it are dropped,
+    // a sent transaction drops the explorer reads of its address, all of them when it is empty
+    void invalidate_for(WalletHttpCallType type, const std::string& method_name, const std::string& address);
+
+    // session is gone, nothing is served from memory or disk anymore
+    void clear();
+
+    void set_clock_for_testing(base::Clock* clock);
+    size_t get_size_for_testing();
+
+    // base::ImportantFileWriter::DataSerializer interface
+    bool SerializeData(std::string* data) override;
+
+private:
+    struct Entry
+    {
+        std::string method_name;
+        std::string address;
+        base::Value value;
+        base::Time stored_at;
+        base::TimeDelta ttl;
+        base::TimeDelta max_stale;
+        size_t size = 0;
+        std::list<std::string>::iterator lru_it;
+    };
+
+    void insert(const std::string& key, const std::string& method_name, const std::string& address, base::Value value, base::Time stored_at,
+                base::TimeDelta ttl, base::TimeDelta max_stale, size_t size);
+    void erase(std::map<std::string, Entry>::iterator it);
+    void on_loaded(absl::optional<base::Value> persisted);
+    void schedule_write();
+
+    std::map<std::string, Entry> entries_;
+    // most recently used first
+    std::list<std::string> lru_;
+    size_t total_size_ = 0;
+
+    base::Clock* clock_;
+
+    scoped_refptr<base::SequencedTaskRunner> file_task_runner_;
+    std::unique_ptr<base::ImportantFileWriter> writer_;
+
+    base::WeakPtrFactory<WalletResponseCache> weak_factory_{this};
+
+    DISALLOW_COPY_AND_ASSIGN(WalletResponseCache);
+};
+
+}
+
+#endif
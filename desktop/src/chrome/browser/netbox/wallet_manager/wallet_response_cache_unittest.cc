@@ -0,0 +1,154 @@
+#include <string>
+
+#include "base/test/simple_test_clock.h"
+#include "chrome/browser/netbox/wallet_manager/wallet_response_cache.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+class NetboxWalletResponseCacheTest : public ::testing::Test {
+public:
+    NetboxWalletResponseCacheTest() = default;
+    ~NetboxWalletResponseCacheTest() override = default;
+
+    void SetUp() override
+    {
+        clock_.SetNow(base::Time::Now());
+        cache_.set_clock_for_testing(&clock_);
+    }
+
+    static base::Value make_result(const std::string& text)
+    {
+        base::Value result(base::Value::Type::DICTIONARY);
+        result.SetStringKey("text", text);
+
+        return result;
+    }
+
+protected:
+    base::SimpleTestClock clock_;
+    WalletResponseCache cache_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxWalletResponseCacheTest);
+};
+
+TEST_F(NetboxWalletResponseCacheTest, FreshThenStale)
+{
+    cache_.store("features", WalletHttpCallType::API_SIGNED, "get_system_features", "", make_result("a"));
+
+    bool is_stale = true;
+    const base::Value* cached = cache_.find("features", &is_stale);
+    ASSERT_TRUE(cached);
+    ASSERT_FALSE(is_stale);
+    ASSERT_EQ("a", *cached->FindStringKey("text"));
+
+    clock_.Advance(base::TimeDelta::FromMinutes(11));
+    cached = cache_.find("features", &is_stale);
+    ASSERT_TRUE(cached);
+    ASSERT_TRUE(is_stale);
+
+    // shown for a few ttls while revalidating, older is a miss
+    clock_.Advance(base::TimeDelta::FromMinutes(40));
+    ASSERT_FALSE(cache_.find("features", &is_stale));
+    ASSERT_EQ(0u, cache_.get_size_for_testing());
+}
+
+TEST_F(NetboxWalletResponseCacheTest, PaymentReadsNeverStale)
+{
+    cache_.store("balance", WalletHttpCallType::API_EXPLORER, "addr/balance", "NbxA", make_result("a"));
+    cache_.store("addresses", WalletHttpCallType::API_SIGNED, "get_system_addresses", "", make_result("b"));
+
+    ASSERT_TRUE(cache_.get_max_stale(WalletHttpCallType::API_EXPLORER, "addr/utxo").is_zero());
+    ASSERT_TRUE(cache_.get_max_stale(WalletHttpCallType::API_SIGNED, "staking_status").is_zero());
+
+    bool is_stale = true;
+    ASSERT_TRUE(cache_.find("balance", &is_stale));
+    ASSERT_FALSE(is_stale);
+
+    clock_.Advance(base::TimeDelta::FromSeconds(31));
+    ASSERT_FALSE(cache_.find("balance", &is_stale));
+    ASSERT_TRUE(cache_.find("addresses", &is_stale));
+
+    clock_.Advance(base::TimeDelta::FromMinutes(10));
+    ASSERT_FALSE(cache_.find("addresses", &is_stale));
+}
+
+TEST_F(NetboxWalletResponseCacheTest, NotCachedMethods)
+{
+    cache_.store("stake", WalletHttpCallType::API_SIGNED, "stake", "", make_result("a"));
+    cache_.store("balance", WalletHttpCallType::RPC_JSON, "getbalance", "", make_result("a"));
+    cache_.store("send", WalletHttpCallType::API_EXPLORER, "tx/send", "", make_result("a"));
+
+    bool is_stale = false;
+    ASSERT_FALSE(cache_.find("stake", &is_stale));
+    ASSERT_FALSE(cache_.find("balance", &is_stale));
+    ASSERT_FALSE(cache_.find("send", &is_stale));
+}
+
+TEST_F(NetboxWalletResponseCacheTest, MutatingMethodInvalidates)
+{
+    cache_.store("staking", WalletHttpCallType::API_SIGNED, "staking_status", "", make_result("a"));
+    cache_.store("dapps", WalletHttpCallType::API_SIGNED, "get_dapps_info", "", make_result("b"));
+    cache_.store("features", WalletHttpCallType::API_SIGNED, "get_system_features", "", make_result("c"));
+
+    bool is_stale = false;
+
+    cache_.invalidate_for(WalletHttpCallType::API_SIGNED, "stake", "");
+    ASSERT_FALSE(cache_.find("staking", &is_stale));
+    ASSERT_TRUE(cache_.find("dapps", &is_stale));
+
+    cache_.invalidate_for(WalletHttpCallType::API_SIGNED, "vote_dapp_for", "");
+    ASSERT_FALSE(cache_.find("dapps", &is_stale));
+    ASSERT_TRUE(cache_.find("features", &is_stale));
+}
+
+TEST_F(NetboxWalletResponseCacheTest, SendInvalidatesAddress)
+{
+    cache_.store("balance_a", WalletHttpCallType::API_EXPLORER, "addr/balance", "NbxA", make_result("a"));
+    cache_.store("utxo_a", WalletHttpCallType::API_EXPLORER, "addr/utxo", "NbxA", make_result("a"));
+    cache_.store("balance_b", WalletHttpCallType::API_EXPLORER, "addr/balance", "NbxB", make_result("b"));
+    cache_.store("features", WalletHttpCallType::API_SIGNED, "get_system_features", "", make_result("c"));
+
+    bool is_stale = false;
+
+    cache_.invalidate_for(WalletHttpCallType::API_EXPLORER, "tx/send", "NbxA");
+    ASSERT_FALSE(cache_.find("balance_a", &is_stale));
+    ASSERT_FALSE(cache_.find("utxo_a", &is_stale));
+    ASSERT_TRUE(cache_.find("balance_b", &is_stale));
+
+    // the address is not known, every explorer read goes
+    cache_.invalidate_for(WalletHttpCallType::API_EXPLORER, "w/create", "");
+    ASSERT_FALSE(cache_.find("balance_b", &is_stale));
+    ASSERT_TRUE(cache_.find("features", &is_stale));
+}
+
+TEST_F(NetboxWalletResponseCacheTest, Clear)
+{
+    cache_.store("features", WalletHttpCallType::API_SIGNED, "get_system_features", "", make_result("a"));
+    cache_.clear();
+
+    bool is_stale = false;
+    ASSERT_FALSE(cache_.find("features", &is_stale));
+    ASSERT_EQ(0u, cache_.get_size_for_testing());
+}
+
+TEST_F(NetboxWalletResponseCacheTest, MemoryBound)
+{
+    std::string text(100 * 1024, 'x');
+
+    for (int i = 0; i < 100; ++i)
+    {
+        cache_.store("images" + std::to_string(i), WalletHttpCallType::API_SIGNED, "wallet_images", "", make_result(text));
+    }
+
+    ASSERT_LE(cache_.get_size_for_testing(), 2u * 1024 * 1024);
+
+    // least recently used are gone first
+    bool is_stale = false;
+    ASSERT_FALSE(cache_.find("images0", &is_stale));
+    ASSERT_TRUE(cache_.find("images99", &is_stale));
+}
+
+}
@@ -12,6 +12,12 @@ Polymer({
     <ul id="file_paths" style="overflow-wrap: break-word"></ul>
     <ul id="wallet_paths" style="overflow-wrap: break-word"></ul>
     <ul id="disks_free_space" style="overflow-wrap: break-word"></ul>
+</div>
+<div class="info-block">
+    <h2>Wallet calls</h2>
+    <ul id="sync" style="overflow-wrap: break-word"></ul>
+    <ul id="dispatcher" style="overflow-wrap: break-word"></ul>
+    <table id="wallet_calls"></table>
 </div>`,
 
     attached() {
@@ -34,7 +40,18 @@ Polymer({
 		window.addEventListener('netboxinfo.ostype', 		this.on_operating_system_type.bind(this));
 		window.addEventListener('netboxinfo.walletpaths', 	this.on_wallet_paths_check.bind(this));
 
+		window.addEventListener('netboxinfo.live', 		this.on_live.bind(this));
+		window.addEventListener('netboxinfo.sync', 		this.on_sync.bind(this));
+
 		chrome.send('netboxinfo', []);
+
+		// live section, refreshed while the page is open
+		chrome.send('netboxinfo_live', []);
+		this.live_timer = setInterval(() => chrome.send('netboxinfo_live', []), 2000);
+    },
+
+    detached() {
+		clearInterval(this.live_timer);
     },
 
 
@@ -106,6 +123,78 @@ Polymer({
 		}
 	},
 
+	on_sync: function(e)
+	{
+		let data = e['detail'] || {};
+
+		let parent_element = this.$.sync;
+		parent_element.innerHTML = "";
+
+		if (data["last_sync_at"])
+		{
+			data["last_sync_at"] = new Date(data["last_sync_at"]).toLocaleString();
+		}
+
+		for(let key in data)
+		{
+			let el = document.createElement('li');
+			el.innerHTML = "<b>Sync " + key + ":</b> " + data[key];
+			parent_element.appendChild(el);
+		}
+	},
+
+	on_live: function(e)
+	{
+		let data = e['detail'] || {};
+
+		let dispatcher = data["dispatcher"] || {};
+		let parent_element = this.$.dispatcher;
+		parent_element.innerHTML = "";
+
+		let endpoints = dispatcher["endpoints"] || {};
+		for(let key in endpoints)
+		{
+			let el = document.createElement('li');
+			el.innerHTML = "<b>Endpoint " + key + ":</b> in flight " + endpoints[key]["in_flight"] + "/" + endpoints[key]["max_in_flight"] + ", waiting " + endpoints[key]["waiting"];
+			parent_element.appendChild(el);
+		}
+
+		let classes = dispatcher["classes"] || {};
+		for(let key in classes)
+		{
+			let el = document.createElement('li');
+			el.innerHTML = "<b>Priority " + key + ":</b> dispatched " + classes[key]["dispatched"]
+				+ ", avg wait " + classes[key]["avg_wait_ms"].toFixed(1) + " ms"
+				+ ", avg service " + classes[key]["avg_service_ms"].toFixed(1) + " ms"
+				+ ", aged " + classes[key]["aged"];
+			parent_element.appendChild(el);
+		}
+
+		let format = (summary, key) => (summary && summary[key] !== undefined) ? Math.round(summary[key]) : "";
+
+		let table = this.$.wallet_calls;
+		table.innerHTML = "<tr><th>call</th><th>count</th><th>p50 ms</th><th>p90 ms</th><th>p99 ms</th>"
+			+ "<th>queue p90 ms</th><th>parse p90 ms</th><th>size p50</th><th>errors</th></tr>";
+
+		for(let call of (data["calls"] || []))
+		{
+			let errors = call["errors"] || {};
+			let errors_text = Object.keys(errors).map((code) => code + ": " + errors[code]).join(", ");
+
+			let row = document.createElement('tr');
+			row.innerHTML = "<td>" + call["name"] + "</td>"
+				+ "<td>" + format(call["latency"], "count") + "</td>"
+				+ "<td>" + format(call["latency"], "p50") + "</td>"
+				+ "<td>" + format(call["latency"], "p90") + "</td>"
+				+ "<td>" + format(call["latency"], "p99") + "</td>"
+				+ "<td>" + format(call["queue_wait"], "p90") + "</td>"
+				+ "<td>" + format(call["parse_time"], "p90") + "</td>"
+				+ "<td>" + format(call["response_size"], "p50") + "</td>"
+				+ "<td>" + errors_text + "</td>";
+			table.appendChild(row);
+		}
+	},
+
 	on_wallet_paths_check: function(e)
 	{
 		let data = e['detail'] || [];
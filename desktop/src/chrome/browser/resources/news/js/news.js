@@ -13,7 +13,6 @@ let news = {
     init: function()
     {
         window.addEventListener('news',     this.on_get_news.bind(this));
-        window.addEventListener('image',    this.on_get_image.bind(this));
         window.addEventListener('setlang',  this.on_change_lang.bind(this));
         window.addEventListener('getlang',  this.on_get_lang.bind(this));
 
@@ -174,7 +173,9 @@ let news = {
                 picked_tab.appendChild(picked_item);
             }
 
-            chrome.send('universal', ['image', editors_data[i].imageUrl, image_id]);
+            let image = image_item.querySelector(".slider__item-img");
+            image.onload = () => this.on_image_loaded();
+            image.setAttribute('src', 'chrome://wallet-image/?url=' + encodeURIComponent(editors_data[i].imageUrl));
 
             current_tab_items_count++;
         }
@@ -213,25 +214,11 @@ let news = {
         this.last_slide_ = Date.now();
     },
 
-    on_get_image: function(e)
+    on_image_loaded: function()
     {
-        let data = e['detail'] || [];
-
-        if (true !== data['success'])
+        if (!document.querySelector('body').classList.contains('loaded'))
         {
-            return;
-        }
-
-        let img = document.getElementById(data['selector']);
-
-        if (img)
-        {
-            img.setAttribute('src', data['image']);
-
-            if (!document.querySelector('body').classList.contains('loaded'))
-            {
-                document.querySelector('body').classList.add('loaded');
-            }
+            document.querySelector('body').classList.add('loaded');
         }
     },
 
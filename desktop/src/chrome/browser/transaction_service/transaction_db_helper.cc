@@ -3,15 +3,160 @@
 #include "base/files/file_util.h"
 #include "base/json/json_writer.h"
 #include "base/logging.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/stringprintf.h"
 #include "base/strings/string_util.h"
+#include "base/timer/elapsed_timer.h"
 #include "sql/database.h"
 #include "sql/statement.h"
 #include "sql/transaction.h"
 
+// 11 bound columns per row, a full chunk stays below SQLITE_MAX_VARIABLE_NUMBER (999)
+#define BULK_UPSERT_CHUNK_SIZE 90
+
+#define DB_PAGE_SIZE 4096
+
+// 2000 pages of 4k, about 8mb per connection
+#define DB_CACHE_SIZE_PAGES 2000
+
+#define DB_MMAP_SIZE_STR "67108864"
+
+#define DB_VERSION "2"
+
+// lower case hex of a 32 byte txid or block hash
+#define HASH_HEX_SIZE 64u
+
+// rows with their dictionary strings, joins are on integer primary keys
+#define TRANSACTIONS_FROM_SQL " FROM transactions" \
+    " JOIN categories ON categories.id=category_id" \
+    " JOIN addresses AS address_to ON address_to.id=address_to_id" \
+    " JOIN addresses AS address_from ON address_from.id=address_from_id"
+
+// greater than any byte of txids and addresses, "prefix" <= value < "prefix" + bound
+#define PREFIX_UPPER_BOUND "\x7f"
+
 namespace Netboxglobal
 {
 
+std::string bulk_upsert_sql(size_t rows_count)
+{
+    std::string sql = "INSERT INTO transactions"
+        "(txid, category_id, address_to_id, address_from_id, at, amount, fee, confirmations, conflicted, blockhash, blocknumber) "
+        "VALUES ";
+
+    for (size_t i = 0; i < rows_count; ++i)
+    {
+        if (0 == i)
+        {
+            sql = sql + "(?,?,?,?,?,?,?,?,?,?,?)";
+        }
+        else
+        {
+            sql = sql + ",(?,?,?,?,?,?,?,?,?,?,?)";
+        }
+    }
+
+    // same fields as update(), rows without changes are left untouched and are not counted by sqlite3_changes
+    sql = sql + " ON CONFLICT(txid, category_id, address_to_id, address_from_id) DO UPDATE SET "
+        "confirmations=excluded.confirmations, conflicted=excluded.conflicted, blocknumber=excluded.blocknumber, "
+        "blockhash=excluded.blockhash, at=excluded.at "
+        "WHERE confirmations<>excluded.confirmations OR conflicted<>excluded.conflicted OR blocknumber<>excluded.blocknumber "
+        "OR blockhash<>excluded.blockhash OR at<>excluded.at";
+
+    return sql;
+}
+
+// the page order is the stored key, dictionary ids included
+base::Value make_next_cursor(int at, const std::string& txid, int category_id, int address_to_id, int address_from_id)
+{
+    base::Value next_cursor(base::Value::Type::DICTIONARY);
+    next_cursor.SetIntKey("at",                 at);
+    next_cursor.SetStringKey("txid",            txid);
+    next_cursor.SetIntKey("category_id",        category_id);
+    next_cursor.SetIntKey("address_to_id",      address_to_id);
+    next_cursor.SetIntKey("address_from_id",    address_from_id);
+
+    return next_cursor;
+}
+
+// txids and block hashes of 64 lower case hex chars are stored as 32 byte blobs, anything else stays text
+bool hash_to_blob(const std::string& hash, std::string* blob)
+{
+    if (HASH_HEX_SIZE != hash.size())
+    {
+        return false;
+    }
+
+    for (char c : hash)
+    {
+        if (!base::IsAsciiDigit(c) && (c < 'a' || c > 'f'))
+        {
+            return false;
+        }
+    }
+
+    return base::HexStringToString(hash, blob);
+}
+
+base::Value hash_bind_value(const std::string& hash)
+{
+    std::string blob;
+    if (hash_to_blob(hash, &blob))
+    {
+        return base::Value(base::Value::BlobStorage(blob.begin(), blob.end()));
+    }
+
+    return base::Value(hash);
+}
+
+void bind_hash(sql::Statement& statement, int index, const std::string& hash)
+{
+    std::string blob;
+    if (hash_to_blob(hash, &blob))
+    {
+        statement.BindBlob(index, blob.data(), static_cast<int>(blob.size()));
+        return;
+    }
+
+    statement.BindString(index, hash);
+}
+
+std::string column_hash(sql::Statement& statement, int index)
+{
+    if (sql::ColumnType::kBlob != statement.GetColumnType(index))
+    {
+        return statement.ColumnString(index);
+    }
+
+    std::string blob;
+    statement.ColumnBlobAsString(index, &blob);
+
+    return base::ToLowerASCII(base::HexEncode(blob.data(), blob.size()));
+}
+
+// balances rows: ('total', 0), ('category', <category_id>), ('address', <address_to_id>)
+// row is the alias of the transaction in the trigger, OLD or NEW
+std::string balances_delta_sql(const std::string& row, const std::string& sign)
+{
+    std::vector<std::pair<std::string, std::string>> keys = {
+        {"'total'",    "0"},
+        {"'category'", row + ".category_id"},
+        {"'address'",  row + ".address_to_id"}
+    };
+
+    std::string sql = "";
+    for (const auto& key : keys)
+    {
+        // WHERE is required by sqlite to tell upsert from a join
+        sql = sql + base::StringPrintf(
+            "INSERT INTO balances(kind, key_id, amount, fee) "
+            "SELECT %s, %s, %s%s.amount, %s%s.fee WHERE %s.conflicted=0 "
+            "ON CONFLICT(kind, key_id) DO UPDATE SET amount=amount+excluded.amount, fee=fee+excluded.fee;",
+            key.first.c_str(), key.second.c_str(), sign.c_str(), row.c_str(), sign.c_str(), row.c_str(), row.c_str());
+    }
+
+    return sql;
+}
 
 TransactionDBHelper::TransactionDBHelper()
 {
@@ -57,6 +202,63 @@ base::FilePath TransactionDBHelper::check_and_get_db_path(const std::string& wal
     #endif
 }
 
+bool TransactionDBHelper::open_database(const base::FilePath& db_path)
+{
+    db_.set_page_size(DB_PAGE_SIZE);
+    db_.set_cache_size(DB_CACHE_SIZE_PAGES);
+
+    if (!db_.Open(db_path))
+    {
+        VLOG(1) << "failed to open db, " << db_path.value();
+        return false;
+    }
+
+    if (!db_.Execute("PRAGMA mmap_size=" DB_MMAP_SIZE_STR))
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "failed to enable mmap, " << db_path.value();
+    }
+
+    return true;
+}
+
+bool TransactionDBHelper::open_for_read(const std::string& wallet_first_address)
+{
+    if (db_.is_open())
+    {
+        db_.Close();
+    }
+
+    read_wallet_first_address_.clear();
+
+    // the schema belongs to the sync connection, nothing to read before it is created
+    base::FilePath db_path = check_and_get_db_path(wallet_first_address);
+    if (wallet_first_address.empty() || !base::PathExists(db_path))
+    {
+        return false;
+    }
+
+    if (!open_database(db_path))
+    {
+        return false;
+    }
+
+    // the sync connection may still be migrating an old schema
+    if (!db_.Execute("PRAGMA query_only=1") || db_version() != DB_VERSION)
+    {
+        VLOG(1) << "failed to open db for read, " << db_path.value();
+        db_.Close();
+        return false;
+    }
+
+    read_wallet_first_address_ = wallet_first_address;
+    return true;
+}
+
+const std::string& TransactionDBHelper::get_read_wallet_first_address()
+{
+    return read_wallet_first_address_;
+}
+
 bool TransactionDBHelper::check_database(const std::string& wallet_first_address, bool recreate)
 {
     if (db_.is_open())
@@ -68,21 +270,24 @@ bool TransactionDBHelper::check_database(const std::string& wallet_first_address
 
     if (recreate)
     {
-        if (base::PathExists(db_path))
+        // wal and shm files go together with the database
+        if (base::PathExists(db_path) && !sql::Database::Delete(db_path))
         {
-            if (!base::DeleteFile(db_path))
-            {
-                VLOG(NETBOX_LOG_LEVEL) << "failed to delete database " << db_path.value();
-            }
+            VLOG(NETBOX_LOG_LEVEL) << "failed to delete database " << db_path.value();
         }
     }
 
-    if (!db_.Open(db_path))
+    if (!open_database(db_path))
     {
-        VLOG(1) << "failed to open db, " << db_path.value();
         return false;
     }
 
+    // readers do not wait for sync writes, synchronous=NORMAL is durable enough with wal
+    if (!db_.Execute("PRAGMA journal_mode=WAL") || !db_.Execute("PRAGMA synchronous=NORMAL"))
+    {
+        VLOG(1) << "failed to switch db to wal, " << db_path.value();
+    }
+
     if (wallet_first_address.empty())
     {
         VLOG(1) << "table name is empty";
@@ -92,20 +297,101 @@ bool TransactionDBHelper::check_database(const std::string& wallet_first_address
     sql::Transaction committer(&db_);
     committer.Begin();
 
+    // v1 kept every string as text, its rows are moved in place so no resync is needed
+    std::string version = db_version();
+    bool is_v1 = ("1" == version || version.empty()) && db_.DoesTableExist("transactions");
+    if (is_v1)
+    {
+        if (!migrate_v1())
+        {
+            VLOG(1) << "failed to migrate transactions to v" DB_VERSION;
+            return false;
+        }
+    }
+    else if (DB_VERSION == version)
+    {
+        // schema is in place, reopening a known wallet skips the ddl
+        return committer.Commit();
+    }
+    else if (!create_schema())
+    {
+        return false;
+    }
+
+    // INSERT VERSION
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "INSERT OR REPLACE INTO settings(key, value) VALUES(?, ?)"));
+
+    statement.BindString(0, "version");
+    statement.BindString(1, DB_VERSION);
+
+    if (!statement.Run())
+    {
+		VLOG(1) << "failed to insert db version";
+		return false;
+    }
+
+    if (!committer.Commit())
+    {
+        return false;
+    }
+
+    // pages of the old table go back to the file system
+    if (is_v1 && !db_.Execute("VACUUM"))
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "failed to vacuum migrated database";
+    }
+
+    return true;
+}
+
+std::string TransactionDBHelper::db_version()
+{
+    if (!db_.DoesTableExist("settings"))
+    {
+        return "";
+    }
+
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT value FROM settings WHERE key='version'"));
+    if (!statement.Step())
+    {
+        return "";
+    }
+
+    return statement.ColumnString(0);
+}
+
+bool TransactionDBHelper::create_schema()
+{
+    // dictionaries, staking wallets repeat a handful of addresses over the whole history
+    std::vector<std::string> dictionaries_sql = {
+        "CREATE TABLE IF NOT EXISTS addresses (id INTEGER PRIMARY KEY, address TEXT NOT NULL UNIQUE)",
+        "CREATE TABLE IF NOT EXISTS categories (id INTEGER PRIMARY KEY, name TEXT NOT NULL UNIQUE)"
+    };
+
+    for (const std::string& dictionary_sql : dictionaries_sql)
+    {
+        if (!db_.Execute(dictionary_sql.c_str()))
+        {
+            VLOG(1) << "failed to create dictionary table";
+            return false;
+        }
+    }
+
+    // txid and blockhash are 32 byte blobs, see hash_to_blob
 	std::string sql_create = "CREATE TABLE IF NOT EXISTS transactions"
 						"("
-							"txid TEXT NOT NULL,"
-							"category TEXT NOT NULL,"
-							"address_to TEXT NOT NULL,"
-							"address_from TEXT NOT NULL,"
+							"txid BLOB NOT NULL,"
+							"category_id INTEGER NOT NULL,"
+							"address_to_id INTEGER NOT NULL,"
+							"address_from_id INTEGER NOT NULL,"
 							"at INTEGER NOT NULL,"
 							"amount INTEGER NOT NULL,"
 							"fee INTEGER NOT NULL,"
 							"confirmations INTEGER NOT NULL,"
 							"conflicted INTEGER NOT NULL,"
-							"blockhash TEXT NOT NULL,"
+							"blockhash BLOB NOT NULL,"
 							"blocknumber INTEGER NOT NULL,"
-							"PRIMARY KEY(txid, category, address_to, address_from)"
+							"PRIMARY KEY(txid, category_id, address_to_id, address_from_id)"
 						")";
 	// CREATE TABLE
 	if (!db_.Execute(sql_create.c_str()))
@@ -114,7 +400,8 @@ bool TransactionDBHelper::check_database(const std::string& wallet_first_address
 		return false;
 	}
 
-	std::vector<std::string> indexes_on_fields = {"at", "confirmations", "category,at", "address_to,at", "address_from,at"};
+    // at lookups are served by transactions_page
+	std::vector<std::string> indexes_on_fields = {"confirmations", "category_id,at", "address_to_id,at", "address_from_id,at"};
 	for(auto field_name : indexes_on_fields)
 	{
 		std::string index_name = "transactions_" + field_name;
@@ -129,6 +416,18 @@ bool TransactionDBHelper::check_database(const std::string& wallet_first_address
 		}
 	}
 
+    // serves ORDER BY of the transactions pages without a sort step
+    if (!db_.Execute("CREATE INDEX IF NOT EXISTS transactions_page ON transactions (at DESC, txid, category_id, address_to_id, address_from_id)"))
+    {
+        VLOG(1) << "failed to create index, transactions_page";
+        return false;
+    }
+
+    if (!create_balances())
+    {
+        return false;
+    }
+
     sql_create = "CREATE TABLE IF NOT EXISTS settings"
 						"("
 							"key TEXT NOT NULL,"
@@ -142,61 +441,472 @@ bool TransactionDBHelper::check_database(const std::string& wallet_first_address
 		return false;
 	}
 
-    // INSERT VERSION
-    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "INSERT OR REPLACE INTO settings(key, value) VALUES(?, ?)"));
+    return true;
+}
 
-    statement.BindString(0, "version");
-    statement.BindString(1, "1");
+bool TransactionDBHelper::migrate_v1()
+{
+    base::ElapsedTimer timer;
+
+    // v1 index names are reused by v2, balances are rebuilt over ids
+    std::vector<std::string> prepare_sql = {
+        "DROP INDEX IF EXISTS transactions_at",
+        "DROP INDEX IF EXISTS transactions_confirmations",
+        "DROP INDEX IF EXISTS transactions_category_at",
+        "DROP INDEX IF EXISTS transactions_address_to_at",
+        "DROP INDEX IF EXISTS transactions_address_from_at",
+        "DROP INDEX IF EXISTS transactions_page",
+        "DROP TRIGGER IF EXISTS balances_insert",
+        "DROP TRIGGER IF EXISTS balances_delete",
+        "DROP TRIGGER IF EXISTS balances_update",
+        "DROP TABLE IF EXISTS balances",
+        "ALTER TABLE transactions RENAME TO transactions_v1"
+    };
+
+    for (const std::string& sql : prepare_sql)
+    {
+        if (!db_.Execute(sql.c_str()))
+        {
+            return false;
+        }
+    }
 
-    if (!statement.Run())
+    if (!create_schema())
     {
-		VLOG(1) << "failed to insert db version";
-		return false;
+        return false;
+    }
+
+    sql::Statement statement(db_.GetUniqueStatement(
+        "SELECT txid, category, address_to, address_from, at, amount, fee, confirmations, conflicted, blockhash, blocknumber FROM transactions_v1"));
+
+    TransactionBulkStats stats;
+    std::vector<TransactionData> rows;
+    rows.reserve(BULK_UPSERT_CHUNK_SIZE);
+
+    auto flush_rows = [this, &rows, &stats]()
+    {
+        std::vector<const TransactionData*> chunk;
+        for (const TransactionData& row : rows)
+        {
+            chunk.push_back(&row);
+        }
+
+        bool result = chunk.empty() || bulk_insert_or_update_chunk(chunk, &stats);
+        rows.clear();
+
+        return result;
+    };
+
+    while (statement.Step())
+    {
+        TransactionData transaction;
+        transaction.txid            = statement.ColumnString(0);
+        transaction.category        = statement.ColumnString(1);
+        transaction.address_to      = statement.ColumnString(2);
+        transaction.address_from    = statement.ColumnString(3);
+        transaction.at              = statement.ColumnInt(4);
+        transaction.amount          = statement.ColumnInt64(5);
+        transaction.fee             = statement.ColumnInt64(6);
+        transaction.confirmations   = statement.ColumnInt(7);
+        transaction.conflicted      = statement.ColumnInt(8);
+        transaction.blockhash       = statement.ColumnString(9);
+        transaction.blocknumber     = statement.ColumnInt(10);
+
+        rows.push_back(std::move(transaction));
+
+        if (BULK_UPSERT_CHUNK_SIZE == rows.size() && !flush_rows())
+        {
+            return false;
+        }
+    }
+
+    if (!statement.Succeeded() || !flush_rows())
+    {
+        return false;
+    }
+
+    if (!db_.Execute("DROP TABLE transactions_v1"))
+    {
+        return false;
+    }
+
+    VLOG(1) << "transactions migrated to v" DB_VERSION ", rows " << stats.inserted << ", ms " << timer.Elapsed().InMilliseconds();
+
+    return true;
+}
+
+bool TransactionDBHelper::create_balances()
+{
+    bool is_new = !db_.DoesTableExist("balances");
+
+    // running sums of not conflicted transactions, kept up to date by triggers
+    std::string sql_create = "CREATE TABLE IF NOT EXISTS balances"
+                        "("
+                            "kind TEXT NOT NULL,"
+                            "key_id INTEGER NOT NULL,"
+                            "amount INTEGER NOT NULL,"
+                            "fee INTEGER NOT NULL,"
+                            "PRIMARY KEY(kind, key_id)"
+                        ")";
+    if (!db_.Execute(sql_create.c_str()))
+    {
+        VLOG(1) << "failed to create balances table";
+        return false;
+    }
+
+    std::vector<std::string> triggers = {
+        "CREATE TRIGGER IF NOT EXISTS balances_insert AFTER INSERT ON transactions "
+        "BEGIN " + balances_delta_sql("NEW", "") + " END",
+
+        "CREATE TRIGGER IF NOT EXISTS balances_delete AFTER DELETE ON transactions "
+        "BEGIN " + balances_delta_sql("OLD", "-") + " END",
+
+        "CREATE TRIGGER IF NOT EXISTS balances_update AFTER UPDATE OF conflicted, amount, fee, category_id, address_to_id ON transactions "
+        "WHEN OLD.conflicted<>NEW.conflicted OR OLD.amount<>NEW.amount OR OLD.fee<>NEW.fee "
+        "OR OLD.category_id<>NEW.category_id OR OLD.address_to_id<>NEW.address_to_id "
+        "BEGIN " + balances_delta_sql("OLD", "-") + balances_delta_sql("NEW", "") + " END"
+    };
+
+    for (const std::string& trigger_sql : triggers)
+    {
+        if (!db_.Execute(trigger_sql.c_str()))
+        {
+            VLOG(1) << "failed to create balances trigger";
+            return false;
+        }
+    }
+
+    // new database or the one being migrated
+    if (is_new)
+    {
+        return rebuild_balances();
+    }
+
+    return true;
+}
+
+bool TransactionDBHelper::rebuild_balances()
+{
+    sql::Transaction committer(&db_);
+    committer.Begin();
+
+    if (!db_.Execute("DELETE FROM balances"))
+    {
+        return false;
+    }
+
+    for (const std::string& balances_sql : balances_full_scan_sql())
+    {
+        if (!db_.Execute(("INSERT INTO balances(kind, key_id, amount, fee) " + balances_sql).c_str()))
+        {
+            VLOG(1) << "failed to rebuild balances";
+            return false;
+        }
+    }
+
+    return committer.Commit();
+}
+
+std::vector<std::string> TransactionDBHelper::balances_full_scan_sql()
+{
+    return {
+        "SELECT 'total', 0, coalesce(sum(amount), 0), coalesce(sum(fee), 0) FROM transactions WHERE conflicted=0",
+        "SELECT 'category', category_id, sum(amount), sum(fee) FROM transactions WHERE conflicted=0 GROUP BY category_id",
+        "SELECT 'address', address_to_id, sum(amount), sum(fee) FROM transactions WHERE conflicted=0 GROUP BY address_to_id"
+    };
+}
+
+bool TransactionDBHelper::check_balances(bool repair)
+{
+    // kind, name => amount, fee
+    std::map<std::pair<std::string, std::string>, std::pair<int64_t, int64_t>> expected;
+    std::map<std::pair<std::string, std::string>, std::pair<int64_t, int64_t>> stored;
+
+    for (const std::string& balances_sql : balances_full_scan_sql())
+    {
+        sql::Statement statement(db_.GetUniqueStatement(balances_sql.c_str()));
+        while (statement.Step())
+        {
+            expected[{statement.ColumnString(0), statement.ColumnString(1)}] = {statement.ColumnInt64(2), statement.ColumnInt64(3)};
+        }
+    }
+
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT kind, key_id, amount, fee FROM balances"));
+    while (statement.Step())
+    {
+        stored[{statement.ColumnString(0), statement.ColumnString(1)}] = {statement.ColumnInt64(2), statement.ColumnInt64(3)};
+    }
+
+    // rows without transactions left are kept with zero sums
+    bool is_consistent = true;
+    for (const auto& it : stored)
+    {
+        auto expected_it = expected.find(it.first);
+        std::pair<int64_t, int64_t> expected_value = expected_it == expected.end() ? std::make_pair<int64_t, int64_t>(0, 0) : expected_it->second;
+
+        if (expected_value != it.second)
+        {
+            VLOG(NETBOX_LOG_LEVEL) << "balances mismatch " << it.first.first << " " << it.first.second;
+            is_consistent = false;
+        }
+    }
+
+    for (const auto& it : expected)
+    {
+        if (stored.end() == stored.find(it.first))
+        {
+            VLOG(NETBOX_LOG_LEVEL) << "balances missing " << it.first.first << " " << it.first.second;
+            is_consistent = false;
+        }
+    }
+
+    if (!is_consistent && repair)
+    {
+        rebuild_balances();
+    }
+
+    return is_consistent;
+}
+
+std::vector<TransactionCheckpoint> TransactionDBHelper::get_checkpoints()
+{
+    std::vector<TransactionCheckpoint> checkpoints;
+
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE,
+        "SELECT blockhash, min(at) FROM transactions WHERE blockhash<>'' GROUP BY blockhash ORDER BY 2, 1"));
+
+    while (statement.Step())
+    {
+        TransactionCheckpoint checkpoint;
+        checkpoint.blockhash = column_hash(statement, 0);
+        checkpoint.at        = statement.ColumnInt(1);
+
+        checkpoints.push_back(std::move(checkpoint));
+    }
+
+    return checkpoints;
+}
+
+bool TransactionDBHelper::set_range_blocks(const std::set<std::string>& range_blocks)
+{
+    // no type affinity, blob and text hashes are compared as stored
+    if (!db_.Execute("CREATE TEMP TABLE IF NOT EXISTS range_blocks (blockhash NOT NULL PRIMARY KEY)")
+     || !db_.Execute("DELETE FROM temp.range_blocks"))
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "failed to prepare range blocks";
+        return false;
     }
 
-    committer.Commit();
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "INSERT OR IGNORE INTO temp.range_blocks(blockhash) VALUES(?)"));
+    for (const std::string& blockhash : range_blocks)
+    {
+        statement.Reset(true);
+        bind_hash(statement, 0, blockhash);
+
+        if (!statement.Run())
+        {
+            return false;
+        }
+    }
+
+    return true;
+}
+
+bool TransactionDBHelper::is_range_consistent(const std::set<std::string>& range_blocks, std::map<std::string, TransactionData>& rpc_data)
+{
+    if (!set_range_blocks(range_blocks))
+    {
+        return false;
+    }
+
+    // confirmed and not conflicted rows only, mempool rows are fixed by the regular sync
+    std::map<std::string, const TransactionData*> expected;
+    for (auto it = rpc_data.begin(); it != rpc_data.end(); ++it)
+    {
+        if (!it->second.conflicted && it->second.confirmations > 0)
+        {
+            expected[it->first] = &it->second;
+        }
+    }
+
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE,
+        "SELECT txid, categories.name, address_to.address, address_from.address, amount, fee" TRANSACTIONS_FROM_SQL
+        " WHERE conflicted=0 AND confirmations>0 AND blockhash IN (SELECT blockhash FROM temp.range_blocks)"));
+
+    size_t stored_count = 0;
+    while (statement.Step())
+    {
+        TransactionData transaction;
+        transaction.txid         = column_hash(statement, 0);
+        transaction.category     = statement.ColumnString(1);
+        transaction.address_to   = statement.ColumnString(2);
+        transaction.address_from = statement.ColumnString(3);
+
+        auto it = expected.find(transaction.key());
+        if (it == expected.end()
+         || it->second->amount != statement.ColumnInt64(4)
+         || it->second->fee != statement.ColumnInt64(5))
+        {
+            return false;
+        }
+
+        stored_count++;
+    }
+
+    return stored_count == expected.size();
+}
+
+bool TransactionDBHelper::replace_range(const std::set<std::string>& range_blocks, const std::map<std::string, TransactionData>& rpc_data)
+{
+    sql::Transaction committer(&db_);
+    if (!committer.Begin())
+    {
+        return false;
+    }
+
+    if (!set_range_blocks(range_blocks)
+     || !db_.Execute("DELETE FROM transactions WHERE blockhash IN (SELECT blockhash FROM temp.range_blocks)"))
+    {
+        return false;
+    }
+
+    // same rule as the regular sync, mempool duplicates without address_from are not stored
+    TransactionBulkStats stats;
+    std::vector<const TransactionData*> chunk;
+    for (auto it = rpc_data.begin(); it != rpc_data.end(); ++it)
+    {
+        if (it->second.address_from.empty() && -1 == it->second.confirmations)
+        {
+            continue;
+        }
+
+        chunk.push_back(&it->second);
+
+        if (BULK_UPSERT_CHUNK_SIZE == chunk.size())
+        {
+            if (!bulk_insert_or_update_chunk(chunk, &stats))
+            {
+                return false;
+            }
+            chunk.clear();
+        }
+    }
+
+    if (!chunk.empty() && !bulk_insert_or_update_chunk(chunk, &stats))
+    {
+        return false;
+    }
+
+    VLOG(NETBOX_LOG_LEVEL) << "range replaced, blocks " << range_blocks.size() << ", rows " << stats.inserted;
+
+    return committer.Commit();
+}
+
+std::map<std::string, TransactionData> TransactionDBHelper::get_unconfirmed(const std::string wallet_first_address)
+{
+    std::map<std::string, TransactionData> results;
+
+    sql::Statement query(db_.GetCachedStatement(SQL_FROM_HERE,
+        "SELECT txid, categories.name, address_to.address, address_from.address, confirmations, conflicted,"
+        " amount, at, blockhash, blocknumber"
+        TRANSACTIONS_FROM_SQL
+        " WHERE confirmations < " ENOUGH_CONFIRMATION_COUNT_STR " AND conflicted=0"
+    ));
+
+    // Execute the query and get results.
+    while (query.is_valid() && query.Step())
+    {
+        TransactionData transaction;
+        transaction.txid          = column_hash(query, 0);
+        transaction.category      = query.ColumnString(1);
+        transaction.address_to    = query.ColumnString(2);
+        transaction.address_from  = query.ColumnString(3);
+        transaction.confirmations = query.ColumnInt(4);
+        transaction.conflicted    = query.ColumnInt(5);
+        transaction.amount        = query.ColumnInt64(6);
+        transaction.at            = query.ColumnInt(7);
+        transaction.blockhash     = column_hash(query, 8);
+        transaction.blocknumber   = query.ColumnInt(9);
+
+        results.insert({transaction.key(), std::move(transaction)});
+    }
+
+    return results;
+}
+
+bool TransactionDBHelper::has_unconfirmed()
+{
+    sql::Statement query(db_.GetCachedStatement(SQL_FROM_HERE,
+        "SELECT 1 FROM transactions"
+        " WHERE confirmations < " ENOUGH_CONFIRMATION_COUNT_STR " AND conflicted=0 LIMIT 1"
+    ));
+
+    return query.Step();
+}
+
+int64_t TransactionDBHelper::get_address_id(const std::string& address, bool create)
+{
+    if (create)
+    {
+        sql::Statement insert_statement(db_.GetCachedStatement(SQL_FROM_HERE, "INSERT OR IGNORE INTO addresses(address) VALUES(?)"));
+        insert_statement.BindString(0, address);
+
+        if (!insert_statement.Run())
+        {
+            return -1;
+        }
+    }
 
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT id FROM addresses WHERE address=?"));
+    statement.BindString(0, address);
 
-    return true;
+    return statement.Step() ? statement.ColumnInt64(0) : -1;
 }
 
-std::map<std::string, TransactionData> TransactionDBHelper::get_unconfirmed(const std::string wallet_first_address)
+int64_t TransactionDBHelper::get_category_id(const std::string& category, bool create)
 {
-    std::map<std::string, TransactionData> results;
-
-    sql::Statement query(db_.GetCachedStatement(SQL_FROM_HERE,
-        "SELECT txid, category, address_to, address_from, confirmations, conflicted"
-        " FROM transactions"
-        " WHERE confirmations < " ENOUGH_CONFIRMATION_COUNT_STR " AND conflicted=0"
-    ));
-
-    // Execute the query and get results.
-    while (query.is_valid() && query.Step())
+    if (create)
     {
-        TransactionData transaction;
-        transaction.txid          = query.ColumnString(0);
-        transaction.category      = query.ColumnString(1);
-        transaction.address_to    = query.ColumnString(2);
-        transaction.address_from  = query.ColumnString(3);
-        transaction.confirmations = query.ColumnInt(4);
-        transaction.conflicted    = query.ColumnInt(5);
+        sql::Statement insert_statement(db_.GetCachedStatement(SQL_FROM_HERE, "INSERT OR IGNORE INTO categories(name) VALUES(?)"));
+        insert_statement.BindString(0, category);
 
-        results.insert({transaction.key(), std::move(transaction)});
+        if (!insert_statement.Run())
+        {
+            return -1;
+        }
     }
 
-    return results;
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT id FROM categories WHERE name=?"));
+    statement.BindString(0, category);
+
+    return statement.Step() ? statement.ColumnInt64(0) : -1;
+}
+
+// txid, category_id, address_to_id, address_from_id from the given index, missing dictionary ids match no rows
+bool TransactionDBHelper::bind_key(sql::Statement& statement, int index, const TransactionData& transaction, bool create)
+{
+    int64_t category_id     = get_category_id(transaction.category, create);
+    int64_t address_to_id   = get_address_id(transaction.address_to, create);
+    int64_t address_from_id = get_address_id(transaction.address_from, create);
+
+    bind_hash(statement, index, transaction.txid);
+    statement.BindInt64(index + 1, category_id);
+    statement.BindInt64(index + 2, address_to_id);
+    statement.BindInt64(index + 3, address_from_id);
+
+    return category_id >= 0 && address_to_id >= 0 && address_from_id >= 0;
 }
 
 bool TransactionDBHelper::insert_or_update(const TransactionData& transaction)
 {
     sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE,
         "SELECT 1 FROM transactions "
-        "WHERE txid=? AND category=? AND address_to=? AND address_from=?"));
+        "WHERE txid=? AND category_id=? AND address_to_id=? AND address_from_id=?"));
 
-    statement.BindString(0, transaction.txid);
-    statement.BindString(1, transaction.category);
-    statement.BindString(2, transaction.address_to);
-    statement.BindString(3, transaction.address_from);
+    if (!bind_key(statement, 0, transaction, true))
+    {
+        return false;
+    }
 
     if (statement.Step())
     {
@@ -206,41 +916,147 @@ bool TransactionDBHelper::insert_or_update(const TransactionData& transaction)
     {
         sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE,
             "INSERT INTO transactions"
-            "(txid, category, address_to, address_from, at, amount, fee, confirmations, conflicted, blockhash, blocknumber) "
+            "(txid, category_id, address_to_id, address_from_id, at, amount, fee, confirmations, conflicted, blockhash, blocknumber) "
             "VALUES (?,?,?,?,?,?,?,?,?,?,?)"));
 
-        statement.BindString(0,  transaction.txid);
-        statement.BindString(1,  transaction.category);
-        statement.BindString(2,  transaction.address_to);
-        statement.BindString(3,  transaction.address_from);
+        bind_key(statement, 0, transaction, false);
         statement.BindInt(4,     transaction.at);
         statement.BindInt64(5,   transaction.amount);
         statement.BindInt64(6,   transaction.fee);
         statement.BindInt(7,     transaction.confirmations);
         statement.BindInt(8,     transaction.conflicted);
-        statement.BindString(9,  transaction.blockhash);
+        bind_hash(statement, 9,  transaction.blockhash);
         statement.BindInt(10,    transaction.blocknumber);
 
         return statement.Run();
     }
 }
 
+bool TransactionDBHelper::bulk_insert_or_update(const std::map<std::string, TransactionData>& transactions, TransactionBulkStats* stats)
+{
+    TransactionBulkStats local_stats;
+    if (!stats)
+    {
+        stats = &local_stats;
+    }
+
+    sql::Transaction committer(&db_);
+    if (!committer.Begin())
+    {
+        return false;
+    }
+
+    std::vector<const TransactionData*> chunk;
+    chunk.reserve(BULK_UPSERT_CHUNK_SIZE);
+
+    for (auto it = transactions.begin(); it != transactions.end(); ++it)
+    {
+        chunk.push_back(&it->second);
+
+        if (BULK_UPSERT_CHUNK_SIZE == chunk.size())
+        {
+            if (!bulk_insert_or_update_chunk(chunk, stats))
+            {
+                return false;
+            }
+            chunk.clear();
+        }
+    }
+
+    if (!chunk.empty() && !bulk_insert_or_update_chunk(chunk, stats))
+    {
+        return false;
+    }
+
+    return committer.Commit();
+}
+
+bool TransactionDBHelper::bulk_insert_or_update_chunk(std::vector<const TransactionData*>& chunk, TransactionBulkStats* stats)
+{
+    // rowid is allocated as max(rowid) + 1, so its growth is the count of inserted rows
+    sql::Statement max_rowid_statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT max(rowid) FROM transactions"));
+    int64_t max_rowid_before = max_rowid_statement.Step() ? max_rowid_statement.ColumnInt64(0) : 0;
+
+    sql::Statement statement;
+    if (BULK_UPSERT_CHUNK_SIZE == chunk.size())
+    {
+        statement.Assign(db_.GetCachedStatement(SQL_FROM_HERE, bulk_upsert_sql(chunk.size()).c_str()));
+    }
+    else
+    {
+        statement.Assign(db_.GetUniqueStatement(bulk_upsert_sql(chunk.size()).c_str()));
+    }
+
+    // dictionary ids of the chunk, not kept longer than the surrounding transaction
+    std::map<std::string, int64_t> address_ids;
+    std::map<std::string, int64_t> category_ids;
+
+    auto address_id = [this, &address_ids](const std::string& address)
+    {
+        auto it = address_ids.find(address);
+        if (it == address_ids.end())
+        {
+            it = address_ids.insert({address, get_address_id(address, true)}).first;
+        }
+
+        return it->second;
+    };
+
+    int bind_index = 0;
+    for (const TransactionData* transaction : chunk)
+    {
+        auto category_it = category_ids.find(transaction->category);
+        if (category_it == category_ids.end())
+        {
+            category_it = category_ids.insert({transaction->category, get_category_id(transaction->category, true)}).first;
+        }
+
+        bind_hash(statement, bind_index++,  transaction->txid);
+        statement.BindInt64(bind_index++,   category_it->second);
+        statement.BindInt64(bind_index++,   address_id(transaction->address_to));
+        statement.BindInt64(bind_index++,   address_id(transaction->address_from));
+        statement.BindInt(bind_index++,     transaction->at);
+        statement.BindInt64(bind_index++,   transaction->amount);
+        statement.BindInt64(bind_index++,   transaction->fee);
+        statement.BindInt(bind_index++,     transaction->confirmations);
+        statement.BindInt(bind_index++,     transaction->conflicted);
+        bind_hash(statement, bind_index++,  transaction->blockhash);
+        statement.BindInt(bind_index++,     transaction->blocknumber);
+    }
+
+    if (!statement.Run())
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "failed to upsert transactions chunk";
+        return false;
+    }
+
+    int changed = db_.GetLastChangeCount();
+
+    max_rowid_statement.Reset(true);
+    int64_t max_rowid_after = max_rowid_statement.Step() ? max_rowid_statement.ColumnInt64(0) : 0;
+
+    int inserted = static_cast<int>(max_rowid_after - max_rowid_before);
+
+    stats->inserted  += inserted;
+    stats->updated   += changed - inserted;
+    stats->unchanged += static_cast<int>(chunk.size()) - changed;
+
+    return true;
+}
+
 bool TransactionDBHelper::update(const TransactionData& transaction)
 {
     sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE,
                 "UPDATE transactions "
                 "SET confirmations=?, conflicted=?, blocknumber=?, blockhash=?, at=? "
-                "WHERE txid=? AND category=? AND address_to=? AND address_from=?"));
+                "WHERE txid=? AND category_id=? AND address_to_id=? AND address_from_id=?"));
 
     statement.BindInt(0,    transaction.confirmations);
     statement.BindInt(1,    transaction.conflicted);
     statement.BindInt(2,    transaction.blocknumber);
-    statement.BindString(3, transaction.blockhash);
+    bind_hash(statement, 3, transaction.blockhash);
     statement.BindInt(4,    transaction.at);
-    statement.BindString(5, transaction.txid);
-    statement.BindString(6, transaction.category);
-    statement.BindString(7, transaction.address_to);
-    statement.BindString(8, transaction.address_from);
+    bind_key(statement, 5,  transaction, false);
 
     return statement.Run();
 }
@@ -248,12 +1064,9 @@ bool TransactionDBHelper::update(const TransactionData& transaction)
 bool TransactionDBHelper::set_conflicted(const TransactionData& transaction)
 {
     sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "UPDATE transactions SET conflicted = 1 "
-                                    "WHERE txid=? AND category=? AND address_to=? AND address_from=?"));
+                                    "WHERE txid=? AND category_id=? AND address_to_id=? AND address_from_id=?"));
 
-    statement.BindString(0, transaction.txid);
-    statement.BindString(1, transaction.category);
-    statement.BindString(2, transaction.address_to);
-    statement.BindString(3, transaction.address_from);
+    bind_key(statement, 0, transaction, false);
 
     return statement.Run();
 }
@@ -289,63 +1102,44 @@ bool TransactionDBHelper::set_latest_block(const std::string& latest_block)
     return committer.Commit();
 }
 
-base::Value TransactionDBHelper::get_transactions(const base::Value& params)
+void append_in_filter(const std::string& field_name, const base::Value* values, std::string& sql, std::vector<base::Value>& binds)
 {
-    if (!db_.is_open())
-    {
-        base::Value error_result(base::Value::Type::DICTIONARY);
-        error_result.SetStringKey("error", "Database is not open for transactions request");
-
-        return error_result;
-    }
-
-    base::Value transactions = get_transactions_internal(params);
-
-    // get transactions
-    base::Value result(base::Value::Type::DICTIONARY);
-    result.SetKey("transactions", std::move(transactions));
-
-    // get max/min dates
-    sql::Statement max_min_statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT min(at), max(at) FROM transactions"));
-    if (max_min_statement.Step())
+    sql = sql + field_name + " IN (";
+    for(unsigned int i = 0; i < values->GetList().size(); ++i)
     {
-        if (max_min_statement.ColumnInt(0) > 0)
+        if (0 == i)
         {
-            result.SetIntKey("first_transaction_date", max_min_statement.ColumnInt(0));
+            sql = sql + "?";
         }
-        if (max_min_statement.ColumnInt(1) > 0)
+        else
         {
-            result.SetIntKey("last_transaction_date", max_min_statement.ColumnInt(1));
+            sql = sql + ",?";
         }
-    }
-
-    // get pending
-    const base::Value* staking_pending_to = params.FindKey("staking_pending_to");
-    if (staking_pending_to && staking_pending_to->is_dict())
-    {
-        base::Value staking_pending = get_transactions_internal(*staking_pending_to);
-        result.SetKey("staking_pending", std::move(staking_pending));
-    }
 
-    const base::Value* lottery_pending_to = params.FindKey("lottery_pending_to");
-    if (lottery_pending_to && lottery_pending_to->is_dict())
-    {
-        base::Value lottery_pending = get_transactions_internal(*lottery_pending_to);
-        result.SetKey("lottery_pending", std::move(lottery_pending));
+        binds.push_back(values->GetList()[i].Clone());
     }
+    sql = sql + ")";
+}
 
-    return result;
+// addresses are matched in the dictionary, rows by their ids
+void append_address_filter(const std::string& field_name, const base::Value* values, std::string& sql, std::vector<base::Value>& binds)
+{
+    sql = sql + field_name + "_id IN (SELECT id FROM addresses WHERE ";
+    append_in_filter("address", values, sql, binds);
+    sql = sql + ")";
 }
 
-base::Value TransactionDBHelper::get_transactions_internal(const base::Value& params)
+// " AND ..." conditions for transaction filters, binds are in the same order as placeholders
+std::string build_transactions_filter(const base::Value& params, std::vector<base::Value>& binds)
 {
-    std::string sql = "SELECT txid, category, address_to, address_from, at, amount, fee, confirmations, conflicted, blocknumber FROM transactions WHERE 1=1 ";
+    std::string sql = "";
 
     // period_begin
     absl::optional<int> period_begin = params.FindIntKey("period_begin");
     if (period_begin != absl::nullopt && *period_begin > 0)
     {
         sql = sql + " AND at >= ?";
+        binds.push_back(base::Value(*period_begin));
     }
 
     // period_finish
@@ -353,13 +1147,15 @@ base::Value TransactionDBHelper::get_transactions_internal(const base::Value& pa
     if (period_finish != absl::nullopt && *period_finish > 0)
     {
         sql = sql + " AND at <= ?";
+        binds.push_back(base::Value(*period_finish));
     }
 
     // category
     const std::string* category = params.FindStringKey("category");
     if (category && category->size() > 0)
     {
-        sql = sql + " AND category = ?";
+        sql = sql + " AND category_id = (SELECT id FROM categories WHERE name = ?)";
+        binds.push_back(base::Value(*category));
     }
 
     // unconfirmed
@@ -372,38 +1168,16 @@ base::Value TransactionDBHelper::get_transactions_internal(const base::Value& pa
     const base::Value* address_from = params.FindListKey("address_from");
     if (address_from)
     {
-        sql = sql + " AND address_from IN (";
-        for(unsigned int i = 0; i < address_from->GetList().size(); ++i)
-        {
-            if (0 == i)
-            {
-                sql = sql + "?";
-            }
-            else
-            {
-                sql = sql + ",?";
-            }
-        }
-        sql = sql + ")";
+        sql = sql + " AND ";
+        append_address_filter("address_from", address_from, sql, binds);
     }
 
     // address_to in [...]
     const base::Value* address_to = params.FindListKey("address_to");
     if (address_to)
     {
-        sql = sql + " AND address_to IN (";
-        for(unsigned int i = 0; i < address_to->GetList().size(); ++i)
-        {
-            if (0 == i)
-            {
-                sql = sql + "?";
-            }
-            else
-            {
-                sql = sql + ",?";
-            }
-        }
-        sql = sql + ")";
+        sql = sql + " AND ";
+        append_address_filter("address_to", address_to, sql, binds);
     }
 
     // addresses
@@ -415,45 +1189,22 @@ base::Value TransactionDBHelper::get_transactions_internal(const base::Value& pa
 
         if (addresses_to && addresses_to->GetList().size() > 0)
         {
-            address_sql = address_sql + " address_to IN (";
-			for(unsigned int i = 0; i < addresses_to->GetList().size(); ++i)
-			{
-				if (0 == i)
-				{
-					address_sql = address_sql + "?";
-				}
-				else
-				{
-					address_sql = address_sql + ",?";
-				}
-			}
-
-			 address_sql = address_sql + ")";
+            address_sql = address_sql + " ";
+            append_address_filter("address_to", addresses_to, address_sql, binds);
         }
 
-		if (addresses_to
+        if (addresses_to
             && addresses_to->GetList().size() > 0
             && addresses_from
             && addresses_from->GetList().size() > 0)
-		{
-			address_sql = address_sql + " OR ";
-		}
+        {
+            address_sql = address_sql + " OR ";
+        }
 
         if (addresses_from && addresses_from->GetList().size() > 0)
         {
-            address_sql = address_sql + " address_from IN (";
-			for(unsigned int i = 0; i < addresses_from->GetList().size(); ++i)
-			{
-				if (0 == i)
-				{
-					address_sql = address_sql + "?";
-				}
-				else
-				{
-					address_sql = address_sql + ",?";
-				}
-			}
-			 address_sql = address_sql + ")";
+            address_sql = address_sql + " ";
+            append_address_filter("address_from", addresses_from, address_sql, binds);
         }
 
         if (address_sql.size() > 0)
@@ -462,99 +1213,171 @@ base::Value TransactionDBHelper::get_transactions_internal(const base::Value& pa
         }
     }
 
-
-    // text
+    // text, prefix ranges so each branch is served by the primary key or address indexes
     const std::string* text_raw = params.FindStringKey("text");
     if (text_raw && text_raw->size() > 0)
     {
-        sql = sql + " AND (txid LIKE ? OR address_to LIKE ?)";
+        // txid is lower case hex, addresses are case sensitive base58
+        std::string txid_prefix = base::ToLowerASCII(*text_raw);
+
+        // txids stored as text
+        sql = sql + " AND ((txid >= ? AND txid < ?)";
+        binds.push_back(base::Value(txid_prefix));
+        binds.push_back(base::Value(txid_prefix + PREFIX_UPPER_BOUND));
+
+        // blob txids, the prefix padded to the lowest and the highest hash
+        std::string txid_from, txid_to;
+        if (txid_prefix.size() <= HASH_HEX_SIZE
+         && hash_to_blob(txid_prefix + std::string(HASH_HEX_SIZE - txid_prefix.size(), '0'), &txid_from)
+         && hash_to_blob(txid_prefix + std::string(HASH_HEX_SIZE - txid_prefix.size(), 'f'), &txid_to))
+        {
+            sql = sql + " OR (txid BETWEEN ? AND ?)";
+            binds.push_back(base::Value(base::Value::BlobStorage(txid_from.begin(), txid_from.end())));
+            binds.push_back(base::Value(base::Value::BlobStorage(txid_to.begin(), txid_to.end())));
+        }
+
+        sql = sql + " OR address_to_id IN (SELECT id FROM addresses WHERE address >= ? AND address < ?)"
+                    " OR address_from_id IN (SELECT id FROM addresses WHERE address >= ? AND address < ?))";
+        binds.push_back(base::Value(*text_raw));
+        binds.push_back(base::Value(*text_raw + PREFIX_UPPER_BOUND));
+        binds.push_back(base::Value(*text_raw));
+        binds.push_back(base::Value(*text_raw + PREFIX_UPPER_BOUND));
     }
 
-    // order by
-    sql = sql + " ORDER BY at DESC, txid";
+    return sql;
+}
 
-    // limit
-    absl::optional<int> limit = params.FindIntKey("limit");
-    if (limit != absl::nullopt)
+void bind_transactions_filter(sql::Statement& statement, const std::vector<base::Value>& binds)
+{
+    int bind_index = 0;
+    for (const base::Value& bind : binds)
     {
-        sql = sql + " LIMIT ?";
-    }
+        if (bind.is_int())
+        {
+            statement.BindInt(bind_index, bind.GetInt());
+        }
+        else if (bind.is_string())
+        {
+            statement.BindString(bind_index, bind.GetString());
+        }
+        else if (bind.is_blob())
+        {
+            statement.BindBlob(bind_index, bind.GetBlob().data(), static_cast<int>(bind.GetBlob().size()));
+        }
+        else
+        {
+            statement.BindNull(bind_index);
+        }
 
-    int bind_index = 0;
-    sql::Statement statement(db_.GetUniqueStatement(sql.c_str()));
+        bind_index++;
+    }
+}
 
-    if (period_begin != absl::nullopt && *period_begin > 0)
+base::Value TransactionDBHelper::get_transactions(const base::Value& params)
+{
+    if (!db_.is_open())
     {
-        statement.BindInt(bind_index, *period_begin);
-        bind_index++;
+        base::Value error_result(base::Value::Type::DICTIONARY);
+        error_result.SetStringKey("error", "Database is not open for transactions request");
+
+        return error_result;
     }
-    if (period_finish != absl::nullopt && *period_finish > 0)
+
+    base::Value result(base::Value::Type::DICTIONARY);
+
+    // get transactions
+    base::Value transactions = get_transactions_internal(params, &result);
+    result.SetKey("transactions", std::move(transactions));
+
+    // next pages only need the rows
+    if (params.FindDictKey("cursor"))
     {
-        statement.BindInt(bind_index, *period_finish);
-        bind_index++;
+        return result;
     }
-    if (category && category->size() > 0)
+
+    // get max/min dates, separate queries so each one is a single index lookup
+    sql::Statement min_statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT min(at) FROM transactions"));
+    if (min_statement.Step() && min_statement.ColumnInt(0) > 0)
     {
-        statement.BindString(bind_index, *category);
-        bind_index++;
+        result.SetIntKey("first_transaction_date", min_statement.ColumnInt(0));
     }
-    if (address_from && address_from->GetList().size() > 0)
+
+    sql::Statement max_statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT max(at) FROM transactions"));
+    if (max_statement.Step() && max_statement.ColumnInt(0) > 0)
     {
-        for (const auto& address : address_from->GetList())
-        {
-            statement.BindString(bind_index, address.GetString());
-            bind_index++;
-        }
+        result.SetIntKey("last_transaction_date", max_statement.ColumnInt(0));
     }
 
-    if (address_to && address_to->GetList().size() > 0)
+    // get pending
+    const base::Value* staking_pending_to = params.FindKey("staking_pending_to");
+    if (staking_pending_to && staking_pending_to->is_dict())
     {
-        for (const auto& address : address_to->GetList())
-        {
-            statement.BindString(bind_index, address.GetString());
-            bind_index++;
-        }
+        base::Value staking_pending = get_transactions_internal(*staking_pending_to, nullptr);
+        result.SetKey("staking_pending", std::move(staking_pending));
     }
 
-    if (addresses_to && addresses_to->GetList().size() > 0)
+    const base::Value* lottery_pending_to = params.FindKey("lottery_pending_to");
+    if (lottery_pending_to && lottery_pending_to->is_dict())
     {
-        for (const auto& address : addresses_to->GetList())
-        {
-            statement.BindString(bind_index, address.GetString());
-            bind_index++;
-        }
+        base::Value lottery_pending = get_transactions_internal(*lottery_pending_to, nullptr);
+        result.SetKey("lottery_pending", std::move(lottery_pending));
     }
 
-    if (addresses_from && addresses_from->GetList().size() > 0)
+    return result;
+}
+
+base::Value TransactionDBHelper::get_transactions_internal(const base::Value& params, base::Value* page_result)
+{
+    std::vector<base::Value> binds;
+    std::string sql = "SELECT txid, categories.name, address_to.address, address_from.address, at, amount, fee, confirmations, conflicted, blocknumber,"
+        " category_id, address_to_id, address_from_id" TRANSACTIONS_FROM_SQL " WHERE 1=1 ";
+
+    sql = sql + build_transactions_filter(params, binds);
+
+    // cursor, resume right after the last row of the previous page
+    const base::Value* cursor = params.FindDictKey("cursor");
+    if (cursor)
     {
-        for (const auto& address : addresses_from->GetList())
+        absl::optional<int> cursor_at = cursor->FindIntKey("at");
+        const std::string* cursor_txid = cursor->FindStringKey("txid");
+        absl::optional<int> cursor_category_id = cursor->FindIntKey("category_id");
+        absl::optional<int> cursor_address_to_id = cursor->FindIntKey("address_to_id");
+        absl::optional<int> cursor_address_from_id = cursor->FindIntKey("address_from_id");
+
+        if (cursor_at != absl::nullopt && cursor_txid && cursor_category_id != absl::nullopt
+         && cursor_address_to_id != absl::nullopt && cursor_address_from_id != absl::nullopt)
         {
-            statement.BindString(bind_index, address.GetString());
-            bind_index++;
+            sql = sql + " AND (at < ? OR (at = ? AND (txid, category_id, address_to_id, address_from_id) > (?, ?, ?, ?)))";
+            binds.push_back(base::Value(*cursor_at));
+            binds.push_back(base::Value(*cursor_at));
+            binds.push_back(hash_bind_value(*cursor_txid));
+            binds.push_back(base::Value(*cursor_category_id));
+            binds.push_back(base::Value(*cursor_address_to_id));
+            binds.push_back(base::Value(*cursor_address_from_id));
         }
     }
 
-    if (text_raw && text_raw->size() > 0)
-    {
-        std::string text = *text_raw + "%";
-        statement.BindString(bind_index, text);
-        bind_index++;
-        statement.BindString(bind_index, text);
-        bind_index++;
-    }
+    // order by, the whole primary key makes the order stable between pages
+    sql = sql + " ORDER BY at DESC, txid, category_id, address_to_id, address_from_id";
 
+    // limit
+    absl::optional<int> limit = params.FindIntKey("limit");
     if (limit != absl::nullopt)
     {
-        statement.BindInt(bind_index, *limit);
-        bind_index++;
+        sql = sql + " LIMIT ?";
+        binds.push_back(base::Value(*limit));
     }
 
+    sql::Statement statement(db_.GetUniqueStatement(sql.c_str()));
+    bind_transactions_filter(statement, binds);
+
     base::Value transactions(base::Value::Type::LIST);
+    base::Value next_cursor;
     while(statement.Step())
     {
         // txid, category, address_to,  address_from, at, amount, fee, confirmations, conflicted, blocknumber
         base::Value t(base::Value::Type::DICTIONARY);
-        t.SetStringKey("txid",          statement.ColumnString(0));
+        t.SetStringKey("txid",          column_hash(statement, 0));
         t.SetStringKey("category",      statement.ColumnString(1));
         t.SetStringKey("address_to",    statement.ColumnString(2));
         t.SetStringKey("address_from",  statement.ColumnString(3));
@@ -565,15 +1388,99 @@ base::Value TransactionDBHelper::get_transactions_internal(const base::Value& pa
         t.SetIntKey("conflicted",       statement.ColumnInt(8));
         t.SetIntKey("blocknumber",      statement.ColumnInt(9));
 
+        next_cursor = make_next_cursor(*t.FindIntKey("at"), *t.FindStringKey("txid"),
+            statement.ColumnInt(10), statement.ColumnInt(11), statement.ColumnInt(12));
+
         transactions.Append(std::move(t));
     }
 
+    // full page, there may be more rows after it
+    if (page_result && limit != absl::nullopt && *limit > 0
+     && transactions.GetList().size() == static_cast<size_t>(*limit))
+    {
+        page_result->SetKey("next_cursor", std::move(next_cursor));
+    }
+
     return transactions;
 }
 
+base::Value TransactionDBHelper::get_transactions_summary(const base::Value& params)
+{
+    if (!db_.is_open())
+    {
+        base::Value error_result(base::Value::Type::DICTIONARY);
+        error_result.SetStringKey("error", "Database is not open for transactions request");
+
+        return error_result;
+    }
+
+    std::vector<base::Value> binds;
+    std::string sql = "SELECT categories.name, count(*), sum(amount), sum(fee), min(at), max(at)"
+        " FROM transactions JOIN categories ON categories.id=category_id WHERE 1=1 ";
+    sql = sql + build_transactions_filter(params, binds);
+    sql = sql + " GROUP BY category_id";
+
+    sql::Statement statement(db_.GetUniqueStatement(sql.c_str()));
+    bind_transactions_filter(statement, binds);
+
+    int count = 0;
+    int first_transaction_date = 0;
+    int last_transaction_date = 0;
+    base::Value categories(base::Value::Type::DICTIONARY);
+
+    while (statement.Step())
+    {
+        base::Value category(base::Value::Type::DICTIONARY);
+        category.SetIntKey("count",         statement.ColumnInt(1));
+        category.SetStringKey("amount",     std::to_string(statement.ColumnInt64(2)));
+        category.SetStringKey("fee",        std::to_string(statement.ColumnInt64(3)));
+
+        categories.SetKey(statement.ColumnString(0), std::move(category));
+
+        count = count + statement.ColumnInt(1);
+
+        if (0 == first_transaction_date || statement.ColumnInt(4) < first_transaction_date)
+        {
+            first_transaction_date = statement.ColumnInt(4);
+        }
+        if (statement.ColumnInt(5) > last_transaction_date)
+        {
+            last_transaction_date = statement.ColumnInt(5);
+        }
+    }
+
+    base::Value result(base::Value::Type::DICTIONARY);
+    result.SetIntKey("count", count);
+    result.SetKey("categories", std::move(categories));
+
+    if (first_transaction_date > 0)
+    {
+        result.SetIntKey("first_transaction_date", first_transaction_date);
+    }
+    if (last_transaction_date > 0)
+    {
+        result.SetIntKey("last_transaction_date", last_transaction_date);
+    }
+
+    return result;
+}
+
 int64_t TransactionDBHelper::get_balance()
 {
-    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT sum(amount) - sum(fee) FROM transactions WHERE conflicted=0"));
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT amount - fee FROM balances WHERE kind='total' AND key_id=0"));
+
+    if (!statement.Step())
+    {
+        return 0;
+    }
+
+    return statement.ColumnInt64(0);
+}
+
+int64_t TransactionDBHelper::get_address_balance(const std::string& address)
+{
+    sql::Statement statement(db_.GetCachedStatement(SQL_FROM_HERE, "SELECT amount - fee FROM balances WHERE kind='address' AND key_id=(SELECT id FROM addresses WHERE address=?)"));
+    statement.BindString(0, address);
 
     if (!statement.Step())
     {
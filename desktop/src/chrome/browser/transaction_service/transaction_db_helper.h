@@ -2,16 +2,32 @@
 #define CHROME_BROWSER_TRANSACTION_DB_HELPER_H_
 
 #include <map>
+#include <set>
 #include <string>
+#include <vector>
 
 #include "base/files/file_path.h"
 #include "base/values.h"
 #include "chrome/browser/transaction_service/transaction_model.h"
 #include "sql/database.h"
+#include "sql/statement.h"
 
 namespace Netboxglobal
 {
 
+struct TransactionBulkStats
+{
+    int inserted = 0;
+    int updated = 0;
+    int unchanged = 0;
+};
+
+// block with wallet transactions, used to bisect the history on reconciliation
+struct TransactionCheckpoint
+{
+    std::string blockhash;
+    int at = 0;
+};
 
 class TransactionDBHelper
 {
@@ -22,22 +38,49 @@ public:
     void set_db_path(base::FilePath path);
 
     bool check_database(const std::string& wallet_first_address, bool recreate);
+    // query only connection to a database created by check_database
+    bool open_for_read(const std::string& wallet_first_address);
+    const std::string& get_read_wallet_first_address();
     std::map<std::string, TransactionData> get_unconfirmed(const std::string wallet_first_address);
+    bool has_unconfirmed();
     bool insert_or_update(const TransactionData&);
+    bool bulk_insert_or_update(const std::map<std::string, TransactionData>& transactions, TransactionBulkStats* stats);
     bool update(const TransactionData&);
     bool set_conflicted(const TransactionData&);
     std::string get_latest_block();
     bool set_latest_block(const std::string& latest_block);
     base::Value get_transactions(const base::Value& params);
+    base::Value get_transactions_summary(const base::Value& params);
     int64_t get_balance();
+    int64_t get_address_balance(const std::string& address);
+    // compares maintained balances with a full scan of transactions
+    bool check_balances(bool repair);
+
+    // reconciliation, range is the set of blocks after a checkpoint, '' stands for unconfirmed rows
+    std::vector<TransactionCheckpoint> get_checkpoints();
+    bool is_range_consistent(const std::set<std::string>& range_blocks, std::map<std::string, TransactionData>& rpc_data);
+    bool replace_range(const std::set<std::string>& range_blocks, const std::map<std::string, TransactionData>& rpc_data);
 
     sql::Database* get_db();
     bool is_open();
 private:
-    base::Value get_transactions_internal(const base::Value& params);
+    bool open_database(const base::FilePath& db_path);
+    std::string db_version();
+    bool create_schema();
+    bool migrate_v1();
+    int64_t get_address_id(const std::string& address, bool create);
+    int64_t get_category_id(const std::string& category, bool create);
+    bool bind_key(sql::Statement& statement, int index, const TransactionData& transaction, bool create);
+    base::Value get_transactions_internal(const base::Value& params, base::Value* page_result);
+    bool bulk_insert_or_update_chunk(std::vector<const TransactionData*>& chunk, TransactionBulkStats* stats);
+    bool set_range_blocks(const std::set<std::string>& range_blocks);
+    bool create_balances();
+    bool rebuild_balances();
+    std::vector<std::string> balances_full_scan_sql();
     base::FilePath check_and_get_db_path(const std::string& wallet_first_address);
 
     base::FilePath db_folder_path_;
+    std::string read_wallet_first_address_;
     sql::Database db_;
 };
 
@@ -0,0 +1,298 @@
+#include <string>
+
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/browser/transaction_service/transaction_db_helper.h"
+#include "chrome/browser/transaction_service/transaction_helper.h"
+#include "chrome/browser/transaction_service/transaction_model.h"
+#include "sql/database.h"
+#include "sql/statement.h"
+#include "sql/transaction.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+// synthetic listsinceblock payload, staking wallets repeat a handful of addresses
+std::string make_listsinceblock_json(int rows_count, int confirmations)
+{
+    std::string json_raw = "{\"transactions\":[";
+
+    for (int i = 0; i < rows_count; ++i)
+    {
+        if (i > 0)
+        {
+            json_raw.push_back(',');
+        }
+
+        json_raw.append(base::StringPrintf(
+            "{\"txid\":\"%064x\",\"address\":\"NbxAddress%d\",\"category\":\"%s\",\"amount\":%d.5,"
+            "\"fee\":-0.0001,\"confirmations\":%d,\"blockhash\":\"%064x\",\"time\":%d}",
+            i, i % 8, (i % 3) ? "receive" : "stake", i % 1000, confirmations, i / 10, 1600000000 + i));
+    }
+
+    return json_raw + "]}";
+}
+
+class NetboxTransactionDBHelperPerfTest : public ::testing::Test {
+public:
+    NetboxTransactionDBHelperPerfTest() = default;
+    ~NetboxTransactionDBHelperPerfTest() override = default;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+    }
+
+    std::map<std::string, TransactionData> make_rpc_data(int rows_count, int confirmations)
+    {
+        absl::optional<base::Value> json = base::JSONReader::Read(make_listsinceblock_json(rows_count, confirmations));
+        return parse_transactions_json(*json);
+    }
+
+    base::TimeDelta replay_row_by_row(TransactionDBHelper& db_helper, const std::map<std::string, TransactionData>& rpc_data)
+    {
+        base::ElapsedTimer timer;
+
+        sql::Transaction committer(db_helper.get_db());
+        committer.Begin();
+        for (auto it = rpc_data.begin(); it != rpc_data.end(); ++it)
+        {
+            db_helper.insert_or_update(it->second);
+        }
+        committer.Commit();
+
+        return timer.Elapsed();
+    }
+
+    base::TimeDelta replay_bulk(TransactionDBHelper& db_helper, const std::map<std::string, TransactionData>& rpc_data, TransactionBulkStats* stats)
+    {
+        base::ElapsedTimer timer;
+
+        EXPECT_TRUE(db_helper.bulk_insert_or_update(rpc_data, stats));
+
+        return timer.Elapsed();
+    }
+
+protected:
+    base::ScopedTempDir temp_dir_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxTransactionDBHelperPerfTest);
+};
+
+// timings only, run with --run-manual
+TEST_F(NetboxTransactionDBHelperPerfTest, MANUAL_ListSinceBlock100k)
+{
+    const int rows_count = 100000;
+
+    std::map<std::string, TransactionData> rpc_data = make_rpc_data(rows_count, 1);
+    std::map<std::string, TransactionData> rpc_data_confirmed = make_rpc_data(rows_count, ENOUGH_CONFIRMATION_COUNT);
+
+    TransactionDBHelper row_db_helper;
+    row_db_helper.set_db_path(temp_dir_.GetPath());
+    ASSERT_TRUE(row_db_helper.check_database("row_by_row", false));
+
+    TransactionDBHelper bulk_db_helper;
+    bulk_db_helper.set_db_path(temp_dir_.GetPath());
+    ASSERT_TRUE(bulk_db_helper.check_database("bulk", false));
+
+    // first sync, every row is new
+    base::TimeDelta row_insert = replay_row_by_row(row_db_helper, rpc_data);
+    TransactionBulkStats insert_stats;
+    base::TimeDelta bulk_insert = replay_bulk(bulk_db_helper, rpc_data, &insert_stats);
+
+    // next sync, every row gets confirmed
+    base::TimeDelta row_update = replay_row_by_row(row_db_helper, rpc_data_confirmed);
+    TransactionBulkStats update_stats;
+    base::TimeDelta bulk_update = replay_bulk(bulk_db_helper, rpc_data_confirmed, &update_stats);
+
+    // same payload again
+    base::TimeDelta row_unchanged = replay_row_by_row(row_db_helper, rpc_data_confirmed);
+    TransactionBulkStats unchanged_stats;
+    base::TimeDelta bulk_unchanged = replay_bulk(bulk_db_helper, rpc_data_confirmed, &unchanged_stats);
+
+    ASSERT_EQ(static_cast<int>(rpc_data.size()), insert_stats.inserted);
+    ASSERT_EQ(static_cast<int>(rpc_data.size()), update_stats.updated);
+    ASSERT_EQ(static_cast<int>(rpc_data.size()), unchanged_stats.unchanged);
+    ASSERT_EQ(row_db_helper.get_balance(), bulk_db_helper.get_balance());
+
+    LOG(INFO) << "listsinceblock " << rpc_data.size() << " rows, row by row / bulk, ms:"
+              << " insert " << row_insert.InMilliseconds() << " / " << bulk_insert.InMilliseconds()
+              << ", update " << row_update.InMilliseconds() << " / " << bulk_update.InMilliseconds()
+              << ", unchanged " << row_unchanged.InMilliseconds() << " / " << bulk_unchanged.InMilliseconds();
+}
+
+// v1 layout as shipped, text hashes and addresses repeated in every row
+void create_v1_database(const base::FilePath& db_path, int rows_count)
+{
+    sql::Database db;
+    ASSERT_TRUE(db.Open(db_path));
+
+    sql::Transaction committer(&db);
+    ASSERT_TRUE(committer.Begin());
+
+    std::vector<std::string> schema_sql = {
+        "CREATE TABLE transactions (txid TEXT NOT NULL, category TEXT NOT NULL, address_to TEXT NOT NULL, address_from TEXT NOT NULL,"
+        " at INTEGER NOT NULL, amount INTEGER NOT NULL, fee INTEGER NOT NULL, confirmations INTEGER NOT NULL, conflicted INTEGER NOT NULL,"
+        " blockhash TEXT NOT NULL, blocknumber INTEGER NOT NULL, PRIMARY KEY(txid, category, address_to, address_from))",
+        "CREATE INDEX transactions_at ON transactions (at)",
+        "CREATE INDEX transactions_confirmations ON transactions (confirmations)",
+        "CREATE INDEX transactions_category_at ON transactions (category,at)",
+        "CREATE INDEX transactions_address_to_at ON transactions (address_to,at)",
+        "CREATE INDEX transactions_address_from_at ON transactions (address_from,at)",
+        "CREATE TABLE settings (key TEXT NOT NULL, value TEXT NOT NULL, PRIMARY KEY(key))",
+        "INSERT INTO settings(key, value) VALUES('version', '1')"
+    };
+
+    for (const std::string& sql : schema_sql)
+    {
+        ASSERT_TRUE(db.Execute(sql.c_str()));
+    }
+
+    sql::Statement statement(db.GetUniqueStatement("INSERT INTO transactions VALUES(?, ?, ?, ?, ?, ?, ?, ?, 0, ?, ?)"));
+    for (int i = 0; i < rows_count; ++i)
+    {
+        statement.Reset(true);
+        statement.BindString(0, base::StringPrintf("%064x", i * 2654435761u));
+        statement.BindString(1, (i % 3) ? "receive" : "stake");
+        statement.BindString(2, base::StringPrintf("NbxAddressTo%d", i % 8));
+        statement.BindString(3, base::StringPrintf("NbxAddressFrom%d", i % 16));
+        statement.BindInt(4, 1600000000 + i);
+        statement.BindInt64(5, 100000 + i);
+        statement.BindInt64(6, -10);
+        statement.BindInt(7, ENOUGH_CONFIRMATION_COUNT);
+        statement.BindString(8, base::StringPrintf("%064x", i / 10));
+        statement.BindInt(9, i / 10);
+        ASSERT_TRUE(statement.Run());
+    }
+
+    ASSERT_TRUE(committer.Commit());
+}
+
+// timings only, run with --run-manual
+TEST_F(NetboxTransactionDBHelperPerfTest, MANUAL_TextSearch)
+{
+    base::FilePath db_folder_path = temp_dir_.GetPath().Append(FILE_PATH_LITERAL("Wallet Data"));
+    ASSERT_TRUE(base::CreateDirectory(db_folder_path));
+
+    std::vector<std::string> prefixes = {"00a1", "NbxAddressTo3", "NbxAddressTo", "ffff"};
+
+    for (int rows_count : {10000, 100000, 1000000})
+    {
+        std::string wallet_first_address = "search_" + std::to_string(rows_count);
+        base::FilePath db_path = db_folder_path.AppendASCII(wallet_first_address);
+
+        create_v1_database(db_path, rows_count);
+
+        // the query the text filter used before, on the layout it ran on, kept as the baseline
+        base::TimeDelta like_time;
+        {
+            sql::Database db;
+            ASSERT_TRUE(db.Open(db_path));
+
+            base::ElapsedTimer like_timer;
+            for (const std::string& prefix : prefixes)
+            {
+                sql::Statement statement(db.GetUniqueStatement(
+                    "SELECT txid FROM transactions WHERE (txid LIKE ? OR address_to LIKE ?) ORDER BY at DESC, txid LIMIT 50"));
+                statement.BindString(0, prefix + "%");
+                statement.BindString(1, prefix + "%");
+                while (statement.Step())
+                {
+                }
+            }
+            like_time = like_timer.Elapsed();
+        }
+
+        // same rows after the migration
+        TransactionDBHelper db_helper;
+        db_helper.set_db_path(temp_dir_.GetPath());
+        ASSERT_TRUE(db_helper.check_database(wallet_first_address, false));
+
+        base::ElapsedTimer prefix_timer;
+        for (const std::string& prefix : prefixes)
+        {
+            base::Value params(base::Value::Type::DICTIONARY);
+            params.SetStringKey("text", prefix);
+            params.SetIntKey("limit", 50);
+
+            base::Value result = db_helper.get_transactions(params);
+            ASSERT_TRUE(result.FindListKey("transactions"));
+        }
+        base::TimeDelta prefix_time = prefix_timer.Elapsed();
+
+        LOG(INFO) << "text search " << rows_count << " rows, " << prefixes.size() << " queries, ms:"
+                  << " like " << like_time.InMilliseconds()
+                  << ", prefix ranges " << prefix_time.InMilliseconds();
+    }
+}
+
+// timings only, run with --run-manual
+TEST_F(NetboxTransactionDBHelperPerfTest, MANUAL_SchemaV2Migration)
+{
+    const int rows_count = 200000;
+    const std::string wallet_first_address = "migration";
+
+    base::FilePath db_folder_path = temp_dir_.GetPath().Append(FILE_PATH_LITERAL("Wallet Data"));
+    ASSERT_TRUE(base::CreateDirectory(db_folder_path));
+    base::FilePath db_path = db_folder_path.AppendASCII(wallet_first_address);
+
+    create_v1_database(db_path, rows_count);
+
+    int64_t v1_size = 0;
+    ASSERT_TRUE(base::GetFileSize(db_path, &v1_size));
+
+    base::TimeDelta v1_query;
+    {
+        sql::Database db;
+        ASSERT_TRUE(db.Open(db_path));
+
+        base::ElapsedTimer timer;
+        sql::Statement statement(db.GetUniqueStatement(
+            "SELECT txid FROM transactions WHERE address_to=? ORDER BY at DESC, txid LIMIT 50"));
+        statement.BindString(0, "NbxAddressTo3");
+        while (statement.Step())
+        {
+        }
+        v1_query = timer.Elapsed();
+    }
+
+    TransactionDBHelper db_helper;
+    db_helper.set_db_path(temp_dir_.GetPath());
+
+    base::ElapsedTimer migration_timer;
+    ASSERT_TRUE(db_helper.check_database(wallet_first_address, false));
+    base::TimeDelta migration_time = migration_timer.Elapsed();
+
+    sql::Statement count_statement(db_helper.get_db()->GetUniqueStatement("SELECT count(*), sum(amount) - sum(fee) FROM transactions"));
+    ASSERT_TRUE(count_statement.Step());
+    ASSERT_EQ(rows_count, count_statement.ColumnInt(0));
+    ASSERT_EQ(count_statement.ColumnInt64(1), db_helper.get_balance());
+
+    base::ElapsedTimer v2_timer;
+    base::Value params(base::Value::Type::DICTIONARY);
+    base::Value address_to(base::Value::Type::LIST);
+    address_to.Append("NbxAddressTo3");
+    params.SetKey("address_to", std::move(address_to));
+    params.SetIntKey("limit", 50);
+    base::Value result = db_helper.get_transactions(params);
+    base::TimeDelta v2_query = v2_timer.Elapsed();
+
+    ASSERT_EQ(50u, result.FindListKey("transactions")->GetList().size());
+
+    // wal holds part of the pages until checkpoint
+    ASSERT_TRUE(db_helper.get_db()->Execute("PRAGMA wal_checkpoint(TRUNCATE)"));
+    int64_t v2_size = 0;
+    ASSERT_TRUE(base::GetFileSize(db_path, &v2_size));
+
+    LOG(INFO) << "schema v1 -> v2, " << rows_count << " rows, migration ms " << migration_time.InMilliseconds()
+              << ", size " << v1_size << " -> " << v2_size
+              << ", address page us " << v1_query.InMicroseconds() << " -> " << v2_query.InMicroseconds();
+}
+
+}
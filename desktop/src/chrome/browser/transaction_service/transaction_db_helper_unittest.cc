@@ -0,0 +1,176 @@
+#include <string>
+
+#include "base/files/scoped_temp_dir.h"
+#include "base/strings/stringprintf.h"
+#include "chrome/browser/transaction_service/transaction_db_helper.h"
+#include "chrome/browser/transaction_service/transaction_model.h"
+#include "sql/statement.h"
+#include "sql/transaction.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+class NetboxTransactionDBHelperTest : public ::testing::Test {
+public:
+    NetboxTransactionDBHelperTest() = default;
+    ~NetboxTransactionDBHelperTest() override = default;
+
+    void SetUp() override
+    {
+        ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+
+        db_helper_.set_db_path(temp_dir_.GetPath());
+        ASSERT_TRUE(db_helper_.check_database("test", false));
+    }
+
+    TransactionData make_transaction(std::string txid, std::string category, std::string address_to, int64_t amount, int64_t fee)
+    {
+        TransactionData transaction;
+        transaction.txid        = txid;
+        transaction.category    = category;
+        transaction.address_to  = address_to;
+        transaction.amount      = amount;
+        transaction.fee         = fee;
+        transaction.at          = 1600000000;
+
+        return transaction;
+    }
+
+    std::map<std::string, TransactionData> make_rpc_data(int rows_count, int confirmations)
+    {
+        std::map<std::string, TransactionData> rpc_data;
+        for (int i = 0; i < rows_count; ++i)
+        {
+            TransactionData transaction = make_transaction(base::StringPrintf("%064x", i), (i % 3) ? "receive" : "stake",
+                                                           base::StringPrintf("NbxAddress%d", i % 8), i % 1000, 1);
+            transaction.confirmations = confirmations;
+
+            rpc_data.insert({transaction.key(), std::move(transaction)});
+        }
+
+        return rpc_data;
+    }
+
+protected:
+    base::ScopedTempDir temp_dir_;
+    TransactionDBHelper db_helper_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxTransactionDBHelperTest);
+};
+
+TEST_F(NetboxTransactionDBHelperTest, MaintainedBalances)
+{
+    ASSERT_EQ(0, db_helper_.get_balance());
+
+    ASSERT_TRUE(db_helper_.insert_or_update(make_transaction("1", "receive", "a", 1000, 0)));
+    ASSERT_TRUE(db_helper_.insert_or_update(make_transaction("2", "send", "b", -300, 10)));
+    ASSERT_TRUE(db_helper_.insert_or_update(make_transaction("3", "receive", "a", 50, 0)));
+
+    ASSERT_EQ(740,  db_helper_.get_balance());
+    ASSERT_EQ(1050, db_helper_.get_address_balance("a"));
+    ASSERT_EQ(-310, db_helper_.get_address_balance("b"));
+
+    // conflicted transactions are not counted
+    ASSERT_TRUE(db_helper_.set_conflicted(make_transaction("3", "receive", "a", 50, 0)));
+    ASSERT_EQ(690,  db_helper_.get_balance());
+    ASSERT_EQ(1000, db_helper_.get_address_balance("a"));
+
+    // confirmations update does not touch balances
+    TransactionData confirmed = make_transaction("1", "receive", "a", 1000, 0);
+    confirmed.confirmations = 10;
+    ASSERT_TRUE(db_helper_.update(confirmed));
+    ASSERT_EQ(690,  db_helper_.get_balance());
+
+    ASSERT_TRUE(db_helper_.check_balances(false));
+
+    // balances drift is found and repaired
+    ASSERT_TRUE(db_helper_.get_db()->Execute("UPDATE balances SET amount=amount+1 WHERE kind='total'"));
+    ASSERT_FALSE(db_helper_.check_balances(true));
+    ASSERT_TRUE(db_helper_.check_balances(false));
+
+    sql::Statement statement(db_helper_.get_db()->GetUniqueStatement("SELECT sum(amount) - sum(fee) FROM transactions WHERE conflicted=0"));
+    ASSERT_TRUE(statement.Step());
+    ASSERT_EQ(statement.ColumnInt64(0), db_helper_.get_balance());
+}
+
+TEST_F(NetboxTransactionDBHelperTest, ReplaceRange)
+{
+    TransactionData old_block = make_transaction("1", "receive", "a", 1000, 0);
+    old_block.blockhash = "b1";
+    old_block.confirmations = 101;
+    ASSERT_TRUE(db_helper_.insert_or_update(old_block));
+
+    // wrong amount stored for the second block
+    TransactionData new_block = make_transaction("2", "receive", "a", 1, 0);
+    new_block.blockhash = "b2";
+    new_block.confirmations = 5;
+    new_block.at = 1600000100;
+    ASSERT_TRUE(db_helper_.insert_or_update(new_block));
+
+    std::vector<TransactionCheckpoint> checkpoints = db_helper_.get_checkpoints();
+    ASSERT_EQ(2u, checkpoints.size());
+    ASSERT_EQ("b1", checkpoints[0].blockhash);
+    ASSERT_EQ("b2", checkpoints[1].blockhash);
+
+    // listsinceblock b1
+    std::map<std::string, TransactionData> rpc_data;
+    TransactionData rpc_block = make_transaction("2", "receive", "a", 500, 0);
+    rpc_block.blockhash = "b2";
+    rpc_block.confirmations = 6;
+    rpc_data.insert({rpc_block.key(), std::move(rpc_block)});
+
+    std::set<std::string> range_blocks = {"", "b2"};
+    ASSERT_FALSE(db_helper_.is_range_consistent(range_blocks, rpc_data));
+
+    ASSERT_TRUE(db_helper_.replace_range(range_blocks, rpc_data));
+    ASSERT_TRUE(db_helper_.is_range_consistent(range_blocks, rpc_data));
+
+    // rows before the range are kept
+    ASSERT_EQ(1500, db_helper_.get_balance());
+    ASSERT_TRUE(db_helper_.check_balances(false));
+}
+
+TEST_F(NetboxTransactionDBHelperTest, BulkStats)
+{
+    TransactionBulkStats stats;
+    ASSERT_TRUE(db_helper_.bulk_insert_or_update(make_rpc_data(250, 1), &stats));
+    ASSERT_EQ(250, stats.inserted);
+    ASSERT_EQ(0,   stats.updated);
+    ASSERT_EQ(0,   stats.unchanged);
+
+    // same payload, nothing to write
+    stats = TransactionBulkStats();
+    ASSERT_TRUE(db_helper_.bulk_insert_or_update(make_rpc_data(250, 1), &stats));
+    ASSERT_EQ(0,   stats.inserted);
+    ASSERT_EQ(0,   stats.updated);
+    ASSERT_EQ(250, stats.unchanged);
+
+    // confirmations moved for old rows, 50 new rows on top
+    stats = TransactionBulkStats();
+    ASSERT_TRUE(db_helper_.bulk_insert_or_update(make_rpc_data(300, 2), &stats));
+    ASSERT_EQ(50,  stats.inserted);
+    ASSERT_EQ(250, stats.updated);
+    ASSERT_EQ(0,   stats.unchanged);
+
+    // balance is the same as with row by row path
+    TransactionDBHelper row_db_helper;
+    row_db_helper.set_db_path(temp_dir_.GetPath());
+    ASSERT_TRUE(row_db_helper.check_database("test_row", false));
+
+    std::map<std::string, TransactionData> rpc_data = make_rpc_data(300, 2);
+
+    sql::Transaction committer(row_db_helper.get_db());
+    ASSERT_TRUE(committer.Begin());
+    for (auto it = rpc_data.begin(); it != rpc_data.end(); ++it)
+    {
+        ASSERT_TRUE(row_db_helper.insert_or_update(it->second));
+    }
+    ASSERT_TRUE(committer.Commit());
+
+    ASSERT_EQ(row_db_helper.get_balance(), db_helper_.get_balance());
+    ASSERT_TRUE(db_helper_.check_balances(false));
+}
+
+}
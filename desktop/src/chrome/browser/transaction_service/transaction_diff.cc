@@ -0,0 +1,175 @@
+#include "chrome/browser/transaction_service/transaction_diff.h"
+
+#include "base/hash/hash.h"
+
+namespace Netboxglobal
+{
+
+TransactionChanges::TransactionChanges() = default;
+TransactionChanges::~TransactionChanges() = default;
+TransactionChanges::TransactionChanges(TransactionChanges&&) = default;
+TransactionChanges& TransactionChanges::operator=(TransactionChanges&&) = default;
+
+TransactionDiff::TransactionDiff()
+{
+}
+
+TransactionDiff::~TransactionDiff()
+{
+}
+
+void TransactionDiff::set_stored(std::map<std::string, TransactionData> stored)
+{
+    stored_.clear();
+    full_key_index_.clear();
+    without_address_from_index_.clear();
+
+    stored_.reserve(stored.size());
+    full_key_index_.reserve(stored.size());
+    without_address_from_index_.reserve(stored.size());
+
+    for (auto it = stored.begin(); it != stored.end(); ++it)
+    {
+        size_t position = stored_.size();
+
+        full_key_index_[full_key_hash(it->second)].push_back(position);
+        without_address_from_index_[key_without_address_from_hash(it->second)].push_back(position);
+
+        StoredRow row;
+        row.data = std::move(it->second);
+        stored_.push_back(std::move(row));
+    }
+}
+
+TransactionChanges TransactionDiff::compare(std::map<std::string, TransactionData> rpc_data)
+{
+    TransactionChanges changes;
+
+    // rpc_data new ... old, so iterate in reverse order
+    for (auto rpc_it = rpc_data.rbegin(); rpc_it != rpc_data.rend(); ++rpc_it)
+    {
+        TransactionData& rpc_row = rpc_it->second;
+
+        if (rpc_row.confirmations >= ENOUGH_CONFIRMATION_COUNT && !rpc_row.conflicted)
+        {
+            changes.latest_block = rpc_row.blockhash;
+        }
+
+        StoredRow* stored_row = find_full_key(rpc_row);
+        if (!stored_row)
+        {
+            // do not insert empty from transaction, it only confirms the stored one
+            if (rpc_row.address_from.empty() && -1 == rpc_row.confirmations)
+            {
+                StoredRow* same_row = find_without_address_from(rpc_row);
+                if (same_row)
+                {
+                    same_row->matched = true;
+                }
+
+                continue;
+            }
+
+            changes.inserts.insert({rpc_it->first, std::move(rpc_row)});
+            continue;
+        }
+
+        stored_row->matched = true;
+
+        if (is_changed(stored_row->data, rpc_row))
+        {
+            changes.updates.insert({rpc_it->first, std::move(rpc_row)});
+        }
+    }
+
+    for (StoredRow& row : stored_)
+    {
+        if (!row.matched)
+        {
+            changes.conflicts.push_back(std::move(row.data));
+        }
+    }
+
+    stored_.clear();
+    full_key_index_.clear();
+    without_address_from_index_.clear();
+
+    return changes;
+}
+
+// static
+size_t TransactionDiff::full_key_hash(const TransactionData& data)
+{
+    return base::HashInts(key_without_address_from_hash(data), base::FastHash(data.address_from));
+}
+
+// static
+size_t TransactionDiff::key_without_address_from_hash(const TransactionData& data)
+{
+    size_t hash = base::HashInts(base::FastHash(data.txid), base::FastHash(data.address_to));
+    hash = base::HashInts(hash, base::FastHash(data.category));
+
+    return base::HashInts(hash, static_cast<uint64_t>(data.amount));
+}
+
+// static
+bool TransactionDiff::is_same_key(const TransactionData& a, const TransactionData& b)
+{
+    return a.txid == b.txid
+        && a.address_to == b.address_to
+        && a.category == b.category
+        && a.address_from == b.address_from;
+}
+
+// static
+bool TransactionDiff::is_changed(const TransactionData& stored, const TransactionData& rpc)
+{
+    return stored.confirmations != rpc.confirmations
+        || stored.conflicted != rpc.conflicted
+        || stored.blocknumber != rpc.blocknumber
+        || stored.blockhash != rpc.blockhash
+        || stored.at != rpc.at;
+}
+
+TransactionDiff::StoredRow* TransactionDiff::find_full_key(const TransactionData& data)
+{
+    auto it = full_key_index_.find(full_key_hash(data));
+    if (it == full_key_index_.end())
+    {
+        return nullptr;
+    }
+
+    for (size_t position : it->second)
+    {
+        StoredRow& row = stored_[position];
+        if (!row.matched && is_same_key(row.data, data))
+        {
+            return &row;
+        }
+    }
+
+    return nullptr;
+}
+
+TransactionDiff::StoredRow* TransactionDiff::find_without_address_from(const TransactionData& data)
+{
+    auto it = without_address_from_index_.find(key_without_address_from_hash(data));
+    if (it == without_address_from_index_.end())
+    {
+        return nullptr;
+    }
+
+    // first one in stored key order, as the map scan did
+    for (size_t position : it->second)
+    {
+        StoredRow& row = stored_[position];
+        if (!row.matched && row.data.is_same_without_address_from(data))
+        {
+            return &row;
+        }
+    }
+
+    return nullptr;
+}
+
+}
@@ -0,0 +1,72 @@
+#ifndef CHROME_BROWSER_TRANSACTION_DIFF_H_
+#define CHROME_BROWSER_TRANSACTION_DIFF_H_
+
+#include <map>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include "base/macros.h"
+#include "chrome/browser/transaction_service/transaction_model.h"
+
+namespace Netboxglobal
+{
+
+// result of one listsinceblock vs stored rows comparison
+class TransactionChanges
+{
+public:
+    TransactionChanges();
+    ~TransactionChanges();
+    TransactionChanges(TransactionChanges&&);
+    TransactionChanges& operator=(TransactionChanges&&);
+
+    std::map<std::string, TransactionData> inserts;
+    std::map<std::string, TransactionData> updates;
+    // stored rows missing in the rpc response
+    std::vector<TransactionData> conflicts;
+    std::string latest_block;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(TransactionChanges);
+};
+
+// compares rpc rows with stored unconfirmed rows in linear time,
+// stored rows are indexed by 64 bit hashes of the full key and of the key without address_from,
+// hash hits are verified against the fields, so collisions only cost a comparison
+class TransactionDiff
+{
+public:
+    TransactionDiff();
+    ~TransactionDiff();
+
+    // unconfirmed and not conflicted rows from the database
+    void set_stored(std::map<std::string, TransactionData> stored);
+
+    TransactionChanges compare(std::map<std::string, TransactionData> rpc_data);
+
+private:
+    struct StoredRow
+    {
+        TransactionData data;
+        bool matched = false;
+    };
+
+    static size_t full_key_hash(const TransactionData& data);
+    static size_t key_without_address_from_hash(const TransactionData& data);
+    static bool is_same_key(const TransactionData& a, const TransactionData& b);
+    static bool is_changed(const TransactionData& stored, const TransactionData& rpc);
+
+    StoredRow* find_full_key(const TransactionData& data);
+    StoredRow* find_without_address_from(const TransactionData& data);
+
+    std::vector<StoredRow> stored_;
+    // hash -> positions in stored_, in stored key order
+    std::unordered_map<size_t, std::vector<size_t>> full_key_index_;
+    std::unordered_map<size_t, std::vector<size_t>> without_address_from_index_;
+
+    DISALLOW_COPY_AND_ASSIGN(TransactionDiff);
+};
+
+}
+#endif
@@ -0,0 +1,207 @@
+#include <string>
+
+#include "base/strings/stringprintf.h"
+#include "base/timer/elapsed_timer.h"
+#include "chrome/browser/transaction_service/transaction_diff.h"
+#include "chrome/browser/transaction_service/transaction_model.h"
+#include "testing/gtest/include/gtest/gtest.h"
+
+namespace Netboxglobal
+{
+
+class NetboxTransactionDiffTest : public ::testing::Test {
+public:
+    NetboxTransactionDiffTest() = default;
+    ~NetboxTransactionDiffTest() override = default;
+
+    static TransactionData make_transaction(std::string txid, std::string address_from, int confirmations, int64_t amount = 100)
+    {
+        TransactionData transaction;
+        transaction.txid            = txid;
+        transaction.category        = "receive";
+        transaction.address_to      = "NbxTo";
+        transaction.address_from    = address_from;
+        transaction.amount          = amount;
+        transaction.at              = 1600000000;
+        transaction.confirmations   = confirmations;
+
+        return transaction;
+    }
+
+    static void add(std::map<std::string, TransactionData>& data, TransactionData transaction)
+    {
+        std::string key = transaction.key();
+        data.insert({key, std::move(transaction)});
+    }
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NetboxTransactionDiffTest);
+};
+
+TEST_F(NetboxTransactionDiffTest, InsertUpdateUnchanged)
+{
+    std::map<std::string, TransactionData> stored;
+    add(stored, make_transaction("a", "NbxFrom", 1));
+    add(stored, make_transaction("b", "NbxFrom", 1));
+
+    std::map<std::string, TransactionData> rpc_data;
+    add(rpc_data, make_transaction("a", "NbxFrom", 1));
+    add(rpc_data, make_transaction("b", "NbxFrom", 2));
+    add(rpc_data, make_transaction("c", "NbxFrom", 0));
+
+    TransactionDiff diff;
+    diff.set_stored(std::move(stored));
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_EQ(1u, changes.inserts.size());
+    ASSERT_EQ("c", changes.inserts.begin()->second.txid);
+    ASSERT_EQ(1u, changes.updates.size());
+    ASSERT_EQ("b", changes.updates.begin()->second.txid);
+    ASSERT_TRUE(changes.conflicts.empty());
+}
+
+TEST_F(NetboxTransactionDiffTest, BlockFieldsAreCompared)
+{
+    std::map<std::string, TransactionData> stored;
+    add(stored, make_transaction("a", "NbxFrom", 5));
+
+    std::map<std::string, TransactionData> rpc_data;
+    TransactionData moved = make_transaction("a", "NbxFrom", 5);
+    moved.blockhash = "other";
+    add(rpc_data, std::move(moved));
+
+    TransactionDiff diff;
+    diff.set_stored(std::move(stored));
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_TRUE(changes.inserts.empty());
+    ASSERT_EQ(1u, changes.updates.size());
+}
+
+TEST_F(NetboxTransactionDiffTest, MissingRowsAreConflicted)
+{
+    std::map<std::string, TransactionData> stored;
+    add(stored, make_transaction("a", "NbxFrom", 1));
+    add(stored, make_transaction("gone", "NbxFrom", 1));
+
+    std::map<std::string, TransactionData> rpc_data;
+    add(rpc_data, make_transaction("a", "NbxFrom", 1));
+
+    TransactionDiff diff;
+    diff.set_stored(std::move(stored));
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_TRUE(changes.inserts.empty());
+    ASSERT_TRUE(changes.updates.empty());
+    ASSERT_EQ(1u, changes.conflicts.size());
+    ASSERT_EQ("gone", changes.conflicts[0].txid);
+}
+
+// mempool copy of a stored row comes without address_from and is never inserted
+TEST_F(NetboxTransactionDiffTest, EmptyAddressFromMatchesStoredRow)
+{
+    std::map<std::string, TransactionData> stored;
+    add(stored, make_transaction("a", "NbxFrom1", 0));
+    add(stored, make_transaction("a", "NbxFrom2", 0));
+
+    std::map<std::string, TransactionData> rpc_data;
+    add(rpc_data, make_transaction("a", "", -1));
+    // different amount is a different transfer
+    add(rpc_data, make_transaction("b", "", -1, 7));
+
+    TransactionDiff diff;
+    diff.set_stored(std::move(stored));
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_TRUE(changes.inserts.empty());
+    ASSERT_TRUE(changes.updates.empty());
+
+    // only the first stored row in key order is taken by the empty one
+    ASSERT_EQ(1u, changes.conflicts.size());
+    ASSERT_EQ("NbxFrom2", changes.conflicts[0].address_from);
+}
+
+TEST_F(NetboxTransactionDiffTest, EmptyAddressFromWithConfirmationsIsInserted)
+{
+    std::map<std::string, TransactionData> rpc_data;
+    add(rpc_data, make_transaction("a", "", 3));
+
+    TransactionDiff diff;
+    diff.set_stored(std::map<std::string, TransactionData>());
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_EQ(1u, changes.inserts.size());
+}
+
+TEST_F(NetboxTransactionDiffTest, RowMatchedByFullKeyIsNotReused)
+{
+    std::map<std::string, TransactionData> stored;
+    add(stored, make_transaction("a", "NbxFrom", 0));
+
+    // "a-NbxTo-receive" sorts before "a-NbxTo-receiveNbxFrom", so the full key row goes first in reverse order
+    std::map<std::string, TransactionData> rpc_data;
+    add(rpc_data, make_transaction("a", "NbxFrom", 0));
+    add(rpc_data, make_transaction("a", "", -1));
+
+    TransactionDiff diff;
+    diff.set_stored(std::move(stored));
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_TRUE(changes.inserts.empty());
+    ASSERT_TRUE(changes.updates.empty());
+    ASSERT_TRUE(changes.conflicts.empty());
+}
+
+TEST_F(NetboxTransactionDiffTest, LatestBlock)
+{
+    std::map<std::string, TransactionData> rpc_data;
+
+    TransactionData old_block = make_transaction("a", "NbxFrom", ENOUGH_CONFIRMATION_COUNT + 1);
+    old_block.blockhash = "block1";
+    add(rpc_data, std::move(old_block));
+
+    TransactionData new_block = make_transaction("b", "NbxFrom", ENOUGH_CONFIRMATION_COUNT);
+    new_block.blockhash = "block2";
+    add(rpc_data, std::move(new_block));
+
+    TransactionData conflicted = make_transaction("0", "NbxFrom", ENOUGH_CONFIRMATION_COUNT);
+    conflicted.blockhash = "block0";
+    conflicted.conflicted = true;
+    add(rpc_data, std::move(conflicted));
+
+    TransactionDiff diff;
+    diff.set_stored(std::map<std::string, TransactionData>());
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    // same order as the sync loop always used
+    ASSERT_EQ("block1", changes.latest_block);
+    ASSERT_EQ(3u, changes.inserts.size());
+}
+
+TEST_F(NetboxTransactionDiffTest, MempoolSpike)
+{
+    const int rows_count = 50000;
+
+    std::map<std::string, TransactionData> stored;
+    std::map<std::string, TransactionData> rpc_data;
+    for (int i = 0; i < rows_count; ++i)
+    {
+        std::string txid = base::StringPrintf("%064x", i);
+        add(stored, make_transaction(txid, "NbxFrom", 0));
+        add(rpc_data, make_transaction(txid, "", -1));
+    }
+
+    base::ElapsedTimer timer;
+
+    TransactionDiff diff;
+    diff.set_stored(std::move(stored));
+    TransactionChanges changes = diff.compare(std::move(rpc_data));
+
+    ASSERT_TRUE(changes.inserts.empty());
+    ASSERT_TRUE(changes.conflicts.empty());
+
+    // quadratic scan took minutes here
+    ASSERT_LT(timer.Elapsed().InSeconds(), 10);
+}
+
+}
@@ -38,6 +38,45 @@ void json_helper_amount(const base::Value& value, const std::string& key, int64_
     }
 }
 
+void append_transaction_json(const base::Value& transaction_json, std::map<std::string, TransactionData>& results)
+{
+    TransactionData transaction;
+
+    json_helper_str(transaction_json, "txid",              transaction.txid);
+    json_helper_str(transaction_json, "address",           transaction.address_to);
+    json_helper_str(transaction_json, "category",          transaction.category);
+    json_helper_str(transaction_json, "from",              transaction.address_from);
+    json_helper_str(transaction_json, "blockhash",         transaction.blockhash);
+    transaction.blocknumber                 = 0;
+    json_helper_int(transaction_json, "confirmations",     transaction.confirmations);
+    if (transaction.confirmations > ENOUGH_CONFIRMATION_COUNT)
+    {
+        transaction.confirmations = ENOUGH_CONFIRMATION_COUNT;
+    }
+    json_helper_int(transaction_json, "time",              transaction.at);
+    json_helper_amount(transaction_json, "amount",         transaction.amount);
+    json_helper_amount(transaction_json, "fee",            transaction.fee);
+    transaction.fee = std::abs(transaction.fee);
+
+
+    const base::Value* conflicts = transaction_json.FindListKey("walletconflicts");
+    transaction.conflicted = false;
+    if (conflicts && !conflicts->GetList().empty())
+    {
+        transaction.conflicted = true;
+    }
+
+    auto r = results.find(transaction.key());
+    if (r != results.end())
+    {
+        r->second.append(std::move(transaction));
+    }
+    else
+    {
+        results.insert({transaction.key(), std::move(transaction)});
+    }
+}
+
 std::map<std::string, TransactionData> parse_transactions_json(base::Value& json)
 {
     std::map<std::string, TransactionData> results;
@@ -61,48 +100,221 @@ std::map<std::string, TransactionData> parse_transactions_json(base::Value& json
     // group by txid, address, category, from
     // take first: confirmation_count, at, conflicted, blockhash
 
-    base::Value::ListView transactions_view = transactions->GetList();
+    for (const base::Value& transaction_json : transactions->GetList())
+    {
+        append_transaction_json(transaction_json, results);
+    }
+
+    return results;
+}
+
+TransactionStreamParser::TransactionStreamParser()
+{
+}
 
-    for (unsigned int i = 0; i < transactions_view.size(); i++) 
+TransactionStreamParser::~TransactionStreamParser()
+{
+}
+
+void TransactionStreamParser::append(base::StringPiece chunk)
+{
+    for (char c : chunk)
     {
-        TransactionData transaction;
-    
-        json_helper_str(transactions_view[i], "txid",              transaction.txid);
-        json_helper_str(transactions_view[i], "address",           transaction.address_to);
-        json_helper_str(transactions_view[i], "category",          transaction.category);
-        json_helper_str(transactions_view[i], "from",              transaction.address_from);
-        json_helper_str(transactions_view[i], "blockhash",         transaction.blockhash);
-        transaction.blocknumber                 = 0;
-        json_helper_int(transactions_view[i], "confirmations",     transaction.confirmations);
-        if (transaction.confirmations > ENOUGH_CONFIRMATION_COUNT)
+        if (failed_)
+        {
+            return;
+        }
+
+        if (record_depth_ > 0)
         {
-            transaction.confirmations = ENOUGH_CONFIRMATION_COUNT;
+            consume_record(c);
         }
-        json_helper_int(transactions_view[i], "time",              transaction.at);
-        json_helper_amount(transactions_view[i], "amount",         transaction.amount);
-        json_helper_amount(transactions_view[i], "fee",            transaction.fee);
-        transaction.fee = std::abs(transaction.fee);
+        else
+        {
+            consume(c);
+        }
+    }
+}
 
+void TransactionStreamParser::consume(char c)
+{
+    // inside "transactions": [...] only the closing bracket goes to the skeleton
+    bool in_transactions = transactions_depth_ > 0 && containers_.size() == transactions_depth_;
 
-        const base::Value* conflicts = transactions_view[i].FindListKey("walletconflicts");
-        transaction.conflicted = false;
-        if (conflicts && !conflicts->GetList().empty())
+    if (in_transactions && ']' != c)
+    {
+        if ('{' == c)
         {
-            transaction.conflicted = true;
+            record_.assign(1, c);
+            record_depth_ = 1;
         }
 
-        auto r = results.find(transaction.key());
-        if (r != results.end())
+        return;
+    }
+
+    skeleton_.push_back(c);
+
+    if (in_string_)
+    {
+        if (escape_)
         {
-            r->second.append(std::move(transaction));
+            escape_ = false;
         }
-        else
+        else if ('\\' == c)
         {
-            results.insert({transaction.key(), std::move(transaction)});
+            escape_ = true;
         }
+        else if ('"' == c)
+        {
+            in_string_ = false;
+
+            if (in_key_)
+            {
+                keys_.back() = key_;
+                in_key_ = false;
+            }
+
+            return;
+        }
+
+        if (in_key_)
+        {
+            key_.push_back(c);
+        }
+
+        return;
     }
 
-    return results;
+    switch (c)
+    {
+        case '"':
+            in_string_ = true;
+            in_key_ = expect_key_ && !containers_.empty() && '{' == containers_.back();
+            key_.clear();
+            break;
+        case ':':
+            expect_key_ = false;
+            break;
+        case ',':
+            expect_key_ = !containers_.empty() && '{' == containers_.back();
+            break;
+        case '{':
+            containers_.push_back(c);
+            keys_.push_back("");
+            expect_key_ = true;
+            break;
+        case '[':
+            // {"transactions":[...]}, {"result":{"transactions":[...]}} or the same inside a batch [...]
+            if (!containers_.empty()
+             && containers_.size() <= 3
+             && '{' == containers_.back()
+             && "transactions" == keys_.back())
+            {
+                transactions_depth_ = containers_.size() + 1;
+            }
+
+            containers_.push_back(c);
+            keys_.push_back("");
+            expect_key_ = false;
+            break;
+        case '}':
+        case ']':
+            if (containers_.empty() || (('}' == c) != ('{' == containers_.back())))
+            {
+                failed_ = true;
+                return;
+            }
+
+            if (containers_.size() == transactions_depth_)
+            {
+                transactions_depth_ = 0;
+            }
+
+            containers_.pop_back();
+            keys_.pop_back();
+            expect_key_ = false;
+            break;
+        default:
+            break;
+    }
+}
+
+void TransactionStreamParser::consume_record(char c)
+{
+    record_.push_back(c);
+
+    if (in_string_)
+    {
+        if (escape_)
+        {
+            escape_ = false;
+        }
+        else if ('\\' == c)
+        {
+            escape_ = true;
+        }
+        else if ('"' == c)
+        {
+            in_string_ = false;
+        }
+
+        return;
+    }
+
+    if ('"' == c)
+    {
+        in_string_ = true;
+    }
+    else if ('{' == c || '[' == c)
+    {
+        record_depth_++;
+    }
+    else if ('}' == c || ']' == c)
+    {
+        record_depth_--;
+
+        if (0 == record_depth_)
+        {
+            // a single record is small, so it's fine to decode it as a tree
+            absl::optional<base::Value> transaction_json = base::JSONReader::Read(record_);
+            if (transaction_json && transaction_json->is_dict())
+            {
+                append_transaction_json(*transaction_json, transactions_);
+            }
+            else
+            {
+                failed_ = true;
+            }
+
+            record_.clear();
+        }
+    }
+}
+
+std::string TransactionStreamParser::finish()
+{
+    finished_ = !failed_
+             && !skeleton_.empty()
+             && containers_.empty()
+             && 0 == record_depth_
+             && !in_string_;
+
+    return std::move(skeleton_);
+}
+
+bool TransactionStreamParser::is_finished()
+{
+    return finished_;
+}
+
+std::map<std::string, TransactionData> TransactionStreamParser::take_transactions()
+{
+    if (!finished_)
+    {
+        return {};
+    }
+
+    return std::move(transactions_);
 }
 
 }
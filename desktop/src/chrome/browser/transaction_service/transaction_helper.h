@@ -2,8 +2,11 @@
 #define CHROME_BROWSER_TRANSACTION_HELPER_H_
 
 #include <map>
+#include <string>
+#include <vector>
 
 #include "base/values.h"
+#include "chrome/browser/netbox/call/wallet_stream_parser.h"
 #include "chrome/browser/transaction_service/transaction_model.h"
 
 namespace Netboxglobal
@@ -11,5 +14,47 @@ namespace Netboxglobal
 
 std::map<std::string, TransactionData> parse_transactions_json(base::Value&);
 
+// SAX-style decoder for listsinceblock responses, every element of the "transactions" array
+// becomes TransactionData as soon as its chunk arrives, the rest of the body is kept as is
+class TransactionStreamParser : public IWalletStreamParser
+{
+public:
+    TransactionStreamParser();
+    ~TransactionStreamParser() override;
+
+    // IWalletStreamParser interface
+    void append(base::StringPiece chunk) override;
+    std::string finish() override;
+
+    // true when the whole body was received and is well formed
+    bool is_finished();
+    std::map<std::string, TransactionData> take_transactions();
+
+private:
+    void consume(char c);
+    void consume_record(char c);
+
+    std::string skeleton_;
+    std::string record_;
+    std::string key_;
+
+    std::vector<char> containers_;
+    std::vector<std::string> keys_;
+
+    size_t transactions_depth_ = 0;
+    int record_depth_ = 0;
+
+    bool in_string_ = false;
+    bool in_key_ = false;
+    bool escape_ = false;
+    bool expect_key_ = false;
+    bool failed_ = false;
+    bool finished_ = false;
+
+    std::map<std::string, TransactionData> transactions_;
+
+    DISALLOW_COPY_AND_ASSIGN(TransactionStreamParser);
+};
+
 }
 #endif
@@ -95,4 +95,75 @@ TEST_F(NetboxTransactionRequestParserTest, ParserValidation)
     ASSERT_EQ("-900000000", get_string_by_key(r, "3-1-send5", "amount"));
 }
 
-}
\ No newline at end of file
+TEST_F(NetboxTransactionRequestParserTest, StreamParserValidation)
+{
+    std::string json_raw = "{\"result\":{\"transactions\":[ "
+            "{\"txid\":\"0\",\"fee\":-0.00040000, \"walletconflicts\":[\"x\"]},"
+            "{\"txid\":\"2\",\"amount\":2, \"comment\":\"{[\\\"}]\"},"
+            "{\"txid\":\"2\",\"amount\":0.00000002},"
+            "{\"txid\":\"3\",\"fee\":0.00000009,\"amount\":-8, \"category\":\"send\", \"address\":\"1\", \"from\":\"4\"},"
+            "{\"txid\":\"3\",\"fee\":0.00000009,\"amount\":-9, \"category\":\"send\", \"address\":\"1\", \"from\":\"5\"}"
+    " ], \"removed\":[{\"txid\":\"9\"}], \"lastblock\":\"abc\"},\"error\":null,\"id\":null}";
+
+    // chunk boundaries must not matter
+    for (size_t chunk_size : {1, 3, 64, 4096})
+    {
+        TransactionStreamParser parser;
+        for (size_t i = 0; i < json_raw.size(); i += chunk_size)
+        {
+            parser.append(base::StringPiece(json_raw).substr(i, chunk_size));
+        }
+
+        absl::optional<base::Value> skeleton = base::JSONReader::Read(parser.finish());
+        ASSERT_TRUE(skeleton && skeleton->is_dict());
+        ASSERT_EQ("abc", *skeleton->FindStringPath("result.lastblock"));
+        ASSERT_TRUE(skeleton->FindListPath("result.transactions")->GetList().empty());
+        ASSERT_EQ(1u, skeleton->FindListPath("result.removed")->GetList().size());
+
+        ASSERT_TRUE(parser.is_finished());
+        std::map<std::string, TransactionData> r = parser.take_transactions();
+
+        ASSERT_EQ(4u, r.size());
+        ASSERT_EQ("40000",      get_string_by_key(r, "0--", "fee"));
+        ASSERT_TRUE(r.find("0--")->second.conflicted);
+        ASSERT_EQ("200000002",  get_string_by_key(r, "2--", "amount"));
+        ASSERT_EQ("-800000000", get_string_by_key(r, "3-1-send4", "amount"));
+        ASSERT_EQ("-900000000", get_string_by_key(r, "3-1-send5", "amount"));
+    }
+
+    // truncated body gives no records
+    TransactionStreamParser parser;
+    parser.append(base::StringPiece(json_raw).substr(0, json_raw.size() / 2));
+    parser.finish();
+
+    ASSERT_FALSE(parser.is_finished());
+    ASSERT_TRUE(parser.take_transactions().empty());
+}
+
+TEST_F(NetboxTransactionRequestParserTest, StreamParserBatch)
+{
+    std::string json_raw = "[{\"result\":{\"transactions\":["
+            "{\"txid\":\"0\",\"fee\":-0.00040000},"
+            "{\"txid\":\"2\",\"amount\":2}"
+    "], \"lastblock\":\"abc\"},\"error\":null,\"id\":0},"
+    "{\"result\":{\"IsBlockchainSynced\":true},\"error\":null,\"id\":1},"
+    "{\"result\":1.5,\"error\":null,\"id\":2}]";
+
+    TransactionStreamParser parser;
+    parser.append(json_raw);
+
+    absl::optional<base::Value> skeleton = base::JSONReader::Read(parser.finish());
+    ASSERT_TRUE(skeleton && skeleton->is_list());
+    ASSERT_EQ(3u, skeleton->GetList().size());
+    ASSERT_EQ("abc", *skeleton->GetList()[0].FindStringPath("result.lastblock"));
+    ASSERT_TRUE(skeleton->GetList()[0].FindListPath("result.transactions")->GetList().empty());
+
+    ASSERT_TRUE(parser.is_finished());
+    std::map<std::string, TransactionData> r = parser.take_transactions();
+
+    ASSERT_EQ(2u, r.size());
+    ASSERT_EQ("40000",      get_string_by_key(r, "0--", "fee"));
+    ASSERT_EQ("200000000",  get_string_by_key(r, "2--", "amount"));
+}
+
+}
@@ -3,16 +3,36 @@
 #include "base/base64.h"
 #include "base/bind.h"
 #include "base/json/json_writer.h"
+#include "base/metrics/histogram_functions.h"
 #include "base/task/post_task.h"
 #include "base/task/task_traits.h"
 #include "base/task/thread_pool.h"
+#include "base/task_runner_util.h"
 #include "chrome/browser/browser_process_impl.h"
+#include "chrome/browser/transaction_service/transaction_diff.h"
 #include "chrome/browser/transaction_service/transaction_helper.h"
 #include "chrome/browser/netbox/wallet_manager/wallet_manager.h"
 #include "content/public/browser/browser_task_traits.h"
 #include "content/public/browser/browser_thread.h"
 #include "sql/transaction.h"
 
+static const int32_t SYNC_INTERVAL_SEC = 60;
+
+static const int32_t SYNC_FAST_INTERVAL_SEC = 15;
+
+static const int32_t SYNC_MAX_INTERVAL_SEC = 300;
+
+static const int32_t SYNC_MAX_SKIPPED_CYCLES = 5;
+
+static const int32_t READ_CONNECTIONS_COUNT = 2;
+
+static const size_t WALLET_DB_POOL_SIZE = 4;
+
+static const int32_t BEST_BLOCK_MAX_RETRIES = 1;
+
+// longer than any call deadline with its retries
+static const int32_t SYNC_STUCK_SEC = 600;
+
 namespace Netboxglobal
 {
 
@@ -20,8 +40,22 @@ TransactionService::TransactionService()
 {
     DETACH_FROM_SEQUENCE(sequence_checker_);
 
-    db_helper_.reset(new TransactionDBHelper());
+    // placeholder until the first address comes, it is never opened
+    WalletDB wallet_db;
+    wallet_db.db_helper = std::make_unique<TransactionDBHelper>();
+    db_helper_ = wallet_db.db_helper.get();
+    db_wallets_.push_back(std::move(wallet_db));
+
     task_runner_ = base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock(), base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+
+    for (int32_t i = 0; i < READ_CONNECTIONS_COUNT; ++i)
+    {
+        Reader reader;
+        reader.task_runner = base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock(), base::TaskPriority::USER_VISIBLE, base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN});
+        reader.db_helper = std::make_unique<TransactionDBHelper>();
+
+        ui_readers_.push_back(std::move(reader));
+    }
 }
 
 TransactionService::~TransactionService()
@@ -37,7 +71,14 @@ void TransactionService::ui_stop()
 
     ui_requests_.clear();
     task_runner_.reset();
-    db_helper_.reset();
+    db_helper_ = nullptr;
+    db_wallets_.clear();
+
+    for (Reader& reader : ui_readers_)
+    {
+        reader.task_runner->DeleteSoon(FROM_HERE, std::move(reader.db_helper));
+    }
+    ui_readers_.clear();
 }
 
 void TransactionService::ui_pre_start(base::FilePath profile_path)
@@ -47,13 +88,25 @@ void TransactionService::ui_pre_start(base::FilePath profile_path)
     task_runner_->PostTask(FROM_HERE,
                          base::BindOnce(&TransactionService::db_set_path, base::Unretained(this),
                          profile_path));
+
+    for (Reader& reader : ui_readers_)
+    {
+        reader.task_runner->PostTask(FROM_HERE,
+                         base::BindOnce(&TransactionDBHelper::set_db_path, base::Unretained(reader.db_helper.get()),
+                         profile_path));
+    }
 }
 
 void TransactionService::db_set_path(base::FilePath db_path)
 {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-    db_helper_->set_db_path(db_path);
+    db_profile_path_ = db_path;
+
+    for (WalletDB& wallet_db : db_wallets_)
+    {
+        wallet_db.db_helper->set_db_path(db_path);
+    }
 }
 
 void TransactionService::ui_set_rpc_token(WalletSessionManager::DataState, const WalletSessionManager::Data &)
@@ -82,6 +135,11 @@ void TransactionService::ui_set_first_address(std::string wallet_first_address)
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
+    if (!wallet_first_address.empty())
+    {
+        ui_wallet_first_address_ = wallet_first_address;
+    }
+
     task_runner_->PostTask(FROM_HERE,
                          base::BindOnce(&TransactionService::db_set_first_address, base::Unretained(this),
                          wallet_first_address));
@@ -94,35 +152,169 @@ void TransactionService::db_set_first_address(std::string wallet_first_address)
 
     if (db_wallet_first_address_ != wallet_first_address && !wallet_first_address.empty())
     {
-        db_loaded_ = false;
-        db_control_sum_check_failed_count_ = 0;
+        db_switch_wallet(wallet_first_address);
+    }
+
+    db_wallet_first_address_ = wallet_first_address;
+
+
+    std::unique_ptr<WalletHttpCallSignature> empty_request;
+    db_start(std::move(empty_request));
+}
+
+void TransactionService::db_switch_wallet(const std::string& wallet_first_address)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-        if (!db_helper_->check_database(wallet_first_address, false))
+    // sync state of the current wallet stays with its database
+    WalletDB& current = db_wallets_.front();
+    current.best_block_hash                 = db_best_block_hash_;
+    current.idle_cycles                     = db_idle_cycles_;
+    current.control_sum_check_failed_count  = db_control_sum_check_failed_count_;
+    current.loaded                          = loaded_;
+
+    auto it = db_wallets_.begin();
+    while (it != db_wallets_.end() && it->wallet_first_address != wallet_first_address)
+    {
+        ++it;
+    }
+
+    if (it != db_wallets_.end() && it->db_helper->is_open())
+    {
+        // history is served right away, the next cycle continues from its own latest_block
+        db_wallets_.splice(db_wallets_.begin(), db_wallets_, it);
+    }
+    else
+    {
+        if (it != db_wallets_.end())
+        {
+            db_wallets_.erase(it);
+        }
+
+        WalletDB wallet_db;
+        wallet_db.wallet_first_address = wallet_first_address;
+        wallet_db.db_helper = std::make_unique<TransactionDBHelper>();
+        wallet_db.db_helper->set_db_path(db_profile_path_);
+
+        if (!wallet_db.db_helper->check_database(wallet_first_address, false))
         {
             VLOG(1) << "Failed to open database for " << wallet_first_address;
         }
+
+        db_wallets_.push_front(std::move(wallet_db));
+
+        // placeholder and least recently used wallets are closed
+        while (db_wallets_.size() > WALLET_DB_POOL_SIZE || db_wallets_.back().wallet_first_address.empty())
+        {
+            db_wallets_.pop_back();
+        }
     }
 
-    db_wallet_first_address_ = wallet_first_address;
+    WalletDB& wallet_db = db_wallets_.front();
+    db_helper_                          = wallet_db.db_helper.get();
+    db_best_block_hash_                 = wallet_db.best_block_hash;
+    db_idle_cycles_                     = wallet_db.idle_cycles;
+    db_control_sum_check_failed_count_  = wallet_db.control_sum_check_failed_count;
+    loaded_                             = wallet_db.loaded;
 
+    VLOG(NETBOX_LOG_LEVEL) << "wallet database " << wallet_first_address << (loaded_ ? " from pool" : " opened")
+                           << ", open " << db_wallets_.size();
+}
 
-    std::unique_ptr<WalletHttpCallSignature> empty_request;
-    db_start(std::move(empty_request));
+void TransactionService::ui_set_manual_sync_for_testing(std::string token, base::RepeatingClosure sync_cycle_callback)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    task_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&TransactionService::db_set_manual_sync, base::Unretained(this),
+                         token, std::move(sync_cycle_callback)));
+}
+
+void TransactionService::db_set_manual_sync(std::string token, base::RepeatingClosure sync_cycle_callback)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    db_token_base64_ = token;
+    db_sync_cycle_callback_for_testing_ = std::move(sync_cycle_callback);
 }
 
-void TransactionService::schedule_transaction_request()
+void TransactionService::ui_sync_now_for_testing()
 {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    ui_start();
+}
+
+void TransactionService::db_schedule_transaction_request()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    // the harness starts the next cycle itself
+    if (db_sync_cycle_callback_for_testing_)
+    {
+        db_sync_cycle_callback_for_testing_.Run();
+        return;
+    }
+
+    base::TimeDelta delay = base::TimeDelta::FromSeconds(SYNC_INTERVAL_SEC);
+
+    if (db_helper_->is_open() && db_helper_->has_unconfirmed())
+    {
+        // waiting for confirmations
+        delay = base::TimeDelta::FromSeconds(SYNC_FAST_INTERVAL_SEC);
+    }
+    else if (db_idle_cycles_ > 0)
+    {
+        delay = std::min(delay * (1 << std::min(db_idle_cycles_, 8)), base::TimeDelta::FromSeconds(SYNC_MAX_INTERVAL_SEC));
+    }
+
+    db_schedule_sync(delay);
+}
+
+void TransactionService::db_schedule_sync(base::TimeDelta delay)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    int64_t generation = ++db_sync_generation_;
+
     base::PostDelayedTask(
         FROM_HERE,
         {
             content::BrowserThread::UI,
             base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
         },
-        base::BindOnce(&TransactionService::ui_start, base::Unretained(this)),
-        base::TimeDelta::FromSeconds(60)
+        base::BindOnce(&TransactionService::ui_start_scheduled, base::Unretained(this), generation),
+        delay
     );
 }
 
+void TransactionService::ui_start_scheduled(int64_t generation)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    if (!task_runner_)
+    {
+        return;
+    }
+
+    task_runner_->PostTask(FROM_HERE,
+                        base::BindOnce(&TransactionService::db_start_scheduled, base::Unretained(this), generation));
+}
+
+void TransactionService::db_start_scheduled(int64_t generation)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    // replaced by a later schedule
+    if (generation != db_sync_generation_)
+    {
+        return;
+    }
+
+    std::unique_ptr<WalletHttpCallSignature> empty_request;
+    db_start(std::move(empty_request));
+}
+
 void TransactionService::ui_start()
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
@@ -136,6 +328,15 @@ void TransactionService::db_start(std::unique_ptr<WalletHttpCallSignature> signa
 {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
+    // every call ends by its deadline, an answer lost anyway must not stop the sync for good
+    if (db_in_rpc_call_ && base::TimeTicks::Now() - db_rpc_call_started_at_ >= base::TimeDelta::FromSeconds(SYNC_STUCK_SEC))
+    {
+        LOG(WARNING) << "sync call did not finish, starting again";
+        base::UmaHistogramBoolean("Netbox.TransactionService.SyncRecovered", true);
+
+        db_in_rpc_call_ = false;
+    }
+
     if (db_wallet_first_address_.empty() || db_token_base64_.empty() || db_in_rpc_call_)
     {
         if (signature.get())
@@ -143,20 +344,142 @@ void TransactionService::db_start(std::unique_ptr<WalletHttpCallSignature> signa
             db_get_transactions(std::move(signature));
         }
 
+        // the cycle in flight or the missing wallet is looked at again
+        db_schedule_sync(base::TimeDelta::FromSeconds(SYNC_INTERVAL_SEC));
         return;
     }
 
     db_in_rpc_call_ = true;
+    db_rpc_call_started_at_ = base::TimeTicks::Now();
+
+    // watchdog, replaced by the schedule at the end of the cycle
+    db_schedule_sync(base::TimeDelta::FromSeconds(SYNC_STUCK_SEC));
+
+    // ui requests, first load and idle limit always go through the full cycle
+    if (signature.get()
+     || !loaded_
+     || db_idle_cycles_ >= SYNC_MAX_SKIPPED_CYCLES)
+    {
+        db_rpc_request(std::move(signature));
+        return;
+    }
+
+    // cheap probe, the full cycle is skipped while the chain tip is the same
+    auto best_block_signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_JSON);
+    best_block_signature->set_method_name("getbestblockhash");
+    best_block_signature->set_rpc_token(db_token_base64_);
+    best_block_signature->set_params(base::ListValue());
+    best_block_signature->set_max_retries(BEST_BLOCK_MAX_RETRIES);
+
+    base::Value extra_data(base::Value::Type::DICTIONARY);
+    extra_data.SetStringKey("wallet_first_address", db_wallet_first_address_);
+    best_block_signature->set_extra_data(std::move(extra_data));
+
+    base::PostTask(
+        FROM_HERE,
+        {
+            content::BrowserThread::UI,
+            base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
+        },
+        base::BindOnce(&TransactionService::ui_best_block_request, base::Unretained(this), std::move(best_block_signature))
+    );
+}
+
+void TransactionService::ui_best_block_request(std::unique_ptr<WalletHttpCallSignature> signature)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    if (g_browser_process->env_controller()->is_qa())
+    {
+        signature->set_qa(true);
+    }
+
+    // sync traffic waits behind the wallet tab calls
+    signature->set_priority(WalletCallPriority::BACKGROUND_SYNC);
+
+    std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
+    WalletRequest* http_request_ptr = http_request.get();
+
+    http_request->set_decode_in_background(true);
+
+    // the request may be answered and deleted inside start
+    ui_requests_[http_request_ptr] = std::move(http_request);
+
+    http_request_ptr->start(std::move(signature),
+        base::BindOnce(&TransactionService::ui_best_block_response, base::Unretained(this)));
+}
+
+void TransactionService::ui_best_block_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest* http_request_ptr)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    auto it = ui_requests_.find(http_request_ptr);
+    if (it == ui_requests_.end())
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "failed to find http_request, " << http_request_ptr;
+    }
+    else
+    {
+        std::unique_ptr<WalletRequest> http_request = std::move(it->second);
+        ui_requests_.erase(it);
+    }
+
+    task_runner_->PostTask(FROM_HERE,
+                         base::BindOnce(&TransactionService::db_best_block_response, base::Unretained(this),
+                         std::move(signature), std::move(result)));
+}
+
+void TransactionService::db_best_block_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    std::string* first_address = signature->get_extra_data().FindStringKey("wallet_first_address");
+    if (!first_address || *first_address != db_wallet_first_address_)
+    {
+        // the wallet changed in the middle of the cycle, the new one is synced now
+        db_in_rpc_call_ = false;
+        db_start(nullptr);
+        return;
+    }
+
+    const std::string* best_block_hash = result.is_dict() ? result.FindStringKey("result") : nullptr;
+
+    if (best_block_hash && *best_block_hash == db_best_block_hash_)
+    {
+        db_in_rpc_call_ = false;
+        db_idle_cycles_++;
+        db_sync_cycles_skipped_++;
+
+        base::UmaHistogramBoolean("Netbox.TransactionService.SyncCycleSkipped", true);
+        VLOG(NETBOX_LOG_LEVEL) << "sync cycle skipped, performed " << db_sync_cycles_performed_ << ", skipped " << db_sync_cycles_skipped_;
+
+        db_schedule_transaction_request();
+        return;
+    }
+
+    // remembered before listsinceblock, cleared again if it fails
+    db_best_block_hash_ = best_block_hash ? *best_block_hash : "";
+
+    std::unique_ptr<WalletHttpCallSignature> empty_request;
+    db_rpc_request(std::move(empty_request));
+}
+
+void TransactionService::db_rpc_request(std::unique_ptr<WalletHttpCallSignature> signature)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    db_sync_cycles_performed_++;
+    db_idle_cycles_ = 0;
+    base::UmaHistogramBoolean("Netbox.TransactionService.SyncCycleSkipped", false);
 
     std::unique_ptr<WalletHttpCallSignature> transactions_signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_JSON);
+    transactions_signature->set_method_name("listsinceblock");
 
     std::string db_latest_block = db_helper_->get_latest_block();
     base::ListValue params;
     params.Append(db_latest_block);
     transactions_signature->set_params(std::move(params));
 
-    transactions_signature->set_rpc_token(db_token_base64_);
-
     base::Value extra_data(base::Value::Type::DICTIONARY);
     extra_data.SetStringKey("wallet_first_address", db_wallet_first_address_);
     transactions_signature->set_extra_data(std::move(extra_data));
@@ -166,13 +489,34 @@ void TransactionService::db_start(std::unique_ptr<WalletHttpCallSignature> signa
         transactions_signature->set_external_signature(std::move(signature));
     }
 
+    // mnsync and getbalance of the cycle go in the same round trip,
+    // the balance is taken at the same wallet state as the transactions
+    std::unique_ptr<WalletHttpCallSignature> batch_signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_BATCH);
+    batch_signature->set_rpc_token(db_token_base64_);
+    batch_signature->add_batch_call(std::move(transactions_signature));
+
+    auto mnsync_signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_JSON);
+    mnsync_signature->set_method_name("mnsync");
+    base::Value mnsync_params(base::Value::Type::LIST);
+    mnsync_params.Append("status");
+    mnsync_signature->set_params(std::move(mnsync_params));
+    batch_signature->add_batch_call(std::move(mnsync_signature));
+
+    auto balance_signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_JSON);
+    balance_signature->set_method_name("getbalance");
+    balance_signature->set_params(base::ListValue());
+    batch_signature->add_batch_call(std::move(balance_signature));
+
+    // listsinceblock records are decoded while the body is downloading
+    batch_signature->set_stream_parser(std::make_unique<TransactionStreamParser>());
+
     base::PostTask(
         FROM_HERE,
         {
             content::BrowserThread::UI,
             base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
         },
-        base::BindOnce(&TransactionService::ui_rpc_request, base::Unretained(this), std::move(transactions_signature))
+        base::BindOnce(&TransactionService::ui_rpc_request, base::Unretained(this), std::move(batch_signature))
     );
 }
 
@@ -180,8 +524,6 @@ void TransactionService::ui_rpc_request(std::unique_ptr<WalletHttpCallSignature>
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
-    signature->set_method_name("listsinceblock");
-
     std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
     WalletRequest* http_request_ptr = http_request.get();
 
@@ -190,10 +532,15 @@ void TransactionService::ui_rpc_request(std::unique_ptr<WalletHttpCallSignature>
         signature->set_qa(true);
     }
 
-    http_request->start(std::move(signature),
-        base::BindOnce(&TransactionService::ui_rpc_response, base::Unretained(this)));
+    signature->set_priority(WalletCallPriority::BACKGROUND_SYNC);
+
+    http_request->set_decode_in_background(true);
 
+    // the request may be answered and deleted inside start
     ui_requests_[http_request_ptr] = std::move(http_request);
+
+    http_request_ptr->start(std::move(signature),
+        base::BindOnce(&TransactionService::ui_rpc_response, base::Unretained(this)));
 }
 
 void TransactionService::ui_rpc_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results, WalletRequest* http_request_ptr)
@@ -211,9 +558,22 @@ void TransactionService::ui_rpc_response(std::unique_ptr<WalletHttpCallSignature
         ui_requests_.erase(it);
     }
 
+    // listsinceblock, mnsync status, getbalance
+    std::vector<std::unique_ptr<WalletHttpCallSignature>> calls = signature->take_batch_calls();
+    DCHECK_EQ(3u, calls.size());
+
+    std::unique_ptr<WalletHttpCallSignature> transactions_signature = std::move(calls[0]);
+    transactions_signature->set_stream_parser(signature->take_stream_parser());
+
+    base::Value transactions_result = WalletHttpCallSignature::take_batch_result(results, 0);
+
+    // checks of the cycle wait until the transactions are stored
+    transactions_signature->get_extra_data().SetKey("mnsync", WalletHttpCallSignature::take_batch_result(results, 1));
+    transactions_signature->get_extra_data().SetKey("balance", WalletHttpCallSignature::take_batch_result(results, 2));
+
     task_runner_->PostTask(FROM_HERE,
                          base::BindOnce(&TransactionService::db_rpc_response, base::Unretained(this),
-                         std::move(signature), std::move(results)));
+                         std::move(transactions_signature), std::move(transactions_result)));
 }
 
 void TransactionService::db_rpc_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results)
@@ -233,202 +593,263 @@ void TransactionService::db_rpc_response(std::unique_ptr<WalletHttpCallSignature
             db_get_transactions(std::move(external_signature));
         }
 
+        // the wallet changed in the middle of the cycle, the new one is synced now
+        db_start(nullptr);
         return;
     }
 
-    std::map<std::string, TransactionData> rpc_data = parse_transactions_json(results);
+    bool failed = !results.is_dict() || results.FindKey("error");
+    if (failed)
+    {
+        db_best_block_hash_.clear();
+    }
+
+    std::map<std::string, TransactionData> rpc_data;
+
+    std::unique_ptr<IWalletStreamParser> stream_parser = signature->take_stream_parser();
+    if (stream_parser)
+    {
+        // set in db_start, partial bodies give no records
+        rpc_data = static_cast<TransactionStreamParser*>(stream_parser.get())->take_transactions();
+    }
+    else
+    {
+        rpc_data = parse_transactions_json(results);
+    }
+
+    size_t changed_count = 0;
+    size_t conflicted_count = 0;
 
     if (!rpc_data.empty() && db_helper_->is_open())
     {
-		// transactions with confirmations < 101 & !conflicted
-		std::map<std::string, TransactionData> db_data = db_helper_->get_unconfirmed(db_wallet_first_address_);
+        // transactions with confirmations < 101 & !conflicted
+        TransactionDiff diff;
+        diff.set_stored(db_helper_->get_unconfirmed(db_wallet_first_address_));
 
-		std::string latest_block;
+        TransactionChanges changes = diff.compare(std::move(rpc_data));
+        changed_count = changes.inserts.size() + changes.updates.size();
+        conflicted_count = changes.conflicts.size();
 
         sql::Transaction committer(db_helper_->get_db());
         committer.Begin();
 
-        // rpc_data new ... old, so iterate in reverse order
-		for(auto rpc_it = rpc_data.rbegin(); rpc_it != rpc_data.rend(); rpc_it++)
-		{
-			if (rpc_it->second.confirmations >= ENOUGH_CONFIRMATION_COUNT && !rpc_it->second.conflicted)
-			{
-				latest_block = rpc_it->second.blockhash;
-			}
-
-			auto db_it = db_data.find(rpc_it->second.key());
-			if (db_it == db_data.end())
-			{
-
-                // do not insert empty from transaction
-                if (rpc_it->second.address_from.empty()
-                  && -1 == rpc_it->second.confirmations)
-                {
-                    for(auto db_it_with_empty_from = db_data.begin(); db_it_with_empty_from != db_data.end(); db_it_with_empty_from++)
-                    {
-                        if (db_it_with_empty_from->second.is_same_without_address_from(rpc_it->second))
-                        {
-                            db_data.erase(db_it_with_empty_from);
-                            break;
-                        }
-                    }
-
-                    continue;
-                }
-
-                db_helper_->insert_or_update(rpc_it->second);
-                continue;
-			}
-
-			if (db_it->second.confirmations != rpc_it->second.confirmations ||
-				db_it->second.conflicted != rpc_it->second.conflicted ||
-                db_it->second.blocknumber != rpc_it->second.blocknumber ||
-                db_it->second.blockhash != rpc_it->second.blockhash ||
-                db_it->second.at != rpc_it->second.at
-			)
-			{
-					db_helper_->update(rpc_it->second);
-			}
-			db_data.erase(db_it);
-		}
+        // new and changed rows are written with multi-row upserts
+        TransactionBulkStats bulk_stats;
+        if (!db_helper_->bulk_insert_or_update(changes.inserts, &bulk_stats)
+         || !db_helper_->bulk_insert_or_update(changes.updates, &bulk_stats))
+        {
+            VLOG(NETBOX_LOG_LEVEL) << "failed to store rpc transactions";
+        }
 
-		// mark record as conflicted
-		for(auto db_conflicted_it = db_data.begin(); db_conflicted_it != db_data.end(); db_conflicted_it++)
-		{
-			db_helper_->set_conflicted(db_conflicted_it->second);
-		}
+        VLOG(NETBOX_LOG_LEVEL) << "transactions inserted " << bulk_stats.inserted
+                               << ", updated " << bulk_stats.updated
+                               << ", unchanged " << bulk_stats.unchanged
+                               << ", conflicted " << changes.conflicts.size();
+
+        // mark record as conflicted
+        for (const TransactionData& conflicted : changes.conflicts)
+        {
+            db_helper_->set_conflicted(conflicted);
+        }
 
 		// move latest block
-		if (!latest_block.empty())
+		if (!changes.latest_block.empty())
 		{
-			db_helper_->set_latest_block(latest_block);
+			db_helper_->set_latest_block(changes.latest_block);
 		}
 
         committer.Commit();
 	}
 
-    db_loaded_ = true;
-    db_in_rpc_call_ = false;
+    base::TimeDelta cycle_time = base::TimeTicks::Now() - db_rpc_call_started_at_;
+    base::UmaHistogramMediumTimes("Netbox.TransactionService.SyncCycleTime", cycle_time);
+    base::UmaHistogramCounts100000("Netbox.TransactionService.SyncRowsChanged", changed_count);
 
+    db_last_sync_.at            = base::Time::Now();
+    db_last_sync_.duration      = cycle_time;
+    db_last_sync_.changed       = changed_count;
+    db_last_sync_.conflicted    = conflicted_count;
+    db_last_sync_.failed        = failed;
 
+    loaded_ = true;
+    db_in_rpc_call_ = false;
+
+    // a cycle started by the ui continues with the checks as any other
     if (external_signature.get())
     {
         db_get_transactions(std::move(external_signature));
-        return;
     }
 
-    db_check_synced();
+    db_check_synced(std::move(signature));
 }
 
-void TransactionService::db_check_synced()
+bool is_blockchain_synced(const base::Value& result)
 {
-    auto signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_JSON);
-    signature->set_method_name("mnsync");
-    signature->set_rpc_token(db_token_base64_);
+    if (!result.is_dict())
+    {
+        return false;
+    }
 
-    base::Value params(base::Value::Type::LIST);
-    params.Append("status");
-    signature->set_params(std::move(params));
+    // post_process unwraps dict results, the flag is on the top level
+    absl::optional<bool> is_synced = result.FindBoolKey("IsBlockchainSynced");
+    if (is_synced == absl::nullopt)
+    {
+        is_synced = result.FindBoolPath("result.IsBlockchainSynced");
+    }
 
-    base::PostTask(
-        FROM_HERE,
-        {
-            content::BrowserThread::UI,
-            base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
-        },
-        base::BindOnce(&TransactionService::ui_mnsync_request, base::Unretained(this), std::move(signature)));
+    return is_synced != absl::nullopt && true == *is_synced;
 }
 
-void TransactionService::ui_mnsync_request(std::unique_ptr<WalletHttpCallSignature> signature)
+void TransactionService::db_check_synced(std::unique_ptr<WalletHttpCallSignature> signature)
 {
-    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-    if (g_browser_process->env_controller()->is_qa())
+    // mnsync status and getbalance came in the batch together with listsinceblock
+    absl::optional<base::Value> mnsync_result = signature->get_extra_data().ExtractKey("mnsync");
+    absl::optional<base::Value> balance_result = signature->get_extra_data().ExtractKey("balance");
+
+    if (!mnsync_result || !balance_result || !is_blockchain_synced(*mnsync_result))
     {
-        signature->set_qa(true);
+        db_schedule_transaction_request();
+        return;
     }
 
-    std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
-    WalletRequest* http_request_ptr = http_request.get();
-
-    http_request->start(std::move(signature),
-        base::BindOnce(&TransactionService::ui_mnsync_response, base::Unretained(this)));
-
-    ui_requests_[http_request_ptr] = std::move(http_request);
+    db_check_control_sum(std::move(*balance_result));
 }
 
-void TransactionService::ui_mnsync_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest* http_request_ptr)
+void TransactionService::db_check_control_sum(base::Value results)
 {
-    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
-    auto it = ui_requests_.find(http_request_ptr);
-    if (it == ui_requests_.end())
+    int64_t db_balance = db_helper_->get_balance();
+
+    if (!results.is_dict())
     {
-        VLOG(NETBOX_LOG_LEVEL) << "failed to find http_request, " << http_request_ptr;
+		db_schedule_transaction_request();
+		return;
+	}
+
+	absl::optional<double> rpc_balance_raw = results.FindDoubleKey("result");
+	if (rpc_balance_raw == absl::nullopt)
+	{
+		db_schedule_transaction_request();
+		return;
+	}
+
+	int64_t rpc_balance = rint(*rpc_balance_raw * 100000000);
+
+    // maintained balance may be out of sync with transactions, repair it before counting a failure
+    if (db_balance != rpc_balance && !db_helper_->check_balances(true))
+    {
+        db_balance = db_helper_->get_balance();
+    }
+
+    if (db_balance == rpc_balance)
+    {
+        db_control_sum_check_failed_count_ = 0;
     }
     else
     {
-        std::unique_ptr<WalletRequest> http_request = std::move(it->second);
-        ui_requests_.erase(it);
+        db_control_sum_check_failed_count_++;
+        VLOG(NETBOX_LOG_LEVEL) << "balances mistmatch";
     }
 
-    if (result.is_dict())
+    if (db_control_sum_check_failed_count_ > 15 && !db_in_rpc_call_)
     {
-        absl::optional<bool> is_synced = result.FindBoolPath("result.IsBlockchainSynced");
-        if (is_synced != absl::nullopt && true == *is_synced)
-        {
-            task_runner_->PostTask(FROM_HERE,
-                         base::BindOnce(&TransactionService::db_check_control_sum, base::Unretained(this)));
-            return;
+        VLOG(1) << "balances mistmatch, reconciling database";
+        db_reconcile_start();
+        return;
+    }
 
-        }
+    db_schedule_transaction_request();
+}
+
+void TransactionService::db_reconcile_start()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    // the regular sync waits, the stored history is still served to the ui
+    db_in_rpc_call_ = true;
+    db_rpc_call_started_at_ = base::TimeTicks::Now();
+
+    db_reconcile_checkpoints_ = db_helper_->get_checkpoints();
+    db_reconcile_lo_ = 0;
+    db_reconcile_hi_ = db_reconcile_checkpoints_.size();
+
+    db_reconcile_next();
+}
+
+void TransactionService::db_reconcile_next()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    // bisect for the first checkpoint whose following blocks match the wallet
+    if (db_reconcile_lo_ < db_reconcile_hi_)
+    {
+        db_reconcile_request(static_cast<int>(db_reconcile_lo_ + (db_reconcile_hi_ - db_reconcile_lo_) / 2), false);
+        return;
     }
 
-    schedule_transaction_request();
+    // blocks after the previous checkpoint diverge, -1 means the whole history
+    db_reconcile_request(static_cast<int>(db_reconcile_lo_) - 1, true);
 }
 
-void TransactionService::db_check_control_sum()
+void TransactionService::db_reconcile_request(int checkpoint_index, bool repair)
 {
     DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
 
+    // every step of the reconcile is a call of its own
+    db_rpc_call_started_at_ = base::TimeTicks::Now();
+
     auto signature = std::make_unique<WalletHttpCallSignature>(WalletHttpCallType::RPC_JSON);
+    signature->set_method_name("listsinceblock");
     signature->set_rpc_token(db_token_base64_);
+    signature->set_stream_parser(std::make_unique<TransactionStreamParser>());
+
+    base::ListValue params;
+    params.Append(checkpoint_index >= 0 ? db_reconcile_checkpoints_[checkpoint_index].blockhash : "");
+    signature->set_params(std::move(params));
 
     base::Value extra_data(base::Value::Type::DICTIONARY);
     extra_data.SetStringKey("wallet_first_address", db_wallet_first_address_);
+    extra_data.SetIntKey("checkpoint_index", checkpoint_index);
+    extra_data.SetBoolKey("repair", repair);
     signature->set_extra_data(std::move(extra_data));
 
-    signature->set_params(base::ListValue());
-
     base::PostTask(
         FROM_HERE,
         {
             content::BrowserThread::UI,
             base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
         },
-        base::BindOnce(&TransactionService::ui_rpc_balance_request, base::Unretained(this), std::move(signature)));
+        base::BindOnce(&TransactionService::ui_reconcile_request, base::Unretained(this), std::move(signature))
+    );
 }
 
-void TransactionService::ui_rpc_balance_request(std::unique_ptr<WalletHttpCallSignature> signature)
+void TransactionService::ui_reconcile_request(std::unique_ptr<WalletHttpCallSignature> signature)
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
-    signature->set_method_name("getbalance");
     if (g_browser_process->env_controller()->is_qa())
     {
         signature->set_qa(true);
     }
 
+    signature->set_priority(WalletCallPriority::BACKGROUND_SYNC);
+
     std::unique_ptr<WalletRequest> http_request = std::make_unique<WalletRequest>();
     WalletRequest* http_request_ptr = http_request.get();
 
-    http_request->start(std::move(signature),
-        base::BindOnce(&TransactionService::ui_rpc_balance_response, base::Unretained(this)));
+    http_request->set_decode_in_background(true);
 
+    // the request may be answered and deleted inside start
     ui_requests_[http_request_ptr] = std::move(http_request);
+
+    http_request_ptr->start(std::move(signature),
+        base::BindOnce(&TransactionService::ui_reconcile_response, base::Unretained(this)));
 }
 
-void TransactionService::ui_rpc_balance_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest* http_request_ptr)
+void TransactionService::ui_reconcile_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest* http_request_ptr)
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
 
@@ -444,62 +865,122 @@ void TransactionService::ui_rpc_balance_response(std::unique_ptr<WalletHttpCallS
     }
 
     task_runner_->PostTask(FROM_HERE,
-                         base::BindOnce(&TransactionService::db_rpc_balance_response, base::Unretained(this),
+                         base::BindOnce(&TransactionService::db_reconcile_response, base::Unretained(this),
                          std::move(signature), std::move(result)));
 }
 
-void TransactionService::db_rpc_balance_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results)
+void TransactionService::db_reconcile_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value results)
 {
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
     std::string* first_address = signature->get_extra_data().FindStringKey("wallet_first_address");
+    absl::optional<int> checkpoint_index = signature->get_extra_data().FindIntKey("checkpoint_index");
+    absl::optional<bool> repair = signature->get_extra_data().FindBoolKey("repair");
 
     if (!first_address || *first_address != db_wallet_first_address_)
     {
+        db_in_rpc_call_ = false;
+        db_reconcile_checkpoints_.clear();
+        db_start(nullptr);
         return;
     }
 
-    int64_t db_balance = db_helper_->get_balance();
+    std::unique_ptr<IWalletStreamParser> stream_parser = signature->take_stream_parser();
+    TransactionStreamParser* transaction_parser = static_cast<TransactionStreamParser*>(stream_parser.get());
 
-    if (!results.is_dict())
+    if (!results.is_dict() || results.FindKey("error") || !transaction_parser->is_finished() || !db_helper_->is_open())
     {
-		schedule_transaction_request();
-		return;
-	}
+        VLOG(NETBOX_LOG_LEVEL) << "reconciliation interrupted";
 
-	absl::optional<double> rpc_balance_raw = results.FindDoubleKey("result");
-	if (rpc_balance_raw == absl::nullopt)
-	{
-		schedule_transaction_request();
-		return;
-	}
+        db_in_rpc_call_ = false;
+        db_reconcile_checkpoints_.clear();
+        db_schedule_transaction_request();
+        return;
+    }
 
-	int64_t rpc_balance = rint(*rpc_balance_raw * 100000000);
+    std::map<std::string, TransactionData> rpc_data = transaction_parser->take_transactions();
 
-    if (db_balance == rpc_balance)
+    // blocks known to the database after the checkpoint, blocks reported by the wallet and mempool
+    std::set<std::string> range_blocks = {""};
+    for (size_t i = *checkpoint_index + 1; i < db_reconcile_checkpoints_.size(); ++i)
     {
-        db_control_sum_check_failed_count_ = 0;
+        range_blocks.insert(db_reconcile_checkpoints_[i].blockhash);
+    }
+    for (auto rpc_it = rpc_data.begin(); rpc_it != rpc_data.end(); ++rpc_it)
+    {
+        range_blocks.insert(rpc_it->second.blockhash);
+    }
+
+    if (*repair)
+    {
+        if (db_helper_->replace_range(range_blocks, rpc_data))
+        {
+            db_control_sum_check_failed_count_ = 0;
+        }
+
+        VLOG(1) << "reconciled " << range_blocks.size() << " blocks from checkpoint " << *checkpoint_index;
+
+        db_in_rpc_call_ = false;
+        db_reconcile_checkpoints_.clear();
+        db_schedule_transaction_request();
+        return;
+    }
+
+    if (db_helper_->is_range_consistent(range_blocks, rpc_data))
+    {
+        db_reconcile_hi_ = *checkpoint_index;
     }
     else
     {
-        db_control_sum_check_failed_count_++;
-        VLOG(NETBOX_LOG_LEVEL) << "balances mistmatch";
+        db_reconcile_lo_ = *checkpoint_index + 1;
+    }
+
+    db_reconcile_next();
+}
+
+// reader sequence, nothing of the service is used here, the helper is deleted on this sequence after the posted reads
+static bool read_open(TransactionDBHelper* reader, const std::string& wallet_first_address)
+{
+    if (reader->is_open() && reader->get_read_wallet_first_address() == wallet_first_address)
+    {
+        return true;
+    }
+
+    return reader->open_for_read(wallet_first_address);
+}
+
+static absl::optional<base::Value> read_get_transactions(TransactionDBHelper* reader, std::string wallet_first_address, base::Value params)
+{
+    if (!read_open(reader, wallet_first_address))
+    {
+        return absl::nullopt;
     }
 
-    if (db_control_sum_check_failed_count_ > 15)
+    return reader->get_transactions(params);
+}
+
+static absl::optional<base::Value> read_get_transactions_summary(TransactionDBHelper* reader, std::string wallet_first_address, base::Value params)
+{
+    if (!read_open(reader, wallet_first_address))
     {
-        db_loaded_ = false;
-        VLOG(1) << "balances mistmatch, recreating database";
-        db_helper_->check_database(db_wallet_first_address_, true);
+        return absl::nullopt;
     }
 
-    schedule_transaction_request();
+    return reader->get_transactions_summary(params);
 }
 
 void TransactionService::ui_get_transactions(std::unique_ptr<WalletHttpCallSignature> request)
 {
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
     if (absl::nullopt == request->get_params().FindBoolKey("invalidate"))
     {
-        task_runner_->PostTask(FROM_HERE,
-            base::BindOnce(&TransactionService::db_get_transactions, base::Unretained(this), std::move(request)));
+        Reader& reader = ui_readers_[ui_next_reader_++ % ui_readers_.size()];
+        base::Value params = request->get_params().Clone();
+
+        reader.task_runner->PostTaskAndReplyWithResult(FROM_HERE,
+            base::BindOnce(&read_get_transactions, base::Unretained(reader.db_helper.get()), ui_wallet_first_address_, std::move(params)),
+            base::BindOnce(&TransactionService::ui_read_response, ui_weak_factory_.GetWeakPtr(), false, std::move(request)));
         return;
     }
 
@@ -507,32 +988,107 @@ void TransactionService::ui_get_transactions(std::unique_ptr<WalletHttpCallSigna
             base::BindOnce(&TransactionService::db_start, base::Unretained(this), std::move(request)));
 }
 
-void TransactionService::db_get_transactions(std::unique_ptr<WalletHttpCallSignature> request)
+void end_transactions_call(std::unique_ptr<WalletHttpCallSignature> request, base::Value result)
 {
-    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
-
-    base::Value transactions = db_helper_->get_transactions(request->get_params());
-
     std::string event_name          = request->get_event_name();
     IWalletTabHandler* handler      = request->get_ui_handler();
 
-    if (false == db_loaded_)
-    {
-        transactions.SetBoolKey("is_loading", true);
-    }
-    else
-    {
-        transactions.SetBoolKey("is_loading", false);
-    }
-
     base::PostTask(
         FROM_HERE,
         {
             content::BrowserThread::UI,
             base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN
         },
-        base::BindOnce(&WalletManager::end_http_call, base::Unretained(g_browser_process->wallet_manager()), handler, std::move(transactions), std::move(event_name))
+        base::BindOnce(&WalletManager::end_http_call, base::Unretained(g_browser_process->wallet_manager()), handler, std::move(result), std::move(event_name))
     );
 }
 
-}
\ No newline at end of file
+void TransactionService::ui_read_response(bool summary, std::unique_ptr<WalletHttpCallSignature> request, absl::optional<base::Value> result)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    if (result)
+    {
+        result->SetBoolKey("is_loading", !loaded_);
+        end_transactions_call(std::move(request), std::move(*result));
+        return;
+    }
+
+    // stopped
+    if (!task_runner_)
+    {
+        return;
+    }
+
+    // database is not created yet, the db sequence answers
+    task_runner_->PostTask(FROM_HERE,
+        base::BindOnce(summary ? &TransactionService::db_get_transactions_summary : &TransactionService::db_get_transactions,
+        base::Unretained(this), std::move(request)));
+}
+
+void TransactionService::db_get_transactions(std::unique_ptr<WalletHttpCallSignature> request)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    base::Value transactions = db_helper_->get_transactions(request->get_params());
+    transactions.SetBoolKey("is_loading", !loaded_);
+
+    end_transactions_call(std::move(request), std::move(transactions));
+}
+
+void TransactionService::ui_get_transactions_summary(std::unique_ptr<WalletHttpCallSignature> request)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    Reader& reader = ui_readers_[ui_next_reader_++ % ui_readers_.size()];
+    base::Value params = request->get_params().Clone();
+
+    reader.task_runner->PostTaskAndReplyWithResult(FROM_HERE,
+        base::BindOnce(&read_get_transactions_summary, base::Unretained(reader.db_helper.get()), ui_wallet_first_address_, std::move(params)),
+        base::BindOnce(&TransactionService::ui_read_response, ui_weak_factory_.GetWeakPtr(), true, std::move(request)));
+}
+
+void TransactionService::db_get_transactions_summary(std::unique_ptr<WalletHttpCallSignature> request)
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    base::Value summary = db_helper_->get_transactions_summary(request->get_params());
+    summary.SetBoolKey("is_loading", !loaded_);
+
+    end_transactions_call(std::move(request), std::move(summary));
+}
+
+void TransactionService::ui_get_sync_stats(base::OnceCallback<void(base::Value)> callback)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    base::PostTaskAndReplyWithResult(task_runner_.get(), FROM_HERE,
+        base::BindOnce(&TransactionService::db_get_sync_stats, base::Unretained(this)),
+        std::move(callback));
+}
+
+base::Value TransactionService::db_get_sync_stats()
+{
+    DCHECK_CALLED_ON_VALID_SEQUENCE(sequence_checker_);
+
+    base::Value stats(base::Value::Type::DICTIONARY);
+    stats.SetBoolKey("loaded",                  loaded_);
+    stats.SetBoolKey("in_rpc_call",             db_in_rpc_call_);
+    stats.SetIntKey("cycles_performed",         db_sync_cycles_performed_);
+    stats.SetIntKey("cycles_skipped",           db_sync_cycles_skipped_);
+    stats.SetIntKey("idle_cycles",              db_idle_cycles_);
+    stats.SetIntKey("control_sum_failures",     db_control_sum_check_failed_count_);
+
+    if (!db_last_sync_.at.is_null())
+    {
+        stats.SetDoubleKey("last_sync_at",      db_last_sync_.at.ToJsTime());
+        stats.SetDoubleKey("last_sync_ms",      db_last_sync_.duration.InMillisecondsF());
+        stats.SetIntKey("last_sync_changed",    static_cast<int>(db_last_sync_.changed));
+        stats.SetIntKey("last_sync_conflicted", static_cast<int>(db_last_sync_.conflicted));
+        stats.SetBoolKey("last_sync_failed",    db_last_sync_.failed);
+    }
+
+    return stats;
+}
+
+}
@@ -1,7 +1,13 @@
 ﻿#ifndef CHROME_BROWSER_TRANSACTION_SERVICE_H_
 #define CHROME_BROWSER_TRANSACTION_SERVICE_H_
 
+#include <atomic>
+#include <list>
+#include <vector>
+
+#include "base/callback.h"
 #include "base/files/file_path.h"
+#include "base/memory/weak_ptr.h"
 #include "base/sequenced_task_runner.h"
 #include "base/sequence_checker.h"
 #include "base/time/time.h"
@@ -11,6 +17,7 @@
 #include "chrome/browser/netbox/call/wallet_http_call_signature.h"
 #include "chrome/browser/netbox/call/wallet_request.h"
 #include "sql/database.h"
+#include "third_party/abseil-cpp/absl/types/optional.h"
 
 namespace Netboxglobal
 {
@@ -27,26 +34,48 @@ public:
     void ui_set_first_address(std::string token);
     void ui_pre_start(base::FilePath profile_path);
     void ui_get_transactions(std::unique_ptr<WalletHttpCallSignature> request);
+    void ui_get_transactions_summary(std::unique_ptr<WalletHttpCallSignature> request);
+
+    // counters of the sync loop for chrome://netboxinfo, the callback is called on the ui thread
+    void ui_get_sync_stats(base::OnceCallback<void(base::Value)> callback);
+
+    // replay harness, cycles run only on ui_sync_now_for_testing and report to the callback on the db sequence
+    void ui_set_manual_sync_for_testing(std::string token, base::RepeatingClosure sync_cycle_callback);
+    void ui_sync_now_for_testing();
 private:
+    void db_set_manual_sync(std::string token, base::RepeatingClosure sync_cycle_callback);
     void db_set_path(base::FilePath profile_path);
     void db_set_first_address(std::string wallet_first_address);
+    void db_switch_wallet(const std::string& wallet_first_address);
     void db_set_token(std::string token);
-    void schedule_transaction_request();
+    void db_schedule_transaction_request();
+    // a later schedule replaces the pending one, so there is a single sync timer
+    void db_schedule_sync(base::TimeDelta delay);
+    void ui_start_scheduled(int64_t generation);
+    void db_start_scheduled(int64_t generation);
     void ui_start();
     void db_start(std::unique_ptr<WalletHttpCallSignature>);
+    void ui_best_block_request(std::unique_ptr<WalletHttpCallSignature>);
+    void ui_best_block_response(std::unique_ptr<WalletHttpCallSignature>, base::Value, WalletRequest*);
+    void db_best_block_response(std::unique_ptr<WalletHttpCallSignature>, base::Value);
+    void db_rpc_request(std::unique_ptr<WalletHttpCallSignature>);
     void ui_rpc_request(std::unique_ptr<WalletHttpCallSignature>);
     void ui_rpc_response(std::unique_ptr<WalletHttpCallSignature>, base::Value, WalletRequest*);
     void db_rpc_response(std::unique_ptr<WalletHttpCallSignature> request, base::Value);
     void db_get_transactions(std::unique_ptr<WalletHttpCallSignature>);
-    void db_check_synced();
-    void ui_mnsync_request(std::unique_ptr<WalletHttpCallSignature> signature);
-    void db_mnsync_request(std::unique_ptr<WalletHttpCallSignature> signature);
-    void ui_mnsync_response(std::unique_ptr<WalletHttpCallSignature> signature, base::Value result, WalletRequest* http_request_ptr);
-    void db_check_control_sum();
-    void ui_rpc_balance_request(std::unique_ptr<WalletHttpCallSignature> signature);
-    void ui_rpc_balance_response(std::unique_ptr<WalletHttpCallSignature>, base::Value, WalletRequest*);
-    void db_rpc_balance_response(std::unique_ptr<WalletHttpCallSignature>, base::Value);
+    void db_get_transactions_summary(std::unique_ptr<WalletHttpCallSignature>);
+    // a reader answered, nullopt when its database is not there yet
+    void ui_read_response(bool summary, std::unique_ptr<WalletHttpCallSignature> request, absl::optional<base::Value> result);
+    void db_check_synced(std::unique_ptr<WalletHttpCallSignature> signature);
+    void db_check_control_sum(base::Value balance_result);
+    void db_reconcile_start();
+    void db_reconcile_next();
+    void db_reconcile_request(int checkpoint_index, bool repair);
+    void ui_reconcile_request(std::unique_ptr<WalletHttpCallSignature>);
+    void ui_reconcile_response(std::unique_ptr<WalletHttpCallSignature>, base::Value, WalletRequest*);
+    void db_reconcile_response(std::unique_ptr<WalletHttpCallSignature>, base::Value);
     void db_close();
+    base::Value db_get_sync_stats();
 
     scoped_refptr<base::SequencedTaskRunner> task_runner_;
 
@@ -54,16 +83,69 @@ private:
     std::string db_wallet_first_address_;
     std::string db_token_base64_;
     bool db_in_rpc_call_ = false;
-    bool db_loaded_ = false;
+    base::TimeTicks db_rpc_call_started_at_;
+    int64_t db_sync_generation_ = 0;
     int db_control_sum_check_failed_count_ = 0;
 
+    // adaptive sync, the full cycle runs only when the chain tip moves
+    std::string db_best_block_hash_;
+    int db_idle_cycles_ = 0;
+    int db_sync_cycles_performed_ = 0;
+    int db_sync_cycles_skipped_ = 0;
+
+    struct LastSync
+    {
+        base::Time at;
+        base::TimeDelta duration;
+        size_t changed = 0;
+        size_t conflicted = 0;
+        bool failed = false;
+    };
+    LastSync db_last_sync_;
+    base::RepeatingClosure db_sync_cycle_callback_for_testing_;
+
+    // reconciliation bisects [lo, hi) over blocks with wallet transactions
+    std::vector<TransactionCheckpoint> db_reconcile_checkpoints_;
+    size_t db_reconcile_lo_ = 0;
+    size_t db_reconcile_hi_ = 0;
+
     std::map<WalletRequest*, std::unique_ptr<WalletRequest>> ui_requests_;
 
+    // history reads, every connection has its own sequence so pages are not queued behind a sync batch
+    struct Reader
+    {
+        scoped_refptr<base::SequencedTaskRunner> task_runner;
+        std::unique_ptr<TransactionDBHelper> db_helper;
+    };
+    std::vector<Reader> ui_readers_;
+    size_t ui_next_reader_ = 0;
+    std::string ui_wallet_first_address_;
+
+    // written on the db sequence, readers use it for is_loading
+    std::atomic<bool> loaded_{false};
+
     base::TimeDelta pool_request_delta_;
 
-    std::unique_ptr<TransactionDBHelper> db_helper_;
+    // recently used wallets keep their database open together with their sync state,
+    // front is the current one, db_helper_ points to it
+    struct WalletDB
+    {
+        std::string wallet_first_address;
+        std::unique_ptr<TransactionDBHelper> db_helper;
+        std::string best_block_hash;
+        int idle_cycles = 0;
+        int control_sum_check_failed_count = 0;
+        bool loaded = false;
+    };
+    std::list<WalletDB> db_wallets_;
+    base::FilePath db_profile_path_;
+
+    TransactionDBHelper* db_helper_ = nullptr;
 
     SEQUENCE_CHECKER(sequence_checker_);
+
+    // replies of the readers, ui thread only
+    base::WeakPtrFactory<TransactionService> ui_weak_factory_{this};
 };
 
 }
@@ -0,0 +1,483 @@
+#include <map>
+#include <string>
+#include <vector>
+
+#include "base/bind.h"
+#include "base/files/file_enumerator.h"
+#include "base/files/file_util.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/json/json_reader.h"
+#include "base/logging.h"
+#include "base/process/process_metrics.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/task/current_thread.h"
+#include "base/task/task_observer.h"
+#include "base/threading/thread_restrictions.h"
+#include "base/timer/elapsed_timer.h"
+#include "build/build_config.h"
+#include "chrome/browser/browser_process.h"
+#include "chrome/browser/netbox/environment/controller/wallet_environment.h"
+#include "chrome/browser/transaction_service/transaction_db_helper.h"
+#include "chrome/browser/transaction_service/transaction_model.h"
+#include "chrome/browser/transaction_service/transaction_service.h"
+#include "chrome/test/base/in_process_browser_test.h"
+#include "content/public/browser/browser_task_traits.h"
+#include "content/public/browser/browser_thread.h"
+#include "content/public/test/browser_test.h"
+#include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/test/embedded_test_server/http_request.h"
+#include "net/test/embedded_test_server/http_response.h"
+#include "sql/statement.h"
+#include "url/gurl.h"
+
+namespace Netboxglobal
+{
+
+// 10 transactions per block, rows are ordered by height
+static const int32_t FIXTURE_ROWS_PER_BLOCK = 10;
+
+static const char FIXTURE_WALLET_FIRST_ADDRESS[] = "NbxFixtureFirstAddress";
+
+struct FixtureRow
+{
+    std::string txid;
+    std::string address;
+    std::string category;
+    int64_t amount = 0;
+    int height = 0;
+    bool conflicted = false;
+};
+
+std::string fixture_block_hash(int height, int fork)
+{
+    return base::StringPrintf("%056x%08x", height, fork);
+}
+
+// stand-in for the wallet rpc, serves listsinceblock, mnsync, getbestblockhash and getbalance from rows in memory,
+// single calls and json-rpc batches
+class MockWalletRpc
+{
+public:
+    MockWalletRpc() = default;
+    ~MockWalletRpc() = default;
+
+    void add_rows(int rows_count)
+    {
+        base::AutoLock lock(lock_);
+
+        for (int i = 0; i < rows_count; ++i)
+        {
+            FixtureRow row;
+            row.txid        = base::StringPrintf("%056x%08x", static_cast<int>(rows_.size()), fork_);
+            row.address     = base::StringPrintf("NbxAddress%d", static_cast<int>(rows_.size() % 8));
+            row.category    = (rows_.size() % 3) ? "receive" : "stake";
+            row.amount      = 1000 + rows_.size() % 100000;
+            row.height      = static_cast<int>(rows_.size()) / FIXTURE_ROWS_PER_BLOCK;
+
+            tip_height_ = row.height;
+            rows_.push_back(std::move(row));
+        }
+    }
+
+    // the last blocks are replaced by a fork with other transactions
+    void reorg(int blocks_count)
+    {
+        int fork_height = 0;
+        size_t kept_rows = 0;
+        {
+            base::AutoLock lock(lock_);
+
+            fork_++;
+            fork_height = std::max(0, tip_height_ - blocks_count + 1);
+            while (kept_rows < rows_.size() && rows_[kept_rows].height < fork_height)
+            {
+                kept_rows++;
+            }
+
+            size_t dropped_rows = rows_.size() - kept_rows;
+            rows_.resize(kept_rows);
+            forked_height_ = fork_height;
+
+            VLOG(1) << "reorg at " << fork_height << ", dropped " << dropped_rows;
+        }
+
+        add_rows(blocks_count * FIXTURE_ROWS_PER_BLOCK);
+    }
+
+    // every n-th of the recent rows gets a wallet conflict
+    void conflict_recent(int rows_count, int step)
+    {
+        base::AutoLock lock(lock_);
+
+        for (int i = 0; i < rows_count && i < static_cast<int>(rows_.size()); i += step)
+        {
+            rows_[rows_.size() - 1 - i].conflicted = true;
+        }
+    }
+
+    int64_t balance()
+    {
+        base::AutoLock lock(lock_);
+
+        int64_t balance = 0;
+        for (const FixtureRow& row : rows_)
+        {
+            if (!row.conflicted)
+            {
+                balance = balance + row.amount;
+            }
+        }
+
+        return balance;
+    }
+
+    std::map<std::string, int> calls()
+    {
+        base::AutoLock lock(lock_);
+        return calls_;
+    }
+
+    std::unique_ptr<net::test_server::HttpResponse> handle_request(const net::test_server::HttpRequest& request)
+    {
+        absl::optional<base::Value> json = base::JSONReader::Read(request.content);
+        if (!json || (!json->is_dict() && !json->is_list()))
+        {
+            return nullptr;
+        }
+
+        std::string content;
+
+        if (json->is_list())
+        {
+            {
+                base::AutoLock lock(lock_);
+                calls_["batch"]++;
+            }
+
+            content = "[";
+            for (const base::Value& call : json->GetList())
+            {
+                if (content.size() > 1)
+                {
+                    content.push_back(',');
+                }
+
+                content.append(call_result(call));
+            }
+            content.push_back(']');
+        }
+        else
+        {
+            content = call_result(*json);
+        }
+
+        auto response = std::make_unique<net::test_server::BasicHttpResponse>();
+        response->set_content_type("application/json");
+        response->set_content(content);
+
+        return response;
+    }
+
+private:
+    std::string call_result(const base::Value& call)
+    {
+        const std::string* method_raw = call.is_dict() ? call.FindStringKey("method") : nullptr;
+        std::string method = method_raw ? *method_raw : "";
+
+        absl::optional<int> id = call.is_dict() ? call.FindIntKey("id") : absl::nullopt;
+        std::string id_raw = id ? std::to_string(*id) : "null";
+
+        std::string result = "null";
+        {
+            base::AutoLock lock(lock_);
+            calls_[method]++;
+
+            if ("listsinceblock" == method)
+            {
+                const base::Value* params = call.FindListKey("params");
+                std::string since_block = (params && !params->GetList().empty() && params->GetList()[0].is_string())
+                    ? params->GetList()[0].GetString() : "";
+
+                result = list_since_block(since_block);
+            }
+            else if ("getbestblockhash" == method)
+            {
+                result = "\"" + block_hash(tip_height_) + "\"";
+            }
+            else if ("mnsync" == method)
+            {
+                result = "{\"IsBlockchainSynced\":true}";
+            }
+        }
+
+        if ("getbalance" == method)
+        {
+            result = base::StringPrintf("%.8f", balance() / 100000000.0);
+        }
+
+        return "{\"result\":" + result + ",\"error\":null,\"id\":" + id_raw + "}";
+    }
+
+    std::string block_hash(int height)
+    {
+        return fixture_block_hash(height, height >= forked_height_ ? fork_ : 0);
+    }
+
+    // rows above the given block, the whole history for an unknown one
+    std::string list_since_block(const std::string& since_block)
+    {
+        int since_height = -1;
+        for (int height = tip_height_; height >= 0 && !since_block.empty(); --height)
+        {
+            if (block_hash(height) == since_block)
+            {
+                since_height = height;
+                break;
+            }
+        }
+
+        std::string json_raw = "{\"transactions\":[";
+        bool first = true;
+
+        for (const FixtureRow& row : rows_)
+        {
+            if (row.height <= since_height)
+            {
+                continue;
+            }
+
+            if (!first)
+            {
+                json_raw.push_back(',');
+            }
+
+            json_raw.append(base::StringPrintf(
+                "{\"txid\":\"%s\",\"address\":\"%s\",\"category\":\"%s\",\"amount\":%.8f,"
+                "\"confirmations\":%d,\"blockhash\":\"%s\",\"time\":%d,\"walletconflicts\":[%s]}",
+                row.txid.c_str(), row.address.c_str(), row.category.c_str(), row.amount / 100000000.0,
+                tip_height_ - row.height + 1, block_hash(row.height).c_str(), 1600000000 + row.height,
+                row.conflicted ? "\"0\"" : ""));
+            first = false;
+        }
+
+        return json_raw + "],\"lastblock\":\"" + block_hash(tip_height_) + "\"}";
+    }
+
+    base::Lock lock_;
+    std::vector<FixtureRow> rows_;
+    int tip_height_ = 0;
+    int fork_ = 0;
+    int forked_height_ = 0;
+    std::map<std::string, int> calls_;
+
+    DISALLOW_COPY_AND_ASSIGN(MockWalletRpc);
+};
+
+// time spent in ui thread tasks while a cycle runs
+class UIBusyTimeObserver : public base::TaskObserver
+{
+public:
+    UIBusyTimeObserver() = default;
+    ~UIBusyTimeObserver() override = default;
+
+    void WillProcessTask(const base::PendingTask& pending_task, bool was_blocked_or_low_priority) override
+    {
+        task_timer_ = std::make_unique<base::ElapsedTimer>();
+    }
+
+    void DidProcessTask(const base::PendingTask& pending_task) override
+    {
+        if (task_timer_)
+        {
+            busy_time_ = busy_time_ + task_timer_->Elapsed();
+            task_timer_.reset();
+        }
+    }
+
+    base::TimeDelta take_busy_time()
+    {
+        base::TimeDelta busy_time = busy_time_;
+        busy_time_ = base::TimeDelta();
+
+        return busy_time;
+    }
+
+private:
+    std::unique_ptr<base::ElapsedTimer> task_timer_;
+    base::TimeDelta busy_time_;
+
+    DISALLOW_COPY_AND_ASSIGN(UIBusyTimeObserver);
+};
+
+class TransactionServicePerfBrowserTest : public InProcessBrowserTest
+{
+public:
+    TransactionServicePerfBrowserTest() = default;
+    ~TransactionServicePerfBrowserTest() override = default;
+
+    void SetUpOnMainThread() override
+    {
+        InProcessBrowserTest::SetUpOnMainThread();
+
+        {
+            base::ScopedAllowBlockingForTesting allow_blocking;
+            ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+        }
+
+        // the service always calls the wallet port
+        rpc_server_.RegisterRequestHandler(base::BindRepeating(&MockWalletRpc::handle_request, base::Unretained(&rpc_)));
+        ASSERT_TRUE(rpc_server_.Start(GURL(g_browser_process->env_controller()->get_rpc_url()).EffectiveIntPort()));
+
+        base::CurrentThread::Get()->AddTaskObserver(&ui_busy_observer_);
+
+        service_ = std::make_unique<TransactionService>();
+        service_->ui_pre_start(temp_dir_.GetPath());
+        service_->ui_set_first_address(FIXTURE_WALLET_FIRST_ADDRESS);
+
+        // after the address, so opening the database does not start a cycle
+        service_->ui_set_manual_sync_for_testing("dGVzdDp0ZXN0",
+            base::BindRepeating(&TransactionServicePerfBrowserTest::on_sync_cycle, base::Unretained(this)));
+    }
+
+    void TearDownOnMainThread() override
+    {
+        service_.reset();
+        base::CurrentThread::Get()->RemoveTaskObserver(&ui_busy_observer_);
+
+        ASSERT_TRUE(rpc_server_.ShutdownAndWaitUntilComplete());
+
+        InProcessBrowserTest::TearDownOnMainThread();
+    }
+
+    void run_sync_cycle(const std::string& label)
+    {
+        std::map<std::string, int> calls_before = rpc_.calls();
+        ui_busy_observer_.take_busy_time();
+
+        base::ElapsedTimer timer;
+
+        base::RunLoop run_loop;
+        cycle_done_ = run_loop.QuitClosure();
+        service_->ui_sync_now_for_testing();
+        run_loop.Run();
+
+        base::TimeDelta wall_time = timer.Elapsed();
+        base::TimeDelta ui_busy_time = ui_busy_observer_.take_busy_time();
+
+        std::string calls_report;
+        for (const auto& call : rpc_.calls())
+        {
+            calls_report = calls_report + " " + call.first + "=" + std::to_string(call.second - calls_before[call.first]);
+        }
+
+        size_t peak_rss = 0;
+#if defined(OS_WIN)
+        peak_rss = base::ProcessMetrics::CreateCurrentProcessMetrics()->GetPeakWorkingSetSize();
+#endif
+
+        int64_t db_size = 0;
+        int db_rows = 0;
+        int64_t db_balance = 0;
+        {
+            base::ScopedAllowBlockingForTesting allow_blocking;
+
+            base::FileEnumerator files(temp_dir_.GetPath(), true, base::FileEnumerator::FILES);
+            for (base::FilePath path = files.Next(); !path.empty(); path = files.Next())
+            {
+                db_size = db_size + files.GetInfo().GetSize();
+            }
+
+            // second connection to the same file, the service keeps its own open
+            TransactionDBHelper db_helper;
+            db_helper.set_db_path(temp_dir_.GetPath());
+            ASSERT_TRUE(db_helper.check_database(FIXTURE_WALLET_FIRST_ADDRESS, false));
+
+            sql::Statement statement(db_helper.get_db()->GetUniqueStatement("SELECT count(*) FROM transactions"));
+            ASSERT_TRUE(statement.Step());
+            db_rows = statement.ColumnInt(0);
+            db_balance = db_helper.get_balance();
+        }
+
+        ASSERT_EQ(rpc_.balance(), db_balance) << label;
+
+        LOG(INFO) << "sync cycle " << label
+                  << ", wall ms " << wall_time.InMilliseconds()
+                  << ", ui busy ms " << ui_busy_time.InMilliseconds()
+                  << ", rpc calls" << calls_report
+                  << ", rows " << db_rows
+                  << ", db bytes " << db_size
+                  << ", peak rss " << peak_rss;
+    }
+
+    // initial sync, an idle cycle and an incremental one
+    void run_scaled_sync(int rows_count)
+    {
+        rpc_.add_rows(rows_count);
+        run_sync_cycle(base::StringPrintf("initial %d", rows_count));
+        run_sync_cycle(base::StringPrintf("idle %d", rows_count));
+
+        rpc_.add_rows(rows_count / 100 + 1);
+        run_sync_cycle(base::StringPrintf("incremental %d", rows_count));
+    }
+
+protected:
+    MockWalletRpc rpc_;
+
+private:
+    void on_sync_cycle()
+    {
+        // db sequence, hand over to the ui thread running the loop
+        if (cycle_done_)
+        {
+            content::GetUIThreadTaskRunner({})->PostTask(FROM_HERE, std::move(cycle_done_));
+        }
+    }
+
+    base::ScopedTempDir temp_dir_;
+    net::EmbeddedTestServer rpc_server_;
+    UIBusyTimeObserver ui_busy_observer_;
+    std::unique_ptr<TransactionService> service_;
+    base::OnceClosure cycle_done_;
+
+    DISALLOW_COPY_AND_ASSIGN(TransactionServicePerfBrowserTest);
+};
+
+IN_PROC_BROWSER_TEST_F(TransactionServicePerfBrowserTest, Sync1k)
+{
+    run_scaled_sync(1000);
+}
+
+IN_PROC_BROWSER_TEST_F(TransactionServicePerfBrowserTest, MANUAL_Sync100k)
+{
+    run_scaled_sync(100000);
+}
+
+IN_PROC_BROWSER_TEST_F(TransactionServicePerfBrowserTest, MANUAL_Sync1M)
+{
+    run_scaled_sync(1000000);
+}
+
+IN_PROC_BROWSER_TEST_F(TransactionServicePerfBrowserTest, Reorg)
+{
+    rpc_.add_rows(5000);
+    run_sync_cycle("before reorg");
+
+    // unconfirmed rows of the old branch are missing from the response and get marked conflicted
+    rpc_.reorg(3);
+    run_sync_cycle("reorg");
+    run_sync_cycle("after reorg");
+}
+
+IN_PROC_BROWSER_TEST_F(TransactionServicePerfBrowserTest, Conflicted)
+{
+    rpc_.add_rows(5000);
+    run_sync_cycle("before conflicts");
+
+    rpc_.conflict_recent(50, 5);
+    rpc_.add_rows(10);
+    run_sync_cycle("conflicts");
+}
+
+}
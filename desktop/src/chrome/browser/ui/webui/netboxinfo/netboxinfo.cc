@@ -5,8 +5,14 @@
 #include "base/files/file_util.h"
 #include "base/memory/singleton.h"
 #include "base/memory/ref_counted_memory.h"
+#include "base/metrics/histogram_base.h"
+#include "base/metrics/histogram_samples.h"
+#include "base/metrics/statistics_recorder.h"
 #include "base/path_service.h"
+#include "base/stl_util.h"
+#include "base/strings/string_number_conversions.h"
 #include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
 #include "base/strings/utf_string_conversions.h"
 #include "base/system/sys_info.h"
 #include "base/task/post_task.h"
@@ -30,7 +36,9 @@
 #include "chrome/grit/chromium_strings.h"
 #include "chrome/grit/generated_resources.h"
 #include "chrome/grit/theme_resources.h"
+#include "chrome/browser/netbox/call/wallet_dispatcher.h"
 #include "chrome/browser/netbox/environment/controller/wallet_environment.h"
+#include "chrome/browser/transaction_service/transaction_service.h"
 #include "components/netboxglobal_utils/utils.h"
 #include "components/netboxglobal_utils/wallet_utils.h"
 #include "components/prefs/pref_service.h"
@@ -144,6 +152,108 @@ static void GetOperatingSystemType(bool *is_64bit)
     *is_64bit = Netboxglobal::is_system_64bit();
 }
 
+static const char kLatencyHistogramPrefix[] = "Netbox.WalletRequest.Latency.";
+
+// percentiles are bucket upper bounds, close enough to see a slow wallet
+static base::Value GetHistogramSummary(const base::HistogramBase* histogram)
+{
+    std::unique_ptr<base::HistogramSamples> samples = histogram->SnapshotSamples();
+
+    base::Value summary(base::Value::Type::DICTIONARY);
+
+    int64_t total = samples->TotalCount();
+    summary.SetIntKey("count", static_cast<int>(total));
+    if (0 == total)
+    {
+        return summary;
+    }
+
+    summary.SetDoubleKey("mean", static_cast<double>(samples->sum()) / total);
+
+    const double percentiles[] = {0.5, 0.9, 0.99};
+    const char* const names[] = {"p50", "p90", "p99"};
+    size_t next = 0;
+    int64_t seen = 0;
+
+    for (std::unique_ptr<base::SampleCountIterator> it = samples->Iterator(); !it->Done() && next < base::size(percentiles); it->Next())
+    {
+        base::HistogramBase::Sample min;
+        int64_t max;
+        base::HistogramBase::Count count;
+        it->Get(&min, &max, &count);
+
+        seen = seen + count;
+        while (next < base::size(percentiles) && seen >= percentiles[next] * total)
+        {
+            summary.SetDoubleKey(names[next], static_cast<double>(max));
+            next++;
+        }
+    }
+
+    return summary;
+}
+
+// one row per wallet call type and method seen in this session
+static base::Value GetWalletCallsStats()
+{
+    base::Value calls(base::Value::Type::LIST);
+
+    for (const base::HistogramBase* histogram : base::StatisticsRecorder::Sort(base::StatisticsRecorder::WithName(base::StatisticsRecorder::GetHistograms(), kLatencyHistogramPrefix)))
+    {
+        std::string histogram_name = histogram->histogram_name();
+        if (!base::StartsWith(histogram_name, kLatencyHistogramPrefix))
+        {
+            continue;
+        }
+
+        std::string metric_name = histogram_name.substr(base::size(kLatencyHistogramPrefix) - 1);
+
+        base::Value call(base::Value::Type::DICTIONARY);
+        call.SetStringKey("name",   metric_name);
+        call.SetKey("latency",      GetHistogramSummary(histogram));
+
+        const base::HistogramBase* queue_wait = base::StatisticsRecorder::FindHistogram("Netbox.WalletRequest.QueueWait." + metric_name);
+        if (queue_wait)
+        {
+            call.SetKey("queue_wait", GetHistogramSummary(queue_wait));
+        }
+
+        const base::HistogramBase* response_size = base::StatisticsRecorder::FindHistogram("Netbox.WalletRequest.ResponseSize." + metric_name);
+        if (response_size)
+        {
+            call.SetKey("response_size", GetHistogramSummary(response_size));
+        }
+
+        const base::HistogramBase* parse_time = base::StatisticsRecorder::FindHistogram("Netbox.WalletRequest.ParseTime." + metric_name);
+        if (parse_time)
+        {
+            call.SetKey("parse_time", GetHistogramSummary(parse_time));
+        }
+
+        const base::HistogramBase* errors = base::StatisticsRecorder::FindHistogram("Netbox.WalletRequest.Error." + metric_name);
+        if (errors)
+        {
+            // sparse histogram, the samples are error codes
+            base::Value error_codes(base::Value::Type::DICTIONARY);
+            std::unique_ptr<base::HistogramSamples> samples = errors->SnapshotSamples();
+            for (std::unique_ptr<base::SampleCountIterator> it = samples->Iterator(); !it->Done(); it->Next())
+            {
+                base::HistogramBase::Sample min;
+                int64_t max;
+                base::HistogramBase::Count count;
+                it->Get(&min, &max, &count);
+
+                error_codes.SetIntKey(base::NumberToString(min), count);
+            }
+            call.SetKey("errors", std::move(error_codes));
+        }
+
+        calls.Append(std::move(call));
+    }
+
+    return calls;
+}
+
 
 class MessageHandler : public content::WebUIMessageHandler
 {
@@ -157,11 +267,13 @@ public:
 
     void HandleGetInfo(const base::ListValue *);
     void HandleOpenFile(const base::ListValue *);
+    void HandleGetLive(const base::ListValue *);
 
     void OnGotDisksFreeSpace(std::vector<std::pair<std::wstring, int64_t>> *data);
     void OnGotFilePaths(std::u16string* executable_path_data, std::u16string* profile_path_data);
     void OnGotOperatingSystemType(bool *is_64);
     void OnCheckWalletPaths(bool *wallet_exe_exists, bool *wallet_temp_exe_exists, bool *wallet_instaler_exe_exists);
+    void OnGotSyncStats(base::Value stats);
 
     base::WeakPtrFactory<MessageHandler> weak_ptr_factory_{this};
 
@@ -178,6 +290,7 @@ void MessageHandler::RegisterMessages()
 {
     web_ui()->RegisterMessageCallback("netboxinfo",             base::BindRepeating(&MessageHandler::HandleGetInfo, weak_ptr_factory_.GetWeakPtr()));
     web_ui()->RegisterMessageCallback("openfile",               base::BindRepeating(&MessageHandler::HandleOpenFile, weak_ptr_factory_.GetWeakPtr()));
+    web_ui()->RegisterMessageCallback("netboxinfo_live",        base::BindRepeating(&MessageHandler::HandleGetLive, weak_ptr_factory_.GetWeakPtr()));
 }
 
 void MessageHandler::HandleGetInfo(const base::ListValue *)
@@ -267,6 +380,29 @@ void MessageHandler::HandleOpenFile(const base::ListValue *args)
     platform_util::ShowItemInFolder(Profile::FromWebUI(web_ui()), path);
 }
 
+// polled by the page, wallet call histograms, dispatcher queues and the sync loop
+void MessageHandler::HandleGetLive(const base::ListValue *)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+    base::Value data(base::Value::Type::DICTIONARY);
+    data.SetKey("calls",        GetWalletCallsStats());
+    data.SetKey("dispatcher",   Netboxglobal::WalletDispatcher::GetInstance()->get_stats());
+
+	base::Value event_name("netboxinfo.live");
+	web_ui()->CallJavascriptFunctionUnsafe("wallet_send_event", std::move(event_name), std::move(data));
+
+    g_browser_process->transaction_service()->ui_get_sync_stats(base::BindOnce(&MessageHandler::OnGotSyncStats, weak_ptr_factory_.GetWeakPtr()));
+}
+
+void MessageHandler::OnGotSyncStats(base::Value stats)
+{
+    DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
+
+	base::Value event_name("netboxinfo.sync");
+	web_ui()->CallJavascriptFunctionUnsafe("wallet_send_event", std::move(event_name), std::move(stats));
+}
+
 void MessageHandler::OnGotFilePaths(std::u16string* executable_path_data, std::u16string* profile_path_data)
 {
     DCHECK_CURRENTLY_ON(content::BrowserThread::UI);
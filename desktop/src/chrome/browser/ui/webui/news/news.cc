@@ -1,8 +1,8 @@
 #include "chrome/browser/ui/webui/news/news.h"
 
-#include "base/environment.h"
-#include "base/json/json_reader.h"
+#include "chrome/browser/netbox/news/news_cache.h"
 #include "chrome/browser/ui/webui/theme_source.h"
+#include "chrome/browser/ui/webui/wallet/wallet_image_source.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/browser/profiles/profile_manager.h"
 #include "chrome/common/webui_url_constants.h"
@@ -13,12 +13,7 @@
 #include "content/public/browser/web_ui_message_handler.h"
 #include "net/cookies/canonical_cookie.h"
 #include "net/cookies/cookie_store.h"
-#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
-#include "services/network/public/mojom/url_response_head.mojom.h"
-#include "services/network/public/cpp/simple_url_loader.h"
-#include "services/network/public/cpp/shared_url_loader_factory.h"
 #include "services/network/public/mojom/cookie_manager.mojom.h"
-#include <mutex>
 
 #define LANG_COOKIE_URL "https://netbox.global"
 #define LANG_COOKIE_NAME "newslang"
@@ -26,24 +21,6 @@
 namespace
 {
 
-class MessageHandler;
-
-class HTTPFetcher
-{
-public:
-    explicit HTTPFetcher(MessageHandler *handler);
-    int32_t get_http_code() const;
-    bool send(const std::string& host, const std::string& url, const std::string& method_name, const std::string& selector);
-    std::string method_name_;
-    std::string selector_;
-private:
-    std::unique_ptr<network::SimpleURLLoader> sender_;
-    MessageHandler *handler_ = nullptr;
-    int32_t http_code_ = 0;
-    void on_http_response_started(const GURL& final_url, const network::mojom::URLResponseHead& response_head);
-    void on_http_response_body(std::unique_ptr<std::string> response);
-};
-
 class MessageHandler : public content::WebUIMessageHandler
 {
 public:
@@ -52,9 +29,9 @@ public:
 
     void RegisterMessages() override;
 
-    void OnUniversalResult(const std::string *data, HTTPFetcher *fetcher);
  private:
     void HandleGetUniversal(const base::ListValue *args);
+    void OnNewsFeed(const std::string& lang, const base::Value& feed);
     
     std::unique_ptr<net::CanonicalCookie> get_cookie_helper(const std::string& url, const std::string& domain, const std::string& name, const std::string& value);
     void on_set_lang_cookie(net::CanonicalCookie::CookieInclusionStatus);
@@ -65,12 +42,9 @@ public:
     void on_get_lang_cookies_list(const net::CookieStatusList& cookie_list, const net::CookieStatusList&);
     
     std::string filter_lang(const std::string& lang);
-    
-
-    std::list<HTTPFetcher*> fetchers_;
-    std::mutex fetchers_mutex_;
 
-    std::string host_;
+    // feeds of a language picked before are dropped
+    std::string news_lang_;
 
     base::WeakPtrFactory<MessageHandler> weak_ptr_factory_{this};
     DISALLOW_COPY_AND_ASSIGN(MessageHandler);
@@ -78,22 +52,10 @@ public:
 
 MessageHandler::MessageHandler()
 {
-    std::unique_ptr<base::Environment> env(base::Environment::Create());
-
-    if (env->HasVar("NETBOXQA"))
-    {
-        host_ = "devapi.netbox.global";
-    }
-    else
-    {
-        host_ = "devapi.netbox.global";
-    }
 }
 
 MessageHandler::~MessageHandler()
 {
-    for (HTTPFetcher *f : fetchers_)
-        delete f;
 }
 
 void MessageHandler::RegisterMessages()
@@ -121,38 +83,17 @@ void MessageHandler::HandleGetUniversal(const base::ListValue *args)
             return get_cookie();
         }        
         
-        std::lock_guard<std::mutex> grd(fetchers_mutex_);
-
-        HTTPFetcher *fetcher = new HTTPFetcher(this);
-
         if (method_name == "news")
         {
             std::string lang;
 
             if (args->GetString(1, &lang))
-            {                
-                if (true == fetcher->send(host_, "https://" + host_ + "/news/" + lang + ".json", method_name, ""))
-                {
-                    fetchers_.push_back(fetcher);
-                    return;
-                }
-            }
-        }
-
-        if (method_name == "image")
-        {
-            std::string url, selector;
-            if (args->GetString(1, &url) && args->GetString(2, &selector))
             {
-                if (true == fetcher->send(host_, url, method_name, selector))
-                {
-                    fetchers_.push_back(fetcher);
-                    return;
-                }
+                // stored feed first, a changed one follows after revalidation
+                news_lang_ = filter_lang(lang);
+                Netboxglobal::NewsCache::GetInstance()->get_feed(news_lang_, base::BindRepeating(&MessageHandler::OnNewsFeed, weak_ptr_factory_.GetWeakPtr(), news_lang_));
             }
         }
-        
-        delete fetcher;
     }
 }
 
@@ -283,115 +224,23 @@ void MessageHandler::on_get_lang_cookies_list(const net::CookieStatusList& cooki
     web_ui()->CallJavascriptFunctionUnsafe("netbox_send_event", std::move(event_name), std::move(data));
 }
 
-void MessageHandler::OnUniversalResult(const std::string *http_data, HTTPFetcher *fetcher)
-{
-    {
-
-        std::lock_guard<std::mutex> grd(fetchers_mutex_);
-
-        base::DictionaryValue data;
-
-        data.SetKey("success", base::Value(false));
-
-        if (http_data != nullptr)
-        {
-
-            if ("news" == fetcher->method_name_)
-            {
-                base::Optional<base::Value> json = base::JSONReader::Read(*http_data);
-                base::DictionaryValue *outdata;
-
-                if (json && json->GetAsDictionary(&outdata) && outdata)
-                {
-                    data.SetKey("data", std::move(*outdata));
-                    data.SetKey("success", base::Value(true));
-                }
-            }
-
-            if ("image" == fetcher->method_name_)
-            {
-                data.SetKey("image",    base::Value(*http_data));
-                data.SetKey("selector", base::Value(fetcher->selector_));
-                data.SetKey("success",  base::Value(true));
-            }
-        }
-
-        base::Value event_name(fetcher->method_name_);
-        web_ui()->CallJavascriptFunctionUnsafe("netbox_send_event", std::move(event_name), std::move(data));
-
-
-        auto it = std::find(fetchers_.begin(), fetchers_.end(), fetcher);
-
-        if (fetchers_.end() != it)
-        {
-            delete *it;
-            fetchers_.erase(it);
-        }
-
-    }
-}
-
-HTTPFetcher::HTTPFetcher(MessageHandler *handler)
-    : handler_(handler)
-{}
-
-bool HTTPFetcher::send(const std::string& host, const std::string& url, const std::string& method_name, const std::string& selector)
+void MessageHandler::OnNewsFeed(const std::string& lang, const base::Value& feed)
 {
-    selector_    = selector;
-    method_name_ = method_name;
-
-    Profile *profile = ProfileManager::GetLastUsedProfile();
-
-    scoped_refptr<network::SharedURLLoaderFactory> url_loader_factory = content::BrowserContext::GetDefaultStoragePartition(profile)->GetURLLoaderFactoryForBrowserProcess();
-
-    auto resource_request = std::make_unique<network::ResourceRequest>();
-
-    resource_request->url = GURL(url);
-    resource_request->method = "GET";
-    resource_request->site_for_cookies = net::SiteForCookies::FromUrl(GURL("https://" + host));
-
-    sender_ = network::SimpleURLLoader::Create(std::move(resource_request), TRAFFIC_ANNOTATION_FOR_TESTS);
-
-    if (nullptr == sender_)
+    if (lang != news_lang_)
     {
-        VLOG(NETBOX_LOG_LEVEL) << L"news, failed to create sender, " << url;
-        return false;
+        return;
     }
 
-    VLOG(NETBOX_LOG_LEVEL) << "news, success, " << url;
-
-    sender_->SetAllowHttpErrorResults(true);
-    sender_->SetOnResponseStartedCallback(base::BindOnce(&HTTPFetcher::on_http_response_started, base::Unretained(this)));
-    sender_->DownloadToStringOfUnboundedSizeUntilCrashAndDie(url_loader_factory.get(), base::BindOnce(&HTTPFetcher::on_http_response_body, base::Unretained(this)));
-
-    return true;
-}
-
-int32_t HTTPFetcher::get_http_code() const
-{
-    return http_code_;
-}
+    base::DictionaryValue data;
 
-void HTTPFetcher::on_http_response_started(const GURL& final_url, const network::mojom::URLResponseHead& response_head)
-{
-    if (nullptr != response_head.headers)
+    data.SetKey("success", base::Value(feed.is_dict()));
+    if (feed.is_dict())
     {
-        http_code_ = response_head.headers->response_code();
+        data.SetKey("data", feed.Clone());
     }
-}
 
-void HTTPFetcher::on_http_response_body(std::unique_ptr<std::string> response)
-{
-    if (nullptr == response)
-    {
-        VLOG(NETBOX_LOG_LEVEL) << L"network error for HTTP news request " << static_cast<HTTPFetcher*>(this);
-        handler_->OnUniversalResult(nullptr, this);
-    }
-    else
-    {
-        VLOG(NETBOX_LOG_LEVEL) << "HTTP news " << static_cast<HTTPFetcher*>(this) << " request return " << http_code_;
-        handler_->OnUniversalResult(response.get(), this);
-    }
+    base::Value event_name("news");
+    web_ui()->CallJavascriptFunctionUnsafe("netbox_send_event", std::move(event_name), std::move(data));
 }
 
 }
@@ -413,4 +262,5 @@ NewsUI::NewsUI(content::WebUI* web_ui)
 
     content::WebUIDataSource::Add(profile, source);
     content::URLDataSource::Add(profile, std::make_unique<ThemeSource>(profile));
+    content::URLDataSource::Add(profile, std::make_unique<WalletImageSource>(profile));
 }
\ No newline at end of file
@@ -0,0 +1,204 @@
+#include <string>
+
+#include "base/bind.h"
+#include "base/files/scoped_temp_dir.h"
+#include "base/logging.h"
+#include "base/run_loop.h"
+#include "base/strings/stringprintf.h"
+#include "base/synchronization/lock.h"
+#include "base/task/thread_pool/thread_pool_instance.h"
+#include "base/threading/thread_restrictions.h"
+#include "chrome/browser/netbox/news/news_cache.h"
+#include "chrome/browser/ui/browser.h"
+#include "chrome/browser/ui/tabs/tab_strip_model.h"
+#include "chrome/common/webui_url_constants.h"
+#include "chrome/test/base/in_process_browser_test.h"
+#include "chrome/test/base/ui_test_utils.h"
+#include "content/public/test/browser_test.h"
+#include "content/public/test/browser_test_utils.h"
+#include "net/http/http_status_code.h"
+#include "net/test/embedded_test_server/embedded_test_server.h"
+#include "net/test/embedded_test_server/http_request.h"
+#include "net/test/embedded_test_server/http_response.h"
+#include "url/gurl.h"
+
+namespace Netboxglobal
+{
+
+// resolves once the slider is filled, the time is counted from the navigation start
+static const char WAIT_FOR_RENDER_SCRIPT[] =
+    "new Promise(resolve => {"
+    "  const check = () => document.querySelectorAll('#slider .slider__item').length"
+    "      ? resolve(performance.now()) : setTimeout(check, 5);"
+    "  check();"
+    "});";
+
+// stand-in for the news api, answers /news/<lang>.json with an etag and 304 for a matching If-None-Match
+class MockNewsApi
+{
+public:
+    MockNewsApi() = default;
+    ~MockNewsApi() = default;
+
+    void set_version(int version)
+    {
+        base::AutoLock lock(lock_);
+        version_ = version;
+    }
+
+    int requests()
+    {
+        base::AutoLock lock(lock_);
+        return requests_;
+    }
+
+    int not_modified()
+    {
+        base::AutoLock lock(lock_);
+        return not_modified_;
+    }
+
+    std::unique_ptr<net::test_server::HttpResponse> handle_request(const net::test_server::HttpRequest& request)
+    {
+        if (0 != request.relative_url.find("/news/"))
+        {
+            return nullptr;
+        }
+
+        base::AutoLock lock(lock_);
+        requests_++;
+
+        std::string etag = base::StringPrintf("\"feed-%d\"", version_);
+
+        auto response = std::make_unique<net::test_server::BasicHttpResponse>();
+        response->AddCustomHeader("ETag", etag);
+
+        auto it = request.headers.find("If-None-Match");
+        if (it != request.headers.end() && it->second == etag)
+        {
+            not_modified_++;
+            response->set_code(net::HTTP_NOT_MODIFIED);
+            return response;
+        }
+
+        std::string editors_pick;
+        for (int i = 0; i < 5; ++i)
+        {
+            editors_pick = editors_pick + (i ? "," : "") + base::StringPrintf(
+                "{\"title\":\"News %d.%d\",\"link\":\"https://netbox.global/%d\",\"creator\":\"Netbox\",\"imageUrl\":\"https://netbox.global/%d.png\"}",
+                version_, i, i, i);
+        }
+
+        response->set_content_type("application/json");
+        response->set_content("{\"editors_pick\":[" + editors_pick + "],\"latest_news\":[]}");
+
+        return response;
+    }
+
+private:
+    base::Lock lock_;
+    int version_ = 1;
+    int requests_ = 0;
+    int not_modified_ = 0;
+
+    DISALLOW_COPY_AND_ASSIGN(MockNewsApi);
+};
+
+class NewsBrowserTest : public InProcessBrowserTest
+{
+public:
+    NewsBrowserTest() = default;
+    ~NewsBrowserTest() override = default;
+
+    void SetUpOnMainThread() override
+    {
+        InProcessBrowserTest::SetUpOnMainThread();
+
+        {
+            base::ScopedAllowBlockingForTesting allow_blocking;
+            ASSERT_TRUE(temp_dir_.CreateUniqueTempDir());
+        }
+
+        news_server_.RegisterRequestHandler(base::BindRepeating(&MockNewsApi::handle_request, base::Unretained(&news_api_)));
+        ASSERT_TRUE(news_server_.Start());
+
+        NewsCache::GetInstance()->set_base_url_for_testing(news_server_.base_url());
+        NewsCache::GetInstance()->start(temp_dir_.GetPath());
+    }
+
+    void TearDownOnMainThread() override
+    {
+        NewsCache::GetInstance()->stop();
+
+        ASSERT_TRUE(news_server_.ShutdownAndWaitUntilComplete());
+
+        InProcessBrowserTest::TearDownOnMainThread();
+    }
+
+    // ms from the navigation start to the first rendered feed
+    double open_news()
+    {
+        ui_test_utils::NavigateToURL(browser(), GURL(chrome::kChromeUINewsURL));
+
+        return content::EvalJs(browser()->tab_strip_model()->GetActiveWebContents(), WAIT_FOR_RENDER_SCRIPT).ExtractDouble();
+    }
+
+protected:
+    base::ScopedTempDir temp_dir_;
+    MockNewsApi news_api_;
+    net::EmbeddedTestServer news_server_;
+
+private:
+    DISALLOW_COPY_AND_ASSIGN(NewsBrowserTest);
+};
+
+IN_PROC_BROWSER_TEST_F(NewsBrowserTest, TimeToFirstRender)
+{
+    // nothing stored, the page waits for the api
+    double cold_ms = open_news();
+    ASSERT_EQ(1, news_api_.requests());
+
+    // fresh feed, no request at all
+    double fresh_ms = open_news();
+    ASSERT_EQ(1, news_api_.requests());
+
+    // stale feed is shown at once and revalidated
+    NewsCache::GetInstance()->set_fresh_time_for_testing(base::TimeDelta());
+    double stale_ms = open_news();
+
+    while (news_api_.requests() < 2)
+    {
+        base::RunLoop().RunUntilIdle();
+    }
+    ASSERT_EQ(1, news_api_.not_modified());
+
+    LOG(INFO) << "chrome://news first render, ms: cold " << cold_ms << ", fresh " << fresh_ms << ", stale " << stale_ms;
+}
+
+IN_PROC_BROWSER_TEST_F(NewsBrowserTest, StoredFeedAfterRestart)
+{
+    open_news();
+    base::ThreadPoolInstance::Get()->FlushForTesting();
+
+    // a new session has the feed before any request, the api is not reachable
+    NewsCache cache;
+    cache.set_base_url_for_testing(GURL("http://127.0.0.1:1"));
+    cache.start(temp_dir_.GetPath());
+
+    int feeds_count = 0;
+    base::RunLoop run_loop;
+    cache.get_feed("en", base::BindRepeating([](int* feeds_count, base::RepeatingClosure quit, const base::Value& feed)
+    {
+        ASSERT_TRUE(feed.is_dict());
+        (*feeds_count)++;
+        quit.Run();
+    }, &feeds_count, run_loop.QuitClosure()));
+    run_loop.Run();
+
+    ASSERT_EQ(1, feeds_count);
+    ASSERT_EQ(1, news_api_.requests());
+
+    cache.stop();
+}
+
+}
@@ -3,6 +3,7 @@
 #include "base/command_line.h"
 #include "base/memory/ref_counted_memory.h"
 #include "chrome/browser/ui/webui/wallet/wallet_dom_handler.h"
+#include "chrome/browser/ui/webui/wallet/wallet_image_source.h"
 #include "chrome/browser/ui/webui/theme_source.h"
 #include "chrome/browser/profiles/profile.h"
 #include "chrome/common/url_constants.h"
@@ -55,5 +56,6 @@ WalletUI::WalletUI(content::WebUI* web_ui) : WebUIController(web_ui)
 
     content::WebUIDataSource::Add(profile, source);
     content::URLDataSource::Add(profile, std::make_unique<ThemeSource>(profile));
+    content::URLDataSource::Add(profile, std::make_unique<WalletImageSource>(profile));
 
 }
\ No newline at end of file
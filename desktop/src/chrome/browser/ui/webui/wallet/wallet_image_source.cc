@@ -0,0 +1,216 @@
+#include "chrome/browser/ui/webui/wallet/wallet_image_source.h"
+
+#include "base/bind.h"
+#include "base/metrics/histogram_functions.h"
+#include "base/strings/string_util.h"
+#include "base/task/task_traits.h"
+#include "base/task/thread_pool.h"
+#include "chrome/browser/profiles/profile.h"
+#include "chrome/common/webui_url_constants.h"
+#include "components/netboxglobal_utils/utils.h"
+#include "content/public/browser/storage_partition.h"
+#include "net/base/escape.h"
+#include "net/base/url_util.h"
+#include "net/traffic_annotation/network_traffic_annotation_test_helper.h"
+#include "services/network/public/cpp/resource_request.h"
+#include "services/network/public/cpp/shared_url_loader_factory.h"
+#include "services/network/public/cpp/simple_url_loader.h"
+#include "services/network/public/mojom/url_response_head.mojom.h"
+#include "url/url_constants.h"
+
+static const int64_t IMAGE_CACHE_MAX_BYTES = 50 * 1024 * 1024;
+static const size_t IMAGE_MAX_BYTES = 5 * 1024 * 1024;
+
+// images are only fetched from these hosts and their subdomains
+static const char* const IMAGE_HOSTS[] =
+{
+    "netbox.global"
+};
+
+struct ImageMimeType
+{
+    const char* extension;
+    const char* mime_type;
+};
+
+// used only until the stored type of the url is known, before the first download of the url
+// or the mime types of the previous session are read
+static const ImageMimeType IMAGE_MIME_TYPES[] =
+{
+    {".bmp",    "image/bmp"},
+    {".gif",    "image/gif"},
+    {".ico",    "image/x-icon"},
+    {".jpeg",   "image/jpeg"},
+    {".jpg",    "image/jpeg"},
+    {".png",    "image/png"},
+    {".svg",    "image/svg+xml"},
+    {".webp",   "image/webp"}
+};
+
+static void write_to_cache(Netboxglobal::WalletImageCache* cache, const std::string& url, const std::string& mime_type, scoped_refptr<base::RefCountedString> image)
+{
+    cache->write(url, mime_type, image->data());
+}
+
+WalletImageSource::WalletImageSource(Profile* profile)
+    : profile_(profile),
+      cache_task_runner_(base::ThreadPool::CreateSequencedTaskRunner({base::MayBlock(), base::TaskPriority::USER_VISIBLE, base::TaskShutdownBehavior::SKIP_ON_SHUTDOWN})),
+      cache_(new Netboxglobal::WalletImageCache(profile->GetPath().Append(FILE_PATH_LITERAL("Wallet Image Cache")), IMAGE_CACHE_MAX_BYTES),
+             base::OnTaskRunnerDeleter(cache_task_runner_))
+{
+    cache_task_runner_->PostTaskAndReplyWithResult(FROM_HERE,
+        base::BindOnce(&Netboxglobal::WalletImageCache::read_mime_types, base::Unretained(cache_.get())),
+        base::BindOnce(&WalletImageSource::on_mime_types_read, weak_factory_.GetWeakPtr()));
+}
+
+WalletImageSource::~WalletImageSource()
+{
+}
+
+// static
+std::string WalletImageSource::get_image_source_url(const std::string& image_url)
+{
+    return std::string(chrome::kChromeUIWalletImageURL) + "?url=" + net::EscapeQueryParamValue(image_url, true);
+}
+
+std::string WalletImageSource::GetSource()
+{
+    return chrome::kChromeUIWalletImageHost;
+}
+
+void WalletImageSource::StartDataRequest(const GURL& url, const content::WebContents::Getter& wc_getter, content::URLDataSource::GotDataCallback callback)
+{
+    GURL image_url = get_image_url(content::URLDataSource::URLToRequestPath(url));
+    if (image_url.is_empty())
+    {
+        std::move(callback).Run(nullptr);
+        return;
+    }
+
+    std::unique_ptr<std::string> mime_type = std::make_unique<std::string>();
+    std::string* mime_type_ptr = mime_type.get();
+
+    // the cache is owned by this source and deleted on its sequence after the read,
+    // the mime type is owned by the reply
+    cache_task_runner_->PostTaskAndReplyWithResult(FROM_HERE,
+        base::BindOnce(&Netboxglobal::WalletImageCache::read, base::Unretained(cache_.get()), image_url.spec(), base::Unretained(mime_type_ptr)),
+        base::BindOnce(&WalletImageSource::on_cache_read, weak_factory_.GetWeakPtr(), image_url, std::move(callback), std::move(mime_type)));
+}
+
+std::string WalletImageSource::GetMimeType(const std::string& path)
+{
+    GURL image_url = get_image_url(path);
+
+    auto it = mime_types_.find(Netboxglobal::WalletImageCache::get_key(image_url.spec()));
+    if (it != mime_types_.end())
+    {
+        return it->second;
+    }
+
+    std::string image_path = base::ToLowerASCII(image_url.path());
+
+    for (const ImageMimeType& image_mime_type : IMAGE_MIME_TYPES)
+    {
+        if (base::EndsWith(image_path, image_mime_type.extension))
+        {
+            return image_mime_type.mime_type;
+        }
+    }
+
+    return "image/png";
+}
+
+bool WalletImageSource::ShouldReplaceExistingSource()
+{
+    // every wallet and news tab adds it, one cache per profile
+    return false;
+}
+
+// static
+GURL WalletImageSource::get_image_url(const std::string& path)
+{
+    std::string image_url;
+    if (!net::GetValueForKeyInQuery(GURL(chrome::kChromeUIWalletImageURL + path), "url", &image_url))
+    {
+        return GURL();
+    }
+
+    // the browser fetches it with the profile's network context, so local and lan hosts must not be reachable
+    GURL result(image_url);
+    if (!result.is_valid() || !result.SchemeIs(url::kHttpsScheme) || result.has_port())
+    {
+        return GURL();
+    }
+
+    for (const char* image_host : IMAGE_HOSTS)
+    {
+        if (result.DomainIs(image_host))
+        {
+            return result;
+        }
+    }
+
+    return GURL();
+}
+
+void WalletImageSource::on_mime_types_read(std::map<std::string, std::string> mime_types)
+{
+    // the types of this session are newer
+    mime_types_.insert(mime_types.begin(), mime_types.end());
+}
+
+void WalletImageSource::on_cache_read(const GURL& image_url, content::URLDataSource::GotDataCallback callback, std::unique_ptr<std::string> mime_type, scoped_refptr<base::RefCountedMemory> data)
+{
+    base::UmaHistogramBoolean("Netbox.WalletImageSource.CacheHit", !!data);
+
+    if (data)
+    {
+        mime_types_[Netboxglobal::WalletImageCache::get_key(image_url.spec())] = *mime_type;
+
+        std::move(callback).Run(std::move(data));
+        return;
+    }
+
+    auto resource_request = std::make_unique<network::ResourceRequest>();
+    resource_request->url               = image_url;
+    resource_request->method            = "GET";
+    resource_request->credentials_mode  = network::mojom::CredentialsMode::kOmit;
+    // a redirect could lead out of the netbox hosts
+    resource_request->redirect_mode     = network::mojom::RedirectMode::kError;
+
+    std::unique_ptr<network::SimpleURLLoader> loader = network::SimpleURLLoader::Create(std::move(resource_request), TRAFFIC_ANNOTATION_FOR_TESTS);
+    network::SimpleURLLoader* loader_ptr = loader.get();
+    loaders_[loader_ptr] = std::move(loader);
+
+    scoped_refptr<network::SharedURLLoaderFactory> url_loader_factory = profile_->GetDefaultStoragePartition()->GetURLLoaderFactoryForBrowserProcess();
+
+    loader_ptr->DownloadToString(url_loader_factory.get(),
+        base::BindOnce(&WalletImageSource::on_downloaded, weak_factory_.GetWeakPtr(), loader_ptr, image_url, std::move(callback)),
+        IMAGE_MAX_BYTES);
+}
+
+void WalletImageSource::on_downloaded(network::SimpleURLLoader* loader, const GURL& image_url, content::URLDataSource::GotDataCallback callback, std::unique_ptr<std::string> data)
+{
+    std::unique_ptr<network::SimpleURLLoader> finished = std::move(loaders_[loader]);
+    loaders_.erase(loader);
+
+    // error pages are not images and are not kept
+    if (!data || !finished->ResponseInfo() || !Netboxglobal::WalletImageCache::is_valid_mime_type(finished->ResponseInfo()->mime_type))
+    {
+        VLOG(NETBOX_LOG_LEVEL) << "wallet image, download failed " << image_url << ", " << finished->NetError();
+        std::move(callback).Run(nullptr);
+        return;
+    }
+
+    base::UmaHistogramCounts10M("Netbox.WalletImageSource.ImageSize", static_cast<int>(data->size()));
+
+    // the page and the cache share one buffer
+    scoped_refptr<base::RefCountedString> image = base::RefCountedString::TakeString(data.get());
+
+    const std::string& mime_type = finished->ResponseInfo()->mime_type;
+    mime_types_[Netboxglobal::WalletImageCache::get_key(image_url.spec())] = mime_type;
+
+    cache_task_runner_->PostTask(FROM_HERE, base::BindOnce(&write_to_cache, base::Unretained(cache_.get()), image_url.spec(), mime_type, image));
+
+    std::move(callback).Run(std::move(image));
+}
@@ -0,0 +1,61 @@
+#ifndef CHROME_BROWSER_UI_WEBUI_WALLET_IMAGE_SOURCE_H_
+#define CHROME_BROWSER_UI_WEBUI_WALLET_IMAGE_SOURCE_H_
+
+#include <map>
+#include <memory>
+#include <string>
+
+#include "base/macros.h"
+#include "base/memory/weak_ptr.h"
+#include "base/sequenced_task_runner.h"
+#include "chrome/browser/netbox/wallet_manager/wallet_image_cache.h"
+#include "content/public/browser/url_data_source.h"
+#include "url/gurl.h"
+
+class Profile;
+
+namespace network
+{
+class SimpleURLLoader;
+}
+
+// chrome://wallet-image/?url=<escaped image url>, remote images of the netbox hosts for <img src> of the wallet
+// and news pages, served from the disk cache or downloaded by the browser
+class WalletImageSource : public content::URLDataSource
+{
+public:
+    explicit WalletImageSource(Profile* profile);
+    ~WalletImageSource() override;
+
+    static std::string get_image_source_url(const std::string& image_url);
+
+    // content::URLDataSource implementation
+    std::string GetSource() override;
+    void StartDataRequest(const GURL& url, const content::WebContents::Getter& wc_getter, content::URLDataSource::GotDataCallback callback) override;
+    std::string GetMimeType(const std::string& path) override;
+    bool ShouldReplaceExistingSource() override;
+
+private:
+    // empty when the path has no https url of a netbox host
+    static GURL get_image_url(const std::string& path);
+
+    void on_mime_types_read(std::map<std::string, std::string> mime_types);
+    void on_cache_read(const GURL& image_url, content::URLDataSource::GotDataCallback callback, std::unique_ptr<std::string> mime_type, scoped_refptr<base::RefCountedMemory> data);
+    void on_downloaded(network::SimpleURLLoader* loader, const GURL& image_url, content::URLDataSource::GotDataCallback callback, std::unique_ptr<std::string> data);
+
+    Profile* profile_;
+
+    scoped_refptr<base::SequencedTaskRunner> cache_task_runner_;
+    std::unique_ptr<Netboxglobal::WalletImageCache, base::OnTaskRunnerDeleter> cache_;
+
+    std::map<network::SimpleURLLoader*, std::unique_ptr<network::SimpleURLLoader>> loaders_;
+
+    // cache key to the mime type the image was served with
+    std::map<std::string, std::string> mime_types_;
+
+    base::WeakPtrFactory<WalletImageSource> weak_factory_{this};
+
+    DISALLOW_COPY_AND_ASSIGN(WalletImageSource);
+};
+
+#endif
@@ -29,6 +29,9 @@ const char kChromeUIDapstoreURL[] = "chrome://dapp-store/";
 
 const char kChromeUINewsHost[] = "news";
 const char kChromeUINewsURL[] = "chrome://news/";
+
+const char kChromeUIWalletImageHost[] = "wallet-image";
+const char kChromeUIWalletImageURL[] = "chrome://wallet-image/";
 //netboxcomment end
 
 
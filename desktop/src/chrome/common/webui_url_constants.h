@@ -32,6 +32,8 @@ extern const char kChromeUIDapstoreHost[];
 extern const char kChromeUIDapstoreURL[];
 extern const char kChromeUINewsHost[];
 extern const char kChromeUINewsURL[];
+extern const char kChromeUIWalletImageHost[];
+extern const char kChromeUIWalletImageURL[];
 //netboxcomment end
 
 // chrome: components (without schemes) and URLs (including schemes).
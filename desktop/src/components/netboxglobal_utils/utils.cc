@@ -3,23 +3,174 @@
 #include "base/environment.h"
 #include "base/files/file_util.h"
 #include "base/logging.h"
+#include "base/strings/string_piece.h"
+#include "base/strings/string_util.h"
+
+#include <string.h>
 
-#include <regex>
 #include <vector>
 
 namespace Netboxglobal
 {
 
+// the log writer runs it for every line, so it is a single bounded pass, a regex backtracking
+// over a long rpc dump costs time and stack
+namespace
+{
+
+const char* const SECRET_KEYS[] = {"hdseed", "hdseedid", "password", "xpub"};
+const char* const SECRET_PARAMS_METHODS[] = {"sethdseed", "encryptwallet", "walletpassphrase"};
+
+const char SECRET_PARAMS_PREFIX[] = "\",\"params\":[";
+const char SECRET_RESULT_PREFIX[] = "{\"result\":\"";
+const char SECRET_RESULT_SUFFIX[] = "\",\"error\":null,\"id\":null}";
+
+bool matches_at(const std::string& text, size_t pos, base::StringPiece token)
+{
+    return pos <= text.size() && base::StartsWith(base::StringPiece(text).substr(pos), token, base::CompareCase::INSENSITIVE_ASCII);
+}
+
+// "." of the former patterns did not cross lines
+size_t find_line_end(const std::string& text, size_t pos)
+{
+    size_t line_end = text.find_first_of("\r\n", pos);
+    return line_end == std::string::npos ? text.size() : line_end;
+}
+
+// "key": "<letters and digits>" -> "key":"***", returns the end of the match or npos
+size_t match_secret_value(const std::string& text, size_t pos, size_t* key_size)
+{
+    for (const char* key : SECRET_KEYS)
+    {
+        size_t key_length = strlen(key);
+        size_t it = pos + 1;
+
+        if (!matches_at(text, it, key) || !matches_at(text, it + key_length, "\":"))
+        {
+            continue;
+        }
+
+        it = it + key_length + 2;
+        while (it < text.size() && base::IsAsciiWhitespace(text[it]))
+        {
+            it++;
+        }
+
+        if (it >= text.size() || text[it] != '"')
+        {
+            continue;
+        }
+
+        size_t value_start = ++it;
+        while (it < text.size() && (base::IsAsciiAlpha(text[it]) || base::IsAsciiDigit(text[it])))
+        {
+            it++;
+        }
+
+        if (it == value_start || it >= text.size() || text[it] != '"')
+        {
+            continue;
+        }
+
+        *key_size = key_length;
+        return it + 1;
+    }
+
+    return std::string::npos;
+}
+
+// "method","params":[...] -> "method","params":***, up to the last ] of the line
+size_t match_secret_params(const std::string& text, size_t pos, size_t* method_size)
+{
+    for (const char* method : SECRET_PARAMS_METHODS)
+    {
+        size_t method_length = strlen(method);
+
+        if (!matches_at(text, pos + 1, method) || !matches_at(text, pos + 1 + method_length, SECRET_PARAMS_PREFIX))
+        {
+            continue;
+        }
+
+        size_t params_start = pos + 1 + method_length + strlen(SECRET_PARAMS_PREFIX);
+        size_t line_end = find_line_end(text, params_start);
+
+        size_t params_end = base::StringPiece(text).substr(0, line_end).rfind(']');
+        if (params_end == std::string::npos || params_end < params_start)
+        {
+            continue;
+        }
+
+        *method_size = method_length;
+        return params_end + 1;
+    }
+
+    return std::string::npos;
+}
+
+// {"result":"...","error":null,"id":null} -> {"result":"***",...}, up to the last such end of the line
+size_t match_secret_result(const std::string& text, size_t pos)
+{
+    if (!matches_at(text, pos, SECRET_RESULT_PREFIX))
+    {
+        return std::string::npos;
+    }
+
+    size_t result_start = pos + strlen(SECRET_RESULT_PREFIX);
+    size_t line_end = find_line_end(text, result_start);
+
+    size_t suffix_start = base::StringPiece(text).substr(0, line_end).rfind(SECRET_RESULT_SUFFIX);
+    if (suffix_start == std::string::npos || suffix_start < result_start)
+    {
+        return std::string::npos;
+    }
+
+    return suffix_start + strlen(SECRET_RESULT_SUFFIX);
+}
+
+}
+
 std::string filter_confidentional_data(const std::string &Json)
 {
-    std::regex rgx1("\"(hdseed|hdseedid|password|xpub)\":\\s*\"([a-z0-9]+)\"", std::regex_constants::icase);
-    std::string str1 = std::regex_replace(Json, rgx1, "\"$1\":\"***\"");
+    // lines without a quote have nothing to hide
+    if (Json.find('"') == std::string::npos)
+    {
+        return Json;
+    }
+
+    std::string result;
+    result.reserve(Json.size());
+
+    size_t pos = 0;
+    while (pos < Json.size())
+    {
+        size_t match_end = std::string::npos;
+        size_t name_size = 0;
+
+        if (Json[pos] == '"' && (match_end = match_secret_value(Json, pos, &name_size)) != std::string::npos)
+        {
+            result.append(Json, pos, name_size + 1);
+            result.append("\":\"***\"");
+        }
+        else if (Json[pos] == '"' && (match_end = match_secret_params(Json, pos, &name_size)) != std::string::npos)
+        {
+            result.append(Json, pos, name_size + 1);
+            result.append("\",\"params\":***");
+        }
+        else if (Json[pos] == '{' && (match_end = match_secret_result(Json, pos)) != std::string::npos)
+        {
+            result.append("{\"result\":\"***\",\"error\":null,\"id\":null}");
+        }
+        else
+        {
+            result.push_back(Json[pos]);
+            pos++;
+            continue;
+        }
 
-    std::regex rgx2("\"(sethdseed|encryptwallet|walletpassphrase)\",\"params\":\\[.*\\]", std::regex_constants::icase);
-    std::string str2 = std::regex_replace(str1, rgx2, "\"$1\",\"params\":***");
+        pos = match_end;
+    }
 
-    std::regex rgx3("\\{\"result\":\".*\",\"error\":null,\"id\":null\\}", std::regex_constants::icase);
-    return std::regex_replace(str2, rgx3, "{\"result\":\"***\",\"error\":null,\"id\":null}");
+    return result;
 }
 
 bool is_qa()
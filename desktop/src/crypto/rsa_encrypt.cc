@@ -1,9 +1,15 @@
 //netboxglobal begin
 
+#include <algorithm>
+
 #include "base/logging.h"
+#include "base/memory/ptr_util.h"
 #include "crypto/rsa_encrypt.h"
 #include "crypto/openssl_util.h"
+#include "third_party/boringssl/src/include/openssl/aead.h"
 #include "third_party/boringssl/src/include/openssl/bytestring.h"
+#include "third_party/boringssl/src/include/openssl/mem.h"
+#include "third_party/boringssl/src/include/openssl/rand.h"
 #include "third_party/boringssl/src/include/openssl/rsa.h"
 #include "third_party/boringssl/src/include/openssl/evp.h"
 
@@ -18,108 +24,175 @@
 
 namespace crypto {
 
-bool RSAEncrypt(base::span<const uint8_t> public_key_info,
-                base::span<const uint8_t> orig_data,
-                std::vector<uint8_t> &enc_data) {
-                    
+static const size_t PKCS1_PADDING_LEN = 11;
+
+const size_t RSAPublicKey::kSessionKeyLen;
+const size_t RSAPublicKey::kNonceLen;
+
+// static
+std::unique_ptr<RSAPublicKey> RSAPublicKey::Create(
+    base::span<const uint8_t> public_key_info) {
+
     OpenSSLErrStackTracer err_tracer(FROM_HERE);
 
     CBS cbs;
     CBS_init(&cbs, public_key_info.data(), public_key_info.size());
 
-    bssl::UniquePtr<EVP_PKEY> public_key(EVP_parse_public_key(&cbs));
+    bssl::UniquePtr<EVP_PKEY> key(EVP_parse_public_key(&cbs));
 
-    if (!public_key || CBS_len(&cbs) != 0){
+    if (!key || CBS_len(&cbs) != 0 || EVP_PKEY_id(key.get()) != EVP_PKEY_RSA){
         VLOG(1) << "cant load RSA public key";
-        return false;
+        return nullptr;
     }
 
-    bssl::UniquePtr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new(public_key.get(), nullptr));
+    return base::WrapUnique(new RSAPublicKey(std::move(key)));
+}
 
-   	R(EVP_PKEY_encrypt_init(ctx.get()), "cant initialize public key encrypt context");
-    R(EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING), "cant set PKCS1 padding");
-    
-    size_t outlen = 0;
+RSAPublicKey::RSAPublicKey(bssl::UniquePtr<EVP_PKEY> key) : key_(std::move(key)) {
+}
 
-    R(EVP_PKEY_encrypt(ctx.get(),
-                       nullptr,
-                       &outlen,
-                       orig_data.data(),
-                       orig_data.size()), "cant calculate RSA encrypted len");
+RSAPublicKey::~RSAPublicKey() = default;
 
-    enc_data.resize(outlen);
+bssl::UniquePtr<EVP_PKEY_CTX> RSAPublicKey::CreateEncryptContext() const {
+    bssl::UniquePtr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new(key_.get(), nullptr));
 
-    R(EVP_PKEY_encrypt(ctx.get(),
-                       enc_data.data(),
-                       &outlen,
-                       orig_data.data(),
-                       orig_data.size()), "cant RSA encrypt");
-    return true;
+    if (!ctx
+     || EVP_PKEY_encrypt_init(ctx.get()) <= 0
+     || EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING) <= 0) {
+        VLOG(1) << "cant initialize public key encrypt context";
+        return nullptr;
+    }
+
+    return ctx;
 }
 
-static bool encrypt_block(const unsigned char *data, size_t data_len, EVP_PKEY *pb_key, std::vector<std::vector<unsigned char>> &blocks)
+static bool encrypt_block(EVP_PKEY_CTX *ctx, const uint8_t *data, size_t data_len, std::vector<uint8_t> &enc_data)
 {
-    bssl::UniquePtr<EVP_PKEY_CTX> ctx(EVP_PKEY_CTX_new(pb_key, nullptr));
-
-   	R(EVP_PKEY_encrypt_init(ctx.get()), "cant initialize public key encrypt context");
-    R(EVP_PKEY_CTX_set_rsa_padding(ctx.get(), RSA_PKCS1_PADDING), "cant set PKCS1 padding");
-
     size_t outlen = 0;
 
-    R(EVP_PKEY_encrypt(ctx.get(),
+    R(EVP_PKEY_encrypt(ctx,
                        nullptr,
                        &outlen,
                        data,
-                       data_len), "cant calculate encrypted len");
+                       data_len), "cant calculate RSA encrypted len");
 
-    std::vector<unsigned char> enc_data(outlen);
+    enc_data.resize(outlen);
 
-    R(EVP_PKEY_encrypt(ctx.get(),
+    R(EVP_PKEY_encrypt(ctx,
                        enc_data.data(),
                        &outlen,
                        data,
-                       data_len), "cant encrypt");
+                       data_len), "cant RSA encrypt");
 
-    blocks.push_back(std::move(enc_data));
+    enc_data.resize(outlen);
 
-    return 1;
+    return true;
 }
 
-bool RSAEncrypt(base::span<const uint8_t> public_key_info,
-                base::span<const uint8_t> orig_data,
-                std::vector<std::vector<uint8_t>> &enc_data) {
+bool RSAPublicKey::Encrypt(base::span<const uint8_t> orig_data,
+                           std::vector<uint8_t> &enc_data) const {
 
     OpenSSLErrStackTracer err_tracer(FROM_HERE);
 
-    CBS cbs;
-    CBS_init(&cbs, public_key_info.data(), public_key_info.size());
+    bssl::UniquePtr<EVP_PKEY_CTX> ctx = CreateEncryptContext();
+    if (!ctx) {
+        return false;
+    }
 
-    bssl::UniquePtr<EVP_PKEY> pb_key(EVP_parse_public_key(&cbs));
+    return encrypt_block(ctx.get(), orig_data.data(), orig_data.size(), enc_data);
+}
 
-    bssl::UniquePtr<RSA> rsa_key(EVP_PKEY_get1_RSA(pb_key.get()));
-    int key_length = RSA_size(rsa_key.get());
+bool RSAPublicKey::EncryptBlocks(base::span<const uint8_t> orig_data,
+                                 std::vector<std::vector<uint8_t>> &enc_data) const {
 
-    const int PKCS1_PADDING_LEN = 11;
-    int msg_len = key_length - PKCS1_PADDING_LEN;
+    OpenSSLErrStackTracer err_tracer(FROM_HERE);
 
-    int msg_cnt = orig_data.size() / msg_len;
-    int padding = orig_data.size() % msg_len;
+    // one context for all blocks of the payload
+    bssl::UniquePtr<EVP_PKEY_CTX> ctx = CreateEncryptContext();
+    if (!ctx) {
+        return false;
+    }
 
-    const uint8_t *ptr = orig_data.data();
+    size_t msg_len = EVP_PKEY_size(key_.get()) - PKCS1_PADDING_LEN;
 
-    for (int i = 0; i < msg_cnt; i++){
+    enc_data.reserve(enc_data.size() + (orig_data.size() + msg_len - 1) / msg_len);
 
-        R(encrypt_block(ptr, msg_len, pb_key.get(), enc_data), "cant encrypt block");
+    for (size_t offset = 0; offset < orig_data.size(); offset += msg_len){
 
-        ptr += msg_len;
+        std::vector<uint8_t> block;
+        R(encrypt_block(ctx.get(), orig_data.data() + offset, std::min(msg_len, orig_data.size() - offset), block), "cant encrypt block");
+
+        enc_data.push_back(std::move(block));
     }
 
-    if (padding != 0)
-        R(encrypt_block(ptr, padding, pb_key.get(), enc_data), "cant encrypt block");
+    return true;
+}
+
+bool RSAPublicKey::HybridEncrypt(base::span<const uint8_t> orig_data,
+                                 std::vector<uint8_t> &enc_key,
+                                 std::vector<uint8_t> &nonce,
+                                 std::vector<uint8_t> &enc_data) const {
+
+    OpenSSLErrStackTracer err_tracer(FROM_HERE);
+
+    const EVP_AEAD *aead = EVP_aead_aes_256_gcm();
+
+    uint8_t session_key[kSessionKeyLen];
+    nonce.resize(kNonceLen);
+
+    R(RAND_bytes(session_key, sizeof(session_key)), "cant generate session key");
+    R(RAND_bytes(nonce.data(), nonce.size()), "cant generate nonce");
+
+    bool wrapped = Encrypt(base::make_span(session_key), enc_key);
+
+    bssl::ScopedEVP_AEAD_CTX aead_ctx;
+    int initialized = EVP_AEAD_CTX_init(aead_ctx.get(), aead, session_key, sizeof(session_key), EVP_AEAD_DEFAULT_TAG_LENGTH, nullptr);
+
+    OPENSSL_cleanse(session_key, sizeof(session_key));
+
+    if (!wrapped) {
+        return false;
+    }
+
+    R(initialized, "cant initialize AES-GCM context");
+
+    size_t outlen = 0;
+    enc_data.resize(orig_data.size() + EVP_AEAD_max_overhead(aead));
+
+    R(EVP_AEAD_CTX_seal(aead_ctx.get(),
+                        enc_data.data(),
+                        &outlen,
+                        enc_data.size(),
+                        nonce.data(),
+                        nonce.size(),
+                        orig_data.data(),
+                        orig_data.size(),
+                        nullptr,
+                        0), "cant AES-GCM seal");
+
+    enc_data.resize(outlen);
 
     return true;
 }
 
+bool RSAEncrypt(base::span<const uint8_t> public_key_info,
+                base::span<const uint8_t> orig_data,
+                std::vector<uint8_t> &enc_data) {
+
+    std::unique_ptr<RSAPublicKey> public_key = RSAPublicKey::Create(public_key_info);
+
+    return public_key && public_key->Encrypt(orig_data, enc_data);
+}
+
+bool RSAEncrypt(base::span<const uint8_t> public_key_info,
+                base::span<const uint8_t> orig_data,
+                std::vector<std::vector<uint8_t>> &enc_data) {
+
+    std::unique_ptr<RSAPublicKey> public_key = RSAPublicKey::Create(public_key_info);
+
+    return public_key && public_key->EncryptBlocks(orig_data, enc_data);
+}
+
 }
 
-//netboxglobal end
\ No newline at end of file
+//netboxglobal end
@@ -3,14 +3,55 @@
 #ifndef CRYPTO_RSA_ENCRYPT_H_
 #define CRYPTO_RSA_ENCRYPT_H_
 
+#include <memory>
 #include <vector>
 
 #include "base/containers/span.h"
+#include "base/macros.h"
 #include "build/build_config.h"
 #include "crypto/crypto_export.h"
+#include "third_party/boringssl/src/include/openssl/base.h"
 
 namespace crypto {
 
+// parsed once and kept, every call uses its own EVP_PKEY_CTX so one key can be
+// shared between threads
+class CRYPTO_EXPORT RSAPublicKey {
+ public:
+  static const size_t kSessionKeyLen = 32;
+  static const size_t kNonceLen = 12;
+
+  // nullptr when public_key_info is not a DER SubjectPublicKeyInfo RSA key
+  static std::unique_ptr<RSAPublicKey> Create(
+      base::span<const uint8_t> public_key_info);
+
+  ~RSAPublicKey();
+
+  // PKCS1 padded, orig_data must fit into one block
+  bool Encrypt(base::span<const uint8_t> orig_data,
+               std::vector<uint8_t> &enc_data) const;
+
+  // orig_data is split into key size minus padding blocks
+  bool EncryptBlocks(base::span<const uint8_t> orig_data,
+                     std::vector<std::vector<uint8_t>> &enc_data) const;
+
+  // orig_data is sealed with a random AES-256-GCM key, the tag is appended,
+  // the key itself is PKCS1 encrypted with this public key
+  bool HybridEncrypt(base::span<const uint8_t> orig_data,
+                     std::vector<uint8_t> &enc_key,
+                     std::vector<uint8_t> &nonce,
+                     std::vector<uint8_t> &enc_data) const;
+
+ private:
+  explicit RSAPublicKey(bssl::UniquePtr<EVP_PKEY> key);
+
+  bssl::UniquePtr<EVP_PKEY_CTX> CreateEncryptContext() const;
+
+  bssl::UniquePtr<EVP_PKEY> key_;
+
+  DISALLOW_COPY_AND_ASSIGN(RSAPublicKey);
+};
+
 bool CRYPTO_EXPORT RSAEncrypt(base::span<const uint8_t> public_key_info,
                               base::span<const uint8_t> orig_data,
                               std::vector<uint8_t> &enc_data);
@@ -22,4 +63,4 @@ bool CRYPTO_EXPORT RSAEncrypt(base::span<const uint8_t> public_key_info,
 
 #endif
 
-//netboxglobal end
\ No newline at end of file
+//netboxglobal end
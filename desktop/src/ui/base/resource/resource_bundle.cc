@@ -65,10 +65,12 @@
 #endif
 
 // begin netboxglobal
-#include "base/files/file_path.h" 
+#include "base/files/file_path.h"
+#include "base/metrics/histogram_functions.h"
 #include "base/strings/string_util.h"                  
 #include "base/strings/sys_string_conversions.h"       
 #include "base/strings/utf_string_conversions.h"       
+#include "base/timer/elapsed_timer.h"
 // end netboxglobal
 
 
@@ -175,6 +177,71 @@ void DecompressIfNeeded(base::StringPiece data, std::string* output) {
   }
 }
 
+// begin netboxglobal
+// product names are replaced with the rules of the former regex
+// (?<![a-zA-Z_@./])(?<!Google )(?<!href="\$[0-9]">)(Chromium|Chrome)
+// (?![a-zA-Z_/@])(?! OS)(?! Frame)(?! Web Store)(?![.][a-zA-Z])(?!</a>)
+constexpr base::StringPiece16 kRebrandPrefix = u"Chrom";
+constexpr base::StringPiece16 kRebrandChrome = u"Chrome";
+constexpr base::StringPiece16 kRebrandChromium = u"Chromium";
+
+bool IsRebrandAsciiLetter(char16_t c) {
+  return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+bool IsRebrandPrecededBy(base::StringPiece16 src,
+                         size_t pos,
+                         base::StringPiece16 prefix) {
+  return pos >= prefix.size() &&
+         src.substr(pos - prefix.size(), prefix.size()) == prefix;
+}
+
+bool CanRebrandAt(base::StringPiece16 src,
+                  size_t pos,
+                  base::StringPiece16 name) {
+  if (src.substr(pos, name.size()) != name)
+    return false;
+
+  if (pos > 0) {
+    char16_t c = src[pos - 1];
+    if (IsRebrandAsciiLetter(c) || c == '_' || c == '@' || c == '.' ||
+        c == '/')
+      return false;
+  }
+
+  if (IsRebrandPrecededBy(src, pos, u"Google "))
+    return false;
+
+  // <a href="$1">Chrome</a> placeholders
+  if (pos >= 10 && IsRebrandPrecededBy(src, pos - 3, u"href=\"$") &&
+      base::IsAsciiDigit(src[pos - 3]) &&
+      IsRebrandPrecededBy(src, pos, u"\">"))
+    return false;
+
+  size_t end = pos + name.size();
+  if (end == src.size())
+    return true;
+
+  char16_t c = src[end];
+  if (IsRebrandAsciiLetter(c) || c == '_' || c == '/' || c == '@')
+    return false;
+
+  if (c == '.' && end + 1 < src.size() && IsRebrandAsciiLetter(src[end + 1]))
+    return false;
+
+  base::StringPiece16 rest = src.substr(end);
+  for (base::StringPiece16 suffix : {base::StringPiece16(u" OS"),
+                                     base::StringPiece16(u" Frame"),
+                                     base::StringPiece16(u" Web Store"),
+                                     base::StringPiece16(u"</a>")}) {
+    if (base::StartsWith(rest, suffix))
+      return false;
+  }
+
+  return true;
+}
+// end netboxglobal
+
 }  // namespace
 
 // An ImageSkiaSource that loads bitmaps for the requested scale factor from
@@ -432,6 +499,7 @@ std::string ResourceBundle::LoadLocaleResources(const std::string& pref_locale,
 
   locale_resources_data_ = std::move(data_pack);
   loaded_locale_ = pref_locale;
+  build_rebranded_strings(); // netboxglobal
   return app_locale;
 }
 #endif  // defined(OS_ANDROID)
@@ -455,6 +523,7 @@ void ResourceBundle::LoadTestResources(const base::FilePath& path,
   } else {
     locale_resources_data_ = std::make_unique<DataPack>(ui::SCALE_FACTOR_NONE);
   }
+  build_rebranded_strings(); // netboxglobal
 
   // This is necessary to initialize ICU since we won't be calling
   // LoadLocaleResources in this case.
@@ -464,6 +533,7 @@ void ResourceBundle::LoadTestResources(const base::FilePath& path,
 void ResourceBundle::UnloadLocaleResources() {
   locale_resources_data_.reset();
   secondary_locale_resources_data_.reset();
+  rebranded_strings_.reset(); // netboxglobal
 }
 
 void ResourceBundle::OverrideLocalePakForTest(const base::FilePath& pak_path) {
@@ -482,58 +552,121 @@ const base::FilePath& ResourceBundle::GetOverriddenPakPath() const {
 
 
 // begin netboxglobal
-bool ResourceBundle::translate(const std::u16string& src, std::u16string& dst)
+// static
+bool ResourceBundle::rebrand(const std::u16string& src, std::u16string& dst)
 {
-    if (!re_.get())
+    size_t pos = src.find(kRebrandPrefix.data(), 0, kRebrandPrefix.size());
+    if (pos == std::u16string::npos)
     {
         return false;
     }
 
-    if(src.find_first_of(u"Chrome") == std::string::npos && src.find_first_of(u"Chromium") == std::string::npos)
+    std::u16string result;
+    size_t copied = 0;
+
+    while (pos != std::u16string::npos)
+    {
+        // the longer name goes first as the regex alternation did
+        size_t length = 0;
+        if (CanRebrandAt(src, pos, kRebrandChromium))
+        {
+            length = kRebrandChromium.size();
+        }
+        else if (CanRebrandAt(src, pos, kRebrandChrome))
+        {
+            length = kRebrandChrome.size();
+        }
+
+        if (!length)
+        {
+            pos = src.find(kRebrandPrefix.data(), pos + 1, kRebrandPrefix.size());
+            continue;
+        }
+
+        result.append(src, copied, pos - copied);
+        result.append(u"Netbox");
+        copied = pos + length;
+
+        pos = src.find(kRebrandPrefix.data(), copied, kRebrandPrefix.size());
+    }
+
+    if (!copied)
     {
         return false;
     }
 
-    auto it = translations_.find(src);
-    if (it != translations_.end())
+    result.append(src, copied, std::u16string::npos);
+    dst = std::move(result);
+
+    return true;
+}
+
+void ResourceBundle::build_rebranded_strings()
+{
+    rebranded_strings_.reset();
+
+    if (!locale_resources_data_)
     {
-        dst = it->second;
+        return;
+    }
 
-        return true;
+    base::ElapsedTimer timer;
+
+    ResourceHandle::TextEncodingType encoding = locale_resources_data_->GetTextEncodingType();
+    if (encoding != ResourceHandle::UTF16 && encoding != ResourceHandle::UTF8)
+    {
+        return;
     }
-    
-    std::string res8 = base::UTF16ToUTF8(src);
-    icu::UnicodeString icu_input = icu::UnicodeString::fromUTF8(res8.c_str());
-    re_->reset(icu_input);
-    
-    UErrorCode status = U_ZERO_ERROR;
-    icu::UnicodeString replaced_string = re_->replaceAll("Netbox", status);
-    if (!U_SUCCESS(status))
-    {    
-        return false;
+
+    // pak ids are 16 bit and sorted, so the table is filled in order
+    std::vector<std::pair<int, std::u16string>> rebranded;
+    size_t string_count = 0;
+
+    for (uint32_t resource_id = 0; resource_id <= std::numeric_limits<uint16_t>::max(); ++resource_id)
+    {
+        base::StringPiece data;
+        if (!locale_resources_data_->GetStringPiece(static_cast<uint16_t>(resource_id), &data))
+        {
+            continue;
+        }
+
+        string_count++;
+
+        std::u16string msg;
+        if (encoding == ResourceHandle::UTF16)
+        {
+            msg = std::u16string(reinterpret_cast<const char16_t*>(data.data()), data.length() / 2);
+        }
+        else
+        {
+            // the names are ascii, most strings are never decoded here
+            if (data.find("Chrom") == base::StringPiece::npos)
+            {
+                continue;
+            }
+
+            msg = base::UTF8ToUTF16(data);
+        }
+
+        std::u16string dst;
+        if (rebrand(msg, dst))
+        {
+            rebranded.emplace_back(static_cast<int>(resource_id), std::move(dst));
+        }
     }
 
-    std::string dst8;
-    replaced_string.toUTF8String(dst8);
-    dst = base::UTF8ToUTF16(dst8);
+    size_t rebranded_count = rebranded.size();
+    rebranded_strings_ = std::make_unique<const base::flat_map<int, std::u16string>>(base::sorted_unique, std::move(rebranded));
 
-    translations_[src] = dst;
-   
-    return true;    
-} 
+    base::TimeDelta elapsed = timer.Elapsed();
+    base::UmaHistogramMicrosecondsTimes("Netbox.ResourceBundle.RebrandTableTime", elapsed);
+
+    VLOG(NETBOX_LOG_LEVEL) << "rebranded " << rebranded_count << " of " << string_count << " strings in " << elapsed.InMicroseconds() << "us";
+}
 // end netboxglobal
 
 std::u16string ResourceBundle::MaybeMangleLocalizedString(
-    const std::u16string& str) { // netboxcomment, remove const
-
-  // netboxglobal begin
-  std::u16string dst;
-  if (translate(str, dst))
-  {
-     return dst;
-  }
-  // netboxglobal end
-
+    const std::u16string& str) const {
   if (!mangle_localized_strings_)
     return str;
 
@@ -903,20 +1036,6 @@ ResourceBundle::ResourceBundle(Delegate* delegate)
       max_scale_factor_(SCALE_FACTOR_100P) {
   mangle_localized_strings_ = base::CommandLine::ForCurrentProcess()->HasSwitch(
       switches::kMangleLocalizedStrings);
-
-    // begin netboxglobal
-    UErrorCode status = U_ZERO_ERROR;
-
-    std::string pattern = "(?<![a-zA-Z_@.\\/])(?<!Google )(?<!href=\"\\$[0-9]\">)(Chromium|Chrome)(?![a-zA-Z]|_|\\/|@)(?! OS)(?! Frame)(?! Web Store)(?![.][a-zA-Z])(?!\\<\\/a\\>)";
-    const icu::UnicodeString icu_pattern(pattern.c_str(), pattern.length());
-    re_.reset(new icu::RegexMatcher(icu_pattern, 0, status));
-
-    if (status != U_ZERO_ERROR)
-    {
-        VLOG(NETBOX_LOG_LEVEL) << "pattern is not valid";
-    }
-    // end netboxglobal
-
 }
 
 ResourceBundle::~ResourceBundle() {
@@ -1102,10 +1221,12 @@ gfx::Image& ResourceBundle::GetEmptyImage() {
   return empty_image_;
 }
 
-std::u16string ResourceBundle::GetLocalizedStringImpl(int resource_id) { // netboxcomment remove const
+std::u16string ResourceBundle::GetLocalizedStringImpl(int resource_id) const {
   std::u16string string;
-  if (delegate_ && delegate_->GetLocalizedString(resource_id, &string))
+  if (delegate_ && delegate_->GetLocalizedString(resource_id, &string)) {
+    rebrand(string, string); // netboxglobal
     return MaybeMangleLocalizedString(string);
+  }
 
   // Ensure that ReloadLocaleResources() doesn't drop the resources while
   // we're using them.
@@ -1113,8 +1234,14 @@ std::u16string ResourceBundle::GetLocalizedStringImpl(int resource_id) { // netb
 
   IdToStringMap::const_iterator it =
       overridden_locale_strings_.find(resource_id);
-  if (it != overridden_locale_strings_.end())
+  if (it != overridden_locale_strings_.end()) {
+    // begin netboxglobal
+    std::u16string rebranded;
+    if (rebrand(it->second, rebranded))
+      return MaybeMangleLocalizedString(rebranded);
+    // end netboxglobal
     return MaybeMangleLocalizedString(it->second);
+  }
 
   // If for some reason we were unable to load the resources , return an empty
   // string (better than crashing).
@@ -1123,11 +1250,23 @@ std::u16string ResourceBundle::GetLocalizedStringImpl(int resource_id) { // netb
     return std::u16string();
   }
 
+  // begin netboxglobal
+  // pak strings were rebranded when it was loaded
+  bool is_prebuilt = false;
+  if (rebranded_strings_) {
+    auto rebranded_it = rebranded_strings_->find(resource_id);
+    if (rebranded_it != rebranded_strings_->end())
+      return MaybeMangleLocalizedString(rebranded_it->second);
+    is_prebuilt = true;
+  }
+  // end netboxglobal
+
   base::StringPiece data;
   ResourceHandle::TextEncodingType encoding =
       locale_resources_data_->GetTextEncodingType();
   if (!locale_resources_data_->GetStringPiece(
           static_cast<uint16_t>(resource_id), &data)) {
+    is_prebuilt = false; // netboxglobal
     if (secondary_locale_resources_data_.get() &&
         secondary_locale_resources_data_->GetStringPiece(
             static_cast<uint16_t>(resource_id), &data)) {
@@ -1161,6 +1300,10 @@ std::u16string ResourceBundle::GetLocalizedStringImpl(int resource_id) { // netb
   } else if (encoding == ResourceHandle::UTF8) {
     msg = base::UTF8ToUTF16(data);
   }
+  // begin netboxglobal
+  if (!is_prebuilt)
+    rebrand(msg, msg);
+  // end netboxglobal
   return MaybeMangleLocalizedString(msg);
 }
 
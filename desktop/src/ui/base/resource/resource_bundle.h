@@ -27,7 +27,7 @@
 #include "ui/gfx/native_widget_types.h"
 
 // begin netboxglobal
-#include "third_party/icu/source/i18n/unicode/regex.h" 
+#include "base/containers/flat_map.h"
 // end netboxglobal
 
 class SkBitmap;
@@ -239,6 +239,13 @@ class COMPONENT_EXPORT(UI_BASE) ResourceBundle {
   // concurrently invoked on another thread.
   std::string ReloadLocaleResources(const std::string& pref_locale);
 
+  // begin netboxglobal
+  // replaces Chrome and Chromium product names by Netbox, false when nothing
+  // is replaced, Google Chrome, Chrome OS, Chrome Web Store, urls, file names
+  // and identifiers are kept
+  static bool rebrand(const std::u16string& src, std::u16string& dst);
+  // end netboxglobal
+
   // Gets image with the specified resource_id from the current module data.
   // Returns a pointer to a shared instance of gfx::ImageSkia. This shared
   // instance is owned by the resource bundle and should not be freed.
@@ -481,25 +488,27 @@ class COMPONENT_EXPORT(UI_BASE) ResourceBundle {
   // If mangling of localized strings is enabled, mangles |str| to make it
   // longer and to add begin and end markers so that any truncation of it is
   // visible and returns the mangled string. If not, returns |str|.
-  std::u16string MaybeMangleLocalizedString(const std::u16string& str); // netboxcomment, remove const
+  std::u16string MaybeMangleLocalizedString(const std::u16string& str) const;
 
   // An internal implementation of |GetLocalizedString()| without setting the
   // flag of whether overriding locale strings is supported to false. We don't
   // update this flag only in |InitDefaultFontList()| which is called earlier
   // than the overriding. This is okay, because the font list doesn't need to be
   // overridden by variations.
-  std::u16string GetLocalizedStringImpl(int resource_id); // netboxcomment, remove const
+  std::u16string GetLocalizedStringImpl(int resource_id) const;
 
   // This pointer is guaranteed to outlive the ResourceBundle instance and may
   // be null.
   Delegate* delegate_;
 
   // begin netboxglobal
-  bool translate(const std::u16string& src, std::u16string& dst);
+  // rebranded strings of the locale pak by resource id, built once the pak is
+  // loaded and only read afterwards, protected by |locale_resources_data_lock_|
+  // as the pak itself
+  void build_rebranded_strings();
 
-  std::unique_ptr<icu::RegexMatcher> re_;
-  std::map<std::u16string, std::u16string> translations_;  
-  // end netboxglobal 
+  std::unique_ptr<const base::flat_map<int, std::u16string>> rebranded_strings_;
+  // end netboxglobal
 
   // Protects |locale_resources_data_|.
   std::unique_ptr<base::Lock> locale_resources_data_lock_;